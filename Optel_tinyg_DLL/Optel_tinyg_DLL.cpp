@@ -9,21 +9,298 @@
 // Rev		Date		By		Description
 // ------	--------- ------	-------------------------------------------------------------------------
 // 1.0		9/19/15		SRG		Original
+//			10/16/26	DV		Builds on Linux against posixcomm.cpp (no DllMain, ports are opened by the caller)
+//			10/16/26	DV		Optional JSON protocol mode ($ej=1, tg_json() or TINYG_JSON=1), replies parsed by tgjson.cpp
+//			10/16/26	DV		Status reports kept in a snapshot by a receive tap, tg_getpos() reads it, tg_getpos_ex()
+//			10/16/26	DV		tg_stream_open/push/drain: gcode streamed with queue report ($qv) flow control
+//			10/16/26	DV		tg_close_ports() stops the async worker (tgasync.cpp)
+//			10/16/26	DV		Connection cache (tgcache.cpp): the last TinyG is tried first, its ranges reused for the same build
+//			10/16/26	DV		tg_open_ports() finds the port with commenum() (TINYG_PORTFILTER), not a powershell dump per port
+//			10/16/26	DV		tg_getranges() answers from a cache filled by one pipelined query when the port is opened
+//			10/16/26	DV		Replies are dispatched to the commands waiting for them (tgdispatch.cpp), several can be in flight
+//			10/16/26	DV		DllMain at process termination doesn't wait for the threads it ended, nor call callbacks
+//			10/16/26	DV		tg_dev_move_async(), tg_dev_home_async(): async requests on a device tg_open() opened
+//			10/16/26	DV		tg_getpos() without status reports fails rather than query TinyG while an async request runs
+//			10/16/26	DV		The reader gathers a reply for up to TG_RXGAP byte times (setrxgap(), TINYG_RXGAP), not a read per byte
+//			10/16/26	DV		The receive tap frames lines a vector at a time (commscan.h), not a byte at a time
+//			10/16/26	DV		Reply lines are scanned once for prompts, errors and stops (commmatch.h), not strstr() each
+//			10/16/26	DV		Call deadlines are tgdeadline_t (tgclock.h), tg_clock() puts in a virtual clock
+//			10/16/26	DV		Reply waits from the measured round trip time, a deadline per call bounds waits and retries (tg_call)
+//			10/16/26	DV		Moves are done on a report with the motors stopped within a tolerance (tg_move_tolerance()), not on its text
+//			10/16/26	DV		Commands built with tgcmd.h (to_chars, no sprintf/strcat), range queries precomputed
+//			10/16/26	DV		4 or 6 motors (TG_AXES, tgaxes.h): MM, the names, parsers and report filter follow the axis set
+//			10/16/26	DV		tg_group_move(): one move over the motors of several boards, released together
+//			10/16/26	DV		Several TinyGs: tg_open() and the tg_dev_ calls, each device keeps its own state (tg_device)
+//			10/16/26	DV		DllMain no longer opens the ports: tg_connect_async() or the first call connects (tgconnect.cpp)
+//			10/16/26	DV		Combined homing (tg_home_combined() or TINYG_HOME_COMBINED=1): one g28.2 for all the motors
 // ======================================================================================================
 
 #include <stdio.h>
-#include <Windows.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
 #include <math.h>
 #include <time.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+#include "portcompat.h"
 
 #include "optel_tinyg_dll.h"
 #include "optel_tinyg_api.h"
+#include "commscan.h"
 #include "critical.h"
 #include "win32comm.h"
 #include "stristr.h"
+#include "tgcache.h"
+#include "tgclock.h"
+#include "tgcmd.h"
+#include "tgdispatch.h"
+#include "tgjson.h"
+#include "tgstatus.h"
+
+#define	STAT_STOP		3														//	TinyG machine states
+#define	STAT_END		4
+
+#define	TG_TOLERANCE	0.0005													//	how close a motor has to get to where it was sent
+#define	TG_RXGAP		8														//	byte times the reader lets a reply gather, setrxgap()
+
+#define	SR_INTERVAL		"100"													//	ms between status reports while anything changes
+#define	SR_INTERVALNS	100000000LL												//	the same, ns
+
+#define	RTT_MIN			20000000LL												//	reply waits, ns: the shortest
+#define	RTT_MAX			1000000000LL											//	the longest, and the wait till a round trip's been timed
+#define	CALL_BUDGET		3000000000LL											//	how long a call without a tosec can take
+
+#define	STREAM_INFLIGHT	4														//	streamed lines sent and not answered yet, TinyG's serial buffer is 254 bytes
+#define	STREAM_RESERVE	4														//	planner buffers left free while streaming
+
+CRITICAL_SECTION cmdio_critical_section[ NUMCOMPORT ];
+
+static int		tg_jsonwant = -1;												//	mode the ports are opened in, -1 until tg_json() or TINYG_JSON says
+static int		tg_homecombined = -1;											//	tg_home() homes its motors in one cycle, -1 until tg_home_combined() or TINYG_HOME_COMBINED says
+static double	tg_tolerance = -1.0;											//	for move completion, -1 until tg_move_tolerance() or TINYG_TOLERANCE says
+static int		tg_rxgap = -1;													//	for setrxgap(), -1 until TINYG_RXGAP says
+
+//	A TinyG board: its port and what we keep about it.  The default device is the one
+//	tg_open_ports() opens and the calls without a device work on, tg_open() opens the others.
+//	Each port has its own reader thread and cmdio() lock, so calls on different devices (from
+//	different threads) run at the same time.
+
+struct tg_device
+{
+	int					port;													//	for portselect(): the COM number - 1, -1 while it's closed
+	bool				jsonmode;												//	TinyG is sending JSON replies ($ej=1)
+
+	//	The machine's state as of the last status report, kept by tg_tap() on the port's reader
+	//	thread.  TinyG sends filtered reports (only what changed) every SR_INTERVAL ms while
+	//	anything changes, and a last one when it stops, so while it's stopped the snapshot stays
+	//	good however old it is.
+
+	tgsnapshot_t		snapshot;
+	bool				subscribed;												//	snapshot is being kept
+
+	//	tg_tap()'s own state, only touched on the reader thread
+
+	struct
+	{
+		char		line[ 300 ];												//	the line being received
+		int			len;
+		tgstatus_t	status;														//	what's been reported so far
+		unsigned	seen;														//	SEEN_ALL bits of status that have been reported
+	} tap;
+
+	//	Motor ranges, asked for when the port is opened and again after a setting is changed
+
+	tg_range_t			ranges[ MM ];
+	bool				rangesknown;
+
+	//	Streaming, see tg_stream_open()
+
+	std::atomic<int>	qr;														//	planner buffers free as of the last queue report, kept by tg_tap()
+
+	//	Commands sent and not answered yet, see tg_send()
+
+	tgdispatch_t		dispatch;
+
+	//	Held by the async worker while it runs a request on the device, see tg_querypos()
+
+	std::recursive_mutex	owner;
+
+	//	Round trip times, see tg_rttsample()
+
+	struct
+	{
+		std::atomic<int64_t>	srtt;											//	smoothed, ns, 0 till the first is timed
+		std::atomic<int64_t>	rttvar;											//	its mean deviation
+	} rtt;
+
+	struct
+	{
+		bool	open;
+		int		inflight;														//	lines sent that haven't been answered
+		int		qrstart;														//	planner buffers free when it was opened
+		bool	failed;															//	a line was refused
+	} stream;
+
+	tg_device() : port( -1 ), jsonmode( false ), subscribed( false ), tap(), rangesknown( false ), qr( -1 ), dispatch(), rtt(), stream() { status_clear( &snapshot ); }
+};
+
+#define	SEEN_STAT		( 1u << MM )
+#define	SEEN_ALL		( tg_axes_t::seen | SEEN_STAT )							//	every position and stat
+
+static tg_device					tg_dev0;									//	the default device
+static thread_local tg_device		*tg_dev = NULL;								//	the device this thread's call is working on, see tg_use
+static tg_device					*tg_devs[ NUMCOMPORT ];						//	the open devices
+static std::mutex					tg_devlock;									//	tg_devs, and finding a TinyG
+static thread_local tgdeadline_t	tg_deadline = { 0 };						//	when this thread's call has to be done, 0 for none, see tg_call
+
+static tgcache_t	tg_cache;													//	the default TinyG, saved for the next open (tgcache.h)
+
+bool tg_async_stop( bool exiting );												//	tgasync.cpp
+bool tg_async_stopping( void );
+void tg_async_drop( tg_device *dev );
+bool tg_ready( bool open );														//	tgconnect.cpp
+void tg_connect_stop( bool exiting );
+
+static void tg_shutdown( bool exiting );
+
+static bool tg_setjson( bool on );
+static bool tg_subscribe( void );
+static bool tg_querypos( double pos[ ] );
+static bool tg_queryranges( tg_range_t *mrange );
+static double tg_fwbuild( void );
+static void tg_setting( const char *cmd );
+
+//	A call works on a device: for as long as it runs the device is the thread's tg_dev and its
+//	port is the thread's selected port.  NULL is the device the thread is already working on (a
+//	call made by another one), else the default device, which is connected first if it has to be
+//	(tg_ready( open )).  ok says whether the device is open.
+
+class tg_use
+{
+public:
+	bool		ok;
+
+	tg_use( tg_device *dev, bool open = true ) : ok( true ), prev( tg_dev )
+	{
+		if ( dev == NULL && ( dev = prev ) == NULL )
+		{
+			dev = &tg_dev0;
+			ok = tg_ready( open );
+		}
+		tg_dev = dev;
+		ok = ok && dev -> port >= 0 && !portselect( dev -> port );
+	}
+
+	~tg_use()
+	{
+		tg_dev = prev;
+		if ( prev != NULL && prev -> port >= 0 ) portselect( prev -> port );
+	}
+
+private:
+	tg_device	*prev;
+};
+
+//	Timeouts.  Each command that gets a reply is timed (tg_rttsample()), and the wait for a reply
+//	comes from what's been seen, the way TCP sets its retransmission timeout: the smoothed round
+//	trip plus four times its mean deviation, between RTT_MIN and RTT_MAX.  A lost command or
+//	reply costs that instead of a second.
+//
+//	A call also has a deadline: tosec for the calls that take one, CALL_BUDGET for the others.
+//	No wait goes past it (tg_within()) and nothing is retried once it's gone (tg_expired()), so
+//	three tries no longer triple a call's worst case.  Calls made by a call keep its deadline.
+
+class tg_call
+{
+public:
+	tg_call( int tosec ) : owner( tg_deadline.at == 0 && tosec >= 0 )
+	{
+		if ( owner ) tg_deadline = tgdeadline_ns( ( tosec > 0 ) ? tosec * 1000000000LL : CALL_BUDGET );
+	}
+
+	~tg_call()
+	{
+		if ( owner ) tg_deadline.at = 0;
+	}
+
+private:
+	bool		owner;															//	it's the outermost call's
+};
+
+//	A reply to a command sent at status_now() time sent has just come.
+
+static void tg_rttsample( int64_t sent )
+{
+	int64_t		r = status_now() - sent, srtt = tg_dev -> rtt.srtt.load(), var = tg_dev -> rtt.rttvar.load();
+
+	if ( srtt == 0 )
+	{
+		srtt = r;
+		var = r / 2;
+	}
+	else
+	{
+		var += ( ( ( r > srtt ) ? r - srtt : srtt - r ) - var ) / 4;
+		srtt += ( r - srtt ) / 8;
+	}
+	tg_dev -> rtt.srtt.store( srtt > 0 ? srtt : 1 );
+	tg_dev -> rtt.rttvar.store( var );
+}
+
+//	timeout (clock() units) cut to what's left of the call's deadline, 0 once it's gone.
+
+static long tg_within( long timeout )
+{
+	long		left;
+
+	if ( tg_deadline.at == 0 ) return( timeout );
+	left = tgdeadline_ticksleft( tg_deadline );
+	return( ( left < timeout ) ? left : timeout );
+}
+
+static bool tg_expired( void )
+{
+	return( tg_deadline.at != 0 && tgdeadline_passed( tg_deadline ) );
+}
+
+//	How long to wait for a reply (clock() units), RTT_MAX till a round trip has been timed.
+
+static int64_t tg_rto( void )
+{
+	int64_t		srtt = tg_dev -> rtt.srtt.load(), rto = srtt + 4 * tg_dev -> rtt.rttvar.load();
+
+	return( ( srtt == 0 || rto > RTT_MAX ) ? RTT_MAX : ( rto < RTT_MIN ) ? RTT_MIN : rto );
+}
+
+static long tg_replywait( void )
+{
+	return( tg_within( (long) ( tg_rto() / TGCLOCK_TICKNS ) ) );
+}
+
+//	How long to wait for the next status report while the machine is moving: they come every
+//	SR_INTERVAL, a few of those and a round trip without one and nothing's coming.
+
+static long tg_reportwait( void )
+{
+	return( tg_within( (long) ( ( 4 * SR_INTERVALNS + tg_rto() ) / TGCLOCK_TICKNS ) ) );
+}
+
+//	The round trip on dev (NULL for the default device) as timed so far, and the reply wait it
+//	gives, in ms.  False if no round trip has been timed yet.
+bool tg_rtt( tg_device *dev, double *rttms, double *waitms )
+{
+	tg_use	use( dev, false );
 
-CRITICAL_SECTION cmdio_critical_section;
+	if ( !use.ok ) return( false );
+	if ( rttms != NULL ) *rttms = tg_dev -> rtt.srtt.load() / 1e6;
+	if ( waitms != NULL ) *waitms = tg_rto() / 1e6;
+	return( tg_dev -> rtt.srtt.load() != 0 );
+}
 
+#ifdef	_WIN32
 BOOL APIENTRY DllMain( HMODULE hModule,
                        DWORD  ul_reason_for_call,
                        LPVOID lpReserved
@@ -34,12 +311,12 @@ BOOL APIENTRY DllMain( HMODULE hModule,
     switch (ul_reason_for_call)
     {
     case DLL_PROCESS_ATTACH:
-		InitializeCriticalSection(&cmdio_critical_section);
+		for ( int i = 0; i < NUMCOMPORT; i ++ ) InitializeCriticalSection( &cmdio_critical_section[ i ] );
 		if ( module == NULL )
 		{
 			module = hModule;
 			printf("Process A\n");
-			return tg_open_ports();
+			return TRUE;													//	connected later, see tgconnect.cpp
 		}
 		else
 		{
@@ -61,20 +338,111 @@ BOOL APIENTRY DllMain( HMODULE hModule,
         {
             //  Close all operations & free all variables
 			printf("Process D\n");
-			tg_close_ports( );
+			tg_shutdown( lpReserved != NULL );									//	set when the process is exiting, its other threads are gone
 			return TRUE;
 		}
 //		else we are not the detach target
-		DeleteCriticalSection(&cmdio_critical_section);
+		for ( int i = 0; i < NUMCOMPORT; i ++ ) DeleteCriticalSection( &cmdio_critical_section[ i ] );
 		break;
     }
 	return FALSE;
 }
+#else
+//	A shared library has no DllMain.  Set up when loaded, and close the ports when unloaded.
+
+__attribute__(( constructor )) static void tg_load( void )
+{
+	for ( int i = 0; i < NUMCOMPORT; i ++ ) InitializeCriticalSection( &cmdio_critical_section[ i ] );
+}
+
+__attribute__(( destructor )) static void tg_unload( void )
+{
+	tg_close_ports( );
+	for ( int i = 0; i < NUMCOMPORT; i ++ ) DeleteCriticalSection( &cmdio_critical_section[ i ] );
+}
+#endif
+
+//	A port named by TINYG_PORT or tg_open(): COMn, or on POSIX systems a device path (the pty
+//	of tools/tgsim for instance).  Sets *port to the port number for portselect().  Returns
+//	false if the name isn't usable.
+
+static bool tg_envport( const char *name, int *port )
+{
+	int		n;
+
+	if ( stristr( (char *) name, (char *) "COM" ) == name && sscanf( name + 3, "%d", &n ) == 1 && n >= 1 && n < MAXCOMPORTNUMBER )
+	{
+		*port = n - 1;
+		return( true );
+	}
+
+#ifndef	_WIN32
+	//	Reuse the COM number it was given before, else take the highest free one
+
+	for ( n = MAXCOMPORTNUMBER - 1; n > 0; n -- )
+		if ( portpath( n ) != NULL && !strcmp( portpath( n ), name ) ) break;
+
+	if ( !n )
+		for ( n = MAXCOMPORTNUMBER - 1; n > 0 && portpath( n ) != NULL; n -- ) ;
+
+	if ( n > 0 && !mapport( n, name ) )
+	{
+		*port = n - 1;
+		return( true );
+	}
+#endif
+
+	printf( "%s isn't a port I can use\n", name );
+	return( false );
+}
+
+//	True if tg_open()'s id names a port (COMn, a device path) rather than being a filter.
+static bool tg_portname( const char *id )
+{
+	return( ( stristr( (char *) id, (char *) "COM" ) == id && isdigit( id[ 3 ] ) ) || strchr( id, '/' ) != NULL );
+}
+
+//	True if another open device has port (tg_devlock held).
+static bool tg_inuse( int port )
+{
+	for ( int i = 0; i < NUMCOMPORT; i ++ )
+		if ( tg_devs[ i ] != NULL && tg_devs[ i ] != tg_dev && tg_devs[ i ] -> port == port ) return( true );
+	return( false );
+}
+
+//	The index (for portselect()) of the port the cache names, found by its USB serial number if
+//	it has one, else by device.  -1 if it isn't among ports.
+static int tg_cacheport( const tgcache_t *c, const commport_t *ports, int n )
+{
+	for ( int i = 0; i < n; i ++ )
+	{
+		if ( ( *c -> serial ) ? !strcmp( ports[ i ].serial, c -> serial ) : !strcmp( ports[ i ].path, c -> path ) )
+			return( ports[ i ].comport - 1 );
+	}
+	return( -1 );
+}
+
+//	Remember the open TinyG, its mode and ranges, for the next tg_open_ports().
+static void tg_cachesave( void )
+{
+	if ( tg_dev != &tg_dev0 || !*tg_cache.path ) return;
+
+	tg_cache.json = tg_dev -> jsonmode;
+	tg_cache.ranges = tg_dev -> rangesknown;
+	memcpy( tg_cache.range, tg_dev -> ranges, sizeof( tg_cache.range ) );
+	if ( !tgcache_save( &tg_cache ) ) printf( "Can't write the connection cache\n" );
+}
 
-BOOL tg_open_ports() {
-	int k = 0, j = 0, i = 0, l = 0;
+//	Find tg_dev's TinyG and open its port.  The default device's is TINYG_PORT, else the cached
+//	one, else the one port matching TINYG_PORTFILTER.  tg_open()'s is the port id names, or the
+//	one matching id as a filter (TINYG_PORTFILTER's if it's NULL) that no other device has open.
+static BOOL tg_find( const char *id ) {
+	int k = 0, i = 0, l = 0, n;
 	char* p, buf[500];
-	int ports[100];
+	commport_t ports[MAXCOMMENUM];
+	tgcache_t cache;
+	bool cached, quick;
+	double build;
 	DCB			prm = { sizeof(prm),		// sizeof(DCB)
 						115200,				// current baud rate 
 						1,					// binary mode, no EOF check
@@ -103,50 +471,85 @@ BOOL tg_open_ports() {
 						0,					// end of input character 
 						0,					// received event character 
 						0 };				// reserved; do not use 
-	if ((i = findserialports(ports)) > 0)
+	cached = tg_dev == &tg_dev0 && tgcache_load(&cache);
+
+find:
+	if (tg_dev == &tg_dev0)
+		p = getenv("TINYG_PORT");
+	else
+		p = (id != NULL && tg_portname(id)) ? (char*)id : NULL;
+
+	if (p != NULL && *p && !tg_envport(p, &l))
+		return FALSE;
+
+	n = commenum(ports, MAXCOMMENUM, NULL);
+
+	if ((p == NULL || !*p) && (!cached || (l = tg_cacheport(&cache, ports, n)) < 0))
 	{
-		k = 0;															//	count of FTDI ports
+		//	No port named and the cached TinyG isn't here: the one serial port matching id or
+		//	TINYG_PORTFILTER (see commenum.h), by default an FTDI adapter
 
-		for (j = 0; j < i; j++)
+		if (id != NULL && *id)
+			p = (char*)id;
+		else if ((p = getenv("TINYG_PORTFILTER")) == NULL || !*p)
+			p = (char*)"FTDI";
+
+		for (i = k = 0, *buf = 0; i < n; i++)
 		{
-			if ((p = (char*)getportinfo((char*)"manufacturer", ports[j])) != NULL)
+			if (commenum_match(&ports[i], p) && !tg_inuse(ports[i].comport - 1))
 			{
-				if (stristr(p, (char*)"FTDI") == p)
-				{
-					k++;
-					l = ports[j] - 1;
-				}
+				k++;
+				l = ports[i].comport - 1;
+				snprintf(buf + strlen(buf), sizeof(buf) - strlen(buf), "%s%s%s", (k > 1) ? ", " : "", (*ports[i].serial) ? "SN " : "", (*ports[i].serial) ? ports[i].serial : ports[i].path);
 			}
 		}
 
 		if (!k)
 		{
-		noport:
 			printf("Sorry, I can't find a TinyG controller to connect with\n");
 			return FALSE;
 		}
 
 		if (k > 1)
 		{
-			printf("There are multiple FTDI serial ports, please unplug the ones not connected to TinyG\n");
+			printf("There are multiple %s serial ports (%s), please open one by its serial number or unplug the ones not connected to TinyG\n", p, buf);
 			return FALSE;
 		}
 	}
-	else
-		goto noport;
+
+	if (tg_inuse(l))
+	{
+		printf("COM-%d is already open\n", l + 1);
+		return FALSE;
+	}
+
+	//	The TinyG we had last time gets a short probe at its last baud rate
+
+	if ((quick = cached && tg_cacheport(&cache, ports, n) == l))
+		prm.BaudRate = cache.baud;
 
 	//int i;
 	if ((i = portselect(l))) {
 		return FALSE;
 	}
+	tg_dev -> port = l;
 	if (setcomprm(&prm))
 	{
 		printf("Can't configure COM-%d\n", l + 1);
 		return FALSE;
 	}
 
-	if (!cmdio((char*)" \r", 10 * CLOCKS_PER_SEC, buf, sizeof(buf), (char*)"\xA"))
+	if (!cmdio((char*)" \r", (quick ? CLOCKS_PER_SEC : 10 * CLOCKS_PER_SEC), buf, sizeof(buf), (char*)"\xA"))
 	{
+		if (quick)
+		{
+			printf("No answer from COM-%d, looking for TinyG\n", l + 1);
+			closeport(l);
+			tg_dev -> port = -1;
+			cached = false;
+			prm.BaudRate = 115200;
+			goto find;
+		}
 		printf("Is TinyG running on COM-%d?\n", l + 1);
 		return FALSE;
 	}
@@ -155,10 +558,14 @@ BOOL tg_open_ports() {
 
 	//	check tinyg configuration
 
-	if (strchr(buf, '{') != NULL)
+	if (tg_jsonwant < 0)
+		tg_jsonwant = (p = getenv("TINYG_JSON")) != NULL && atoi(p) != 0;
+
+	tg_dev -> jsonmode = strchr(buf, '{') != NULL;
+	if (tg_dev -> jsonmode && !tg_jsonwant)
 	{
 		//	JSON report mode is on, turn it off.
-		if (!cmdio((char*)"$ej=0\r", CLOCKS_PER_SEC, buf, sizeof(buf), (char*)"\xA"))
+		if (!tg_setjson(false))
 		{
 			printf("Can't disable JSON reporting\n");
 			return FALSE;
@@ -166,12 +573,156 @@ BOOL tg_open_ports() {
 		else
 			printf("JSON reports off (text reports on)\n");
 	}
+	else if (!tg_dev -> jsonmode && tg_jsonwant)
+	{
+		if (!tg_setjson(true))
+		{
+			printf("Can't enable JSON reporting\n");
+			return FALSE;
+		}
+		else
+			printf("JSON reports on\n");
+	}
+
+	if (!tg_subscribe())
+		printf("No status reports, positions will be asked for\n");
+
+	//	The cached ranges are good if it's the same firmware
+
+	build = tg_fwbuild();
+	if (quick && cache.ranges && build > 0.0 && fabs(build - cache.build) < 0.005)
+	{
+		memcpy(tg_dev -> ranges, cache.range, sizeof(tg_dev -> ranges));
+		tg_dev -> rangesknown = true;
+	}
+	else if (!(tg_dev -> rangesknown = tg_queryranges(tg_dev -> ranges)))
+		printf("No motor ranges, they'll be asked for again\n");
+
+	if (tg_dev == &tg_dev0)
+	{
+		memset(&tg_cache, 0, sizeof(tg_cache));
+		for (i = 0; i < n; i++)
+		{
+			if (ports[i].comport == l + 1)
+			{
+				strcpy(tg_cache.path, ports[i].path);
+				strcpy(tg_cache.serial, ports[i].serial);
+			}
+		}
+		tg_cache.baud = prm.BaudRate;
+		tg_cache.build = build;
+		tg_cachesave();
+	}
 	printf("Hi from Optel_tinyg_DLL , V%.3lf, %02d/%02d/%04d\n", TG_VERSION, RELMO, RELDA, RELYR);
 	return TRUE;
 }
 
+//	Open dev: tg_find() its TinyG, and add it to tg_devs.  Opens are made one at a time.
+static bool tg_opendev( tg_device *dev, const char *id )
+{
+	std::lock_guard<std::mutex>	l( tg_devlock );
+	tg_device					*prev = tg_dev;
+	int							i;
+	bool						ok;
+
+	for ( i = 0; i < NUMCOMPORT && tg_devs[ i ] != NULL && tg_devs[ i ] != dev; i ++ ) ;
+	if ( i >= NUMCOMPORT )
+	{
+		printf( "Too many TinyG devices\n" );
+		return( false );
+	}
+
+	tg_dev = dev;
+	if ( ( ok = tg_find( id ) ) )
+		tg_devs[ i ] = dev;
+	else
+		if ( dev -> port >= 0 )
+		{
+			closeport( dev -> port );
+			dev -> port = -1;
+		}
+	tg_dev = prev;
+	return( ok );
+}
+
+//	Close dev's port and forget it.
+static void tg_closedev( tg_device *dev )
+{
+	std::lock_guard<std::mutex>	l( tg_devlock );
+
+	for ( int i = 0; i < NUMCOMPORT; i ++ )
+		if ( tg_devs[ i ] == dev ) tg_devs[ i ] = NULL;
+
+	if ( dev -> port >= 0 ) closeport( dev -> port );
+	dev -> port = -1;
+	tgdispatch_clear( &dev -> dispatch );
+	dev -> subscribed = false;
+	dev -> rangesknown = false;
+	dev -> stream.open = false;
+}
+
+//	Open the default device (tg_open_ports(), tg_connect_async() or the first call that talks to
+//	it, see tgconnect.cpp).  Not while a request from before tg_close_ports() still has its port,
+//	which is closed first if that request left it open.
+BOOL tg_connect( void )
+{
+	if ( tg_async_stopping() )
+	{
+		printf( "A motion request from before the ports were closed is still running\n" );
+		return( FALSE );
+	}
+	if ( tg_dev0.port >= 0 ) tg_closedev( &tg_dev0 );
+	return( tg_opendev( &tg_dev0, NULL ) );
+}
+
+//	Close the default device a connect abandoned by tg_connect_stop() opened after all.
+void tg_disconnect( void )
+{
+	tg_closedev( &tg_dev0 );
+}
+
+//	Stop connecting and the async worker, and close the default device.  exiting is process
+//	termination (DllMain()), when the other threads have been terminated: nothing is waited for
+//	and no callbacks are called.  Nor is the device closed, a terminated thread may have held
+//	tg_devlock, and the handles go with the process.
+static void tg_shutdown( bool exiting )
+{
+	tg_connect_stop( exiting );
+	if ( tg_async_stop( exiting ) )
+	{
+		if ( !exiting ) tg_closedev( &tg_dev0 );
+	}
+	else
+		printf( "A motion request is still running, TinyG's port is left open\n" );
+}
+
 void tg_close_ports() {
-	closeports();
+	tg_shutdown( false );
+}
+
+//	Open another TinyG.  id is its port (COMn, or a device path on POSIX systems), or a filter
+//	(see commenum.h) matching its port and no other that isn't open already: "SN D30A" for the
+//	FTDI adapter with that serial number, NULL for the next TINYG_PORTFILTER (FTDI) port.
+//	Returns the device to hand the tg_dev_ calls, NULL if it can't be opened.
+tg_device *tg_open( const char *id )
+{
+	tg_device	*dev = new tg_device;
+
+	if ( tg_opendev( dev, id ) ) return( dev );
+
+	delete dev;
+	return( NULL );
+}
+
+//	Close a device tg_open() opened, once no calls on it are running.  Its async requests that
+//	haven't run fail, one that's running is waited for.
+void tg_close( tg_device *dev )
+{
+	if ( dev == NULL || dev == &tg_dev0 ) return;
+
+	tg_async_drop( dev );
+	tg_closedev( dev );
+	delete dev;
 }
 
 double  tg_version( void )
@@ -179,108 +730,773 @@ double  tg_version( void )
     return( TG_VERSION );
 }
 
+int tg_axes( void )
+{
+	return( MM );
+}
+
 const char *tg_mname[ MM ] =
 {
 	(const char *) "x",
 	(const char *) "y",
 	(const char *) "z",
 	(const char *) "a",
+#if	MM > 4
+	(const char *) "b",
+	(const char *) "c",
+#endif
 };
 
-//	Return 4 motor positions.
-bool tg_getpos( double pos[ ] )
+//	A status report value into dev's tap state: posx..posa (..posc), vel or stat.
+
+static void tg_tapvalue( tg_device *dev, std::string_view name, double value )
 {
-	char	buf[ 300 ];
-	int		i = 0;
-	int		retry;
+	int		i;
 
-	for ( retry = 0; retry < 3; retry ++ )
+	if ( name.size() == 4 && name.substr( 0, 3 ) == "pos" )
 	{
-		printf( "getpos(" );
-		i = 0;
-
-		if ( !cmdio( (char *) "?\r", CLOCKS_PER_SEC, buf, sizeof( buf ), (char *) "\xA" ) )
+		if ( ( i = tg_axes_t::of( name[ 3 ] ) ) >= 0 )
 		{
-			printf( "getpos: no reply\ngetpos(" );
-			break;
+			dev -> tap.status.pos[ i ] = value;
+			dev -> tap.seen |= 1 << i;
 		}
-
-		//	X position:          0.000 mm
-		//	Y position :         0.000 mm
-		//	Z position :         0.000 mm
-		//	A position :         0.000 deg
-		//	Feed rate:           0.000 mm / min
-		//	Velocity:            0.000 mm / min
-		//	Units:            G21 - millimeter mode
-		//	Coordinate system : G54 - coordinate system 1
-		//	Distance mode : G90 - absolute distance mode
-		//	Feed rate mode : G94 - units - per - minute mode( i.e.feedrate mode )
-		//	Machine state : Stop
-		//	tinyg [mm] ok >
-
-		do
-		{
-			if ( i < 4 )
+	}
+	else
+		if ( name == "vel" )
+			dev -> tap.status.vel = value;
+		else
+			if ( name == "stat" )
 			{
-				if ( tolower( *buf ) == *tg_mname[ i ] )
-				{
-					if ( sscanf( buf + 15, "%lf", pos + i ) != 1 )
-					{
-						//	convert error
-						break;
-					}
-					else
-					{
-						printf( "%s%.3lf%s", tg_mname[ i ], *( pos + i ), ( i >= 3 ) ? ") OK\n" : "," );
-						i ++;
-					}
-				}
-				else
-				{
-					printf( "Wrong motor %s\n", buf );
-					break;
-				}
+				dev -> tap.status.stat = (int) value;
+				dev -> tap.seen |= SEEN_STAT;
 			}
-			else
-				if ( strstr( buf, "tinyg [mm" ) != NULL ) return( i >= 4 );
-		}
-		while ( cmdio( (char *) "", CLOCKS_PER_SEC, buf, sizeof( buf ), (char *) "\xA", false ) );
-	}	//	retry
-
-	return( false );
 }
 
-//	Home up to 4 motors.
-//	True on success
-bool tg_home( bool home[ MM ], int tosec )
+//	A text mode line: status and queue reports, and the lines of the ? report.  True at the end
+//	of a status report.
+
+static bool tg_taptext( tg_device *dev, char *line )
 {
-	char	buf[ 300 ];
-	int		i = 0, j = 0;
-	int		retry;
-	double	pos[ MM ];
+	static const char	*state[ 10 ] = { "Initializing", "Ready", "Alarm", "Stop", "End", "Run", "Hold", "Probe", "Cycle", "Homing" };
+	char				*p, *q, name[ 8 ];
 
-	for ( i = 0; i < 4; i ++ )													//	for each possible motor
+	if ( !strncmp( line, "qr:", 3 ) )
 	{
-		if ( home[ i ] )														//	if we're to home it
-		{
-			for ( retry = 0; retry < 3; retry ++ )								//	try 3 times
-			{
-				printf( "home(%s) ", tg_mname[ i ] );
+		dev -> qr.store( atoi( line + 3 ) );										//	qr:27
+		return( false );
+	}
+
+	if ( !strncmp( line, "pos", 3 ) || !strncmp( line, "vel:", 4 ) || !strncmp( line, "stat:", 5 ) )
+	{
+		for ( p = line; p != NULL && ( q = strchr( p, ':' ) ) != NULL; p = ( ( p = strchr( q, ',' ) ) != NULL ) ? p + 1 : NULL )
+			tg_tapvalue( dev, std::string_view( p, q - p ), atof( q + 1 ) );
+		return( true );
+	}
+
+	if ( *line && !strncmp( line + 1, " position:", 10 ) )
+	{
+		//	X position:          0.000 mm
+
+		sprintf( name, "pos%c", tolower( *line ) );
+		tg_tapvalue( dev, name, atof( line + 11 ) );
+		return( false );
+	}
+
+	if ( !strncmp( line, "Velocity:", 9 ) )
+	{
+		tg_tapvalue( dev, "vel", atof( line + 9 ) );
+		return( false );
+	}
+
+	if ( !strncmp( line, "Machine state:", 14 ) )
+	{
+		//	Machine state:      Stop, the last line of the ? report
+
+		for ( p = line + 14; *p == ' '; p ++ ) ;
+		for ( int i = 0; i < 10; i ++ )
+			if ( !strncmp( p, state[ i ], strlen( state[ i ] ) ) ) tg_tapvalue( dev, "stat", i );
+		return( true );
+	}
+
+	return( false );
+}
+
+//	A received line.  Status reports come as
+//
+//		{"sr":{"posx":10.000,"vel":6000.000,"stat":5}}			JSON
+//		posx:10.000,vel:6000.000,stat:5							text
+//
+//	and the replies to {"sr":null}, {"pos":null} and ? are full reports.  Publishes the snapshot
+//	at the end of a report once every position and the state have been reported.  Queue reports
+//	go to dev -> qr.
+
+static void tg_tapline( tg_device *dev, char *line, int len, int64_t ns )
+{
+	tgjson_t	j;
+	bool		report = false;
+	char		name[ 8 ];
+
+	if ( *line == '{' )
+	{
+		if ( !tgjson_parse( std::string_view( line, len ), &j ) ) return;
+
+		for ( int i = 0; i < j.npairs; i ++ )
+		{
+			const tgjson_pair_t	*pair = &j.pair[ i ];
+
+			if ( !pair -> number ) continue;
+
+			if ( ( j.kind == TGJSON_QR || j.kind == TGJSON_R ) && pair -> group.empty() && pair -> name == "qr" )
+			{
+				dev -> qr.store( (int) pair -> value );								//	{"qr":27} report, or the reply to {"qr":null}
+				continue;
+			}
+
+			if ( ( j.kind == TGJSON_SR && pair -> group.empty() ) || ( j.kind == TGJSON_R && pair -> group == "sr" ) )
+			{
+				tg_tapvalue( dev, pair -> name, pair -> value );
+				report = true;
+			}
+			else
+				if ( j.kind == TGJSON_R && pair -> group == "pos" && pair -> name.size() == 1 )
+				{
+					sprintf( name, "pos%c", pair -> name[ 0 ] );
+					tg_tapvalue( dev, name, pair -> value );
+					report = true;
+				}
+		}
+	}
+	else
+		report = tg_taptext( dev, line );
+
+	if ( report && dev -> tap.seen == SEEN_ALL )
+	{
+		dev -> tap.status.ns = ns;
+		status_publish( &dev -> snapshot, &dev -> tap.status );
+	}
+}
+
+//	The port's receive tap: runs on the reader thread with each block received, before the DLL's
+//	own reads can see it, so the snapshot is never behind a reply we've read.
+
+static void tg_tap( const unsigned char *block, int n, void *ctx )
+{
+	static const scanset_t	eol = []
+	{
+		scanset_t	s;
+
+		scan_set( &s, "\r\n", 2 );
+		return( s );
+	}();
+	tg_device	*dev = (tg_device *) ctx;
+	int64_t		ns = status_now();
+	int			i, k, room;
+
+	for ( i = 0; i < n; i = k + 1 )
+	{
+		//	The rest of the line, all at once (commscan.h)
+
+		k = i + (int) scan_find( &eol, block + i, n - i );
+		room = (int) sizeof( dev -> tap.line ) - 1 - dev -> tap.len;
+		if ( room > k - i ) room = k - i;
+		memcpy( dev -> tap.line + dev -> tap.len, block + i, room );
+		dev -> tap.len += room;
+
+		if ( k < n && dev -> tap.len )
+		{
+			dev -> tap.line[ dev -> tap.len ] = 0;
+			tg_tapline( dev, dev -> tap.line, dev -> tap.len, ns );
+			dev -> tap.len = 0;
+		}
+	}
+}
+
+//	Replies go through the device's dispatcher (tgdispatch.h): a command is sent as a request
+//	(tg_send()), lines are read and handed to the requests they answer (tg_pump()), and the
+//	caller waits for the answers it's after (tg_await()).  Commands sent together are answered
+//	in turn, one round trip for all of them.
+
+//	What a tg_replied() request (or several) got: how many were answered, how many of those were
+//	refused, and the last answer into buf (if it isn't NULL), j parsed from buf in JSON.  Each
+//	line, the echoes and answers, goes to each( ctx ) first if there's an each.
+
+typedef struct
+{
+	int			answered;
+	int			failed;
+	char		*buf;
+	int			size;
+	tgjson_t	*j;
+	tgreq_fn	each;
+	void		*ctx;
+} tg_reply_t;
+
+static void tg_replied( void *ctx, tgline_kind_t kind, const char *line, const tgjson_t *j )
+{
+	tg_reply_t	*r = (tg_reply_t *) ctx;
+
+	if ( r -> each != NULL && kind != TGLINE_NONE ) r -> each( r -> ctx, kind, line, j );
+	if ( !tgline_answer( kind ) ) return;
+
+	r -> answered ++;
+	if ( kind == TGLINE_ERROR ) r -> failed ++;
+	if ( r -> buf == NULL ) return;
+
+	snprintf( r -> buf, r -> size, "%s", line );
+	if ( r -> j != NULL && !tgjson_parse( r -> buf, r -> j ) ) r -> j -> kind = TGJSON_NONE;
+}
+
+//	Expect an answer for fn( ctx ) to a command that's going out (or has).  A round trip is timed
+//	from now if timed, and nothing else is waiting to be answered to hold it up.  False if too
+//	many are waiting.
+
+static bool tg_expect( tgreq_fn fn, void *ctx, bool timed )
+{
+	int64_t		sent = ( timed && tgdispatch_pending( &tg_dev -> dispatch ) == 0 ) ? status_now() : 0;
+
+	return( tgdispatch_push( &tg_dev -> dispatch, fn, ctx, sent ) );
+}
+
+//	Send len bytes of cmd, the answer goes to fn( ctx ).
+
+static bool tg_send( const char *cmd, int len, tgreq_fn fn, void *ctx, bool timed = true )
+{
+	if ( !tg_expect( fn, ctx, timed ) )
+	{
+		printf( "Too many commands waiting for answers\n" );
+		return( false );
+	}
+
+	tg_setting( cmd );
+	outcoms( (char *) cmd, (unsigned long) len );
+	return( true );
+}
+
+//	Read a line into buf, waiting up to timeout, and dispatch it.  *kind says what it was, j has
+//	it parsed in JSON.  False on a timeout.
+
+static bool tg_pump( long timeout, char *buf, int size, tgjson_t *j, tgline_kind_t *kind )
+{
+	tgreq_t		done;
+
+	if ( !cmdio( (char *) "", timeout, buf, size, (char *) "\xA", false ) ) return( false );
+
+	*kind = tgline_classify( buf, j );
+	if ( tgdispatch_route( &tg_dev -> dispatch, *kind, buf, j, &done ) && done.sent != 0 ) tg_rttsample( done.sent );
+	return( true );
+}
+
+//	Dispatch what's already come in.
+
+static void tg_drain( void )
+{
+	char			buf[ 300 ];
+	tgjson_t		j;
+	tgline_kind_t	kind;
+
+	while ( charin() > 0 && tg_pump( CLOCKS_PER_SEC / 10, buf, sizeof( buf ), &j, &kind ) ) ;
+}
+
+//	Wait for n answers to r, up to timeout between lines.  True once they're in and none was
+//	refused.  On a timeout the answers that are still owed are dropped, a late one can't be told
+//	from the answer to the next command.
+
+static bool tg_await( tg_reply_t *r, int n, long timeout )
+{
+	char			buf[ 300 ];
+	tgjson_t		j;
+	tgline_kind_t	kind;
+
+	while ( r -> answered < n )
+	{
+		if ( !tg_pump( timeout, buf, sizeof( buf ), &j, &kind ) )
+		{
+			tgdispatch_clear( &tg_dev -> dispatch );
+			return( false );
+		}
+	}
+	return( r -> failed == 0 );
+}
+
+//	Send n commands together and wait for all of their answers.  True if none was refused.
+
+static bool tg_commands( const char *const cmds[ ], int n )
+{
+	char		buf[ 300 ];
+	tg_reply_t	r = { 0, 0, buf, sizeof( buf ), NULL };
+
+	for ( int i = 0; i < n; i ++ )
+	{
+		if ( !tg_send( cmds[ i ], (int) strlen( cmds[ i ] ), tg_replied, &r ) )
+		{
+			tg_await( &r, i, tg_replywait() );
+			return( false );
+		}
+	}
+
+	if ( tg_await( &r, n, tg_replywait() ) ) return( true );
+	if ( r.failed ) printf( "TinyG error: %s\n", buf );
+	return( false );
+}
+
+//	Send a JSON command and wait for its {"r":...} response, which j gets.  True if the
+//	response's footer is good and its status is 0.
+
+static bool tg_jsoncmd( const char *cmd, long timeout, char *buf, int size, tgjson_t *j )
+{
+	tg_reply_t	r = { 0, 0, buf, size, j };
+
+	j -> kind = TGJSON_NONE;
+	if ( !tg_send( cmd, (int) strlen( cmd ), tg_replied, &r ) ) return( false );
+	if ( tg_await( &r, 1, timeout ) ) return( true );
+
+	if ( r.answered )
+	{
+		if ( !j -> checksum )
+			printf( "JSON checksum error: %s\n", buf );
+		else
+			printf( "TinyG error %d: %s\n", ( j -> nf >= 2 ) ? j -> f[ 1 ] : -1, buf );
+	}
+	return( false );
+}
+
+//	Send a text mode command and wait for the prompt.  False on a timeout or an error reply.
+
+static bool tg_textcmd( const char *cmd, char *buf, int size )
+{
+	tg_reply_t	r = { 0, 0, buf, size, NULL };
+
+	if ( !tg_send( cmd, (int) strlen( cmd ), tg_replied, &r ) ) return( false );
+	if ( tg_await( &r, 1, tg_replywait() ) ) return( true );
+
+	if ( r.answered ) printf( "TinyG error: %s\n", buf );
+	return( false );
+}
+
+//	$fb's echo, [fb]  firmware build            440.20, into the double ctx.
+static void tg_fbecho( void *ctx, tgline_kind_t kind, const char *line, const tgjson_t *j )
+{
+	const char	*p;
+
+	if ( kind == TGLINE_ECHO && !strncmp( line, "[fb]", 4 ) && ( p = strpbrk( line + 4, "0123456789" ) ) != NULL ) *(double *) ctx = atof( p );
+}
+
+//	The firmware build ($fb), 0 if TinyG doesn't say.
+static double tg_fwbuild( void )
+{
+	char		buf[ 300 ];
+	tgjson_t	j;
+	double		build = 0.0;
+
+	if ( tg_dev -> jsonmode )
+	{
+		if ( !tg_jsoncmd( "{\"fb\":null}\n", tg_replywait(), buf, sizeof( buf ), &j ) || !tgjson_number( &j, "fb", &build ) ) return( 0.0 );
+		return( build );
+	}
+
+	tg_reply_t	r = { 0, 0, NULL, 0, NULL, tg_fbecho, &build };					//	the echo, then the prompt
+
+	if ( !tg_send( "$fb\r", 4, tg_replied, &r ) || !tg_await( &r, 1, tg_replywait() ) ) return( 0.0 );
+	return( build );
+}
+
+//	Turn JSON reporting on or off.
+
+static bool tg_setjson( bool on )
+{
+	char		buf[ 300 ];
+	tgjson_t	j;
+
+	if ( on )
+	{
+		if ( !tg_jsoncmd( "$ej=1\r", tg_replywait(), buf, sizeof( buf ), &j ) ) return( false );
+		tg_dev -> jsonmode = true;
+		return( true );
+	}
+
+	//	The reply is text once it's off: [ej] enable json mode 0 [0=text,1=JSON], then the prompt
+
+	tg_dev -> jsonmode = false;
+	return( tg_textcmd( "$ej=0\r", buf, sizeof( buf ) ) );
+}
+
+//	Have TinyG send filtered status reports of the positions, velocity and state ($sv=1, $si), and
+//	keep tg_dev -> snapshot from them.  A full report is asked for first to start the snapshot off (the
+//	JSON move and home waits use it even without the subscription).  Text mode can't set the
+//	report's fields ($sr is JSON only), TinyG's default report has the ones we use.  The
+//	settings go out together.
+
+static bool tg_subscribe( void )
+{
+	static const char	*setup[ 4 ] =
+	{
+		"{\"sr\":null}\n",
+		"{\"sv\":1}\n",
+		"{\"si\":" SR_INTERVAL "}\n",
+		tg_axes_t::srfilter.data(),
+	};
+	static const char	*textsetup[ 2 ] = { "$sv=1\r", "$si=" SR_INTERVAL "\r" };
+	tgstatus_t			s;
+	double				pos[ MM ];
+	char				*p;
+
+	tg_dev -> subscribed = false;
+	setrxtap( NULL, NULL );
+	tg_dev -> tap.len = 0;
+	tg_dev -> tap.seen = 0;
+	status_clear( &tg_dev -> snapshot );
+	setrxtap( tg_tap, tg_dev );
+
+	if ( tg_rxgap < 0 )
+		tg_rxgap = ( ( p = getenv( "TINYG_RXGAP" ) ) != NULL ) ? atoi( p ) : TG_RXGAP;
+	setrxgap( tg_rxgap );
+
+	if ( tg_dev -> jsonmode )
+	{
+		if ( !tg_commands( setup, 4 ) ) return( false );
+	}
+	else
+	{
+		if ( !tg_querypos( pos ) || !tg_commands( textsetup, 2 ) ) return( false );
+	}
+
+	tg_dev -> subscribed = status_read( &tg_dev -> snapshot, &s );
+	return( tg_dev -> subscribed );
+}
+
+//	Use the JSON protocol (or not) from now on, and switch an open port over.
+bool tg_json( bool on )
+{
+	tg_use		use( NULL, false );
+	tg_call		call( 0 );
+
+	tg_jsonwant = on;
+	if ( !use.ok || tg_dev -> jsonmode == on ) return( true );					//	a port opened later gets it
+
+	if ( !tg_setjson( on ) )
+	{
+		printf( "Can't %s JSON reporting\n", ( on ) ? "enable" : "disable" );
+		return( false );
+	}
+	return( true );
+}
+
+//	tg_querypos() in JSON mode: {"pos":null} gets {"r":{"pos":{"x":0.000,"y":0.000,...}},"f":[...]}
+static bool tg_getpos_json( double pos[ ] )
+{
+	char		buf[ 300 ];
+	tgjson_t	j;
+	int			i;
+
+	for ( int retry = 0; retry < 3 && !tg_expired(); retry ++ )
+	{
+		printf( "getpos(" );
+
+		if ( !tg_jsoncmd( "{\"pos\":null}\n", tg_replywait(), buf, sizeof( buf ), &j ) )
+		{
+			printf( "getpos: no reply\n" );
+			continue;
+		}
+
+		for ( i = 0; i < MM && tgjson_number( &j, tg_mname[ i ], pos + i, "pos" ); i ++ )
+			printf( "%s%.3lf%s", tg_mname[ i ], pos[ i ], ( i >= MM - 1 ) ? ") OK\n" : "," );
+
+		if ( i >= MM ) return( true );
+		printf( "Wrong motor %s\n", buf );
+	}	//	retry
+
+	return( false );
+}
+
+//	Motor positions from the last status report, nothing is sent to TinyG.  *agems (if agems isn't
+//	NULL) gets the report's age in ms.  Without status reports TinyG is asked, and the age is 0.
+bool tg_getpos_ex( double pos[ MM ], double *agems )
+{
+	tg_use		use( NULL );
+	tg_call		call( 0 );
+	tgstatus_t	s;
+
+	if ( !use.ok ) return( false );
+
+	if ( tg_dev -> subscribed && status_read( &tg_dev -> snapshot, &s ) )
+	{
+		memcpy( pos, s.pos, sizeof( s.pos ) );
+		if ( agems != NULL ) *agems = ( status_now() - s.ns ) / 1e6;
+		return( true );
+	}
+
+	if ( agems != NULL ) *agems = 0.0;
+	return( tg_querypos( pos ) );
+}
+
+//	Return the MM motor positions.
+bool tg_getpos( double pos[ ] )
+{
+	tg_use		use( NULL );
+	tg_call		call( 0 );
+	tgstatus_t	s;
+
+	if ( !use.ok ) return( false );
+	if ( !tg_dev -> subscribed || !status_read( &tg_dev -> snapshot, &s ) ) return( tg_querypos( pos ) );
+
+	memcpy( pos, s.pos, sizeof( s.pos ) );
+	printf( "getpos(" );
+	for ( int i = 0; i < MM; i ++ )
+		printf( "%s%.3lf%s", tg_mname[ i ], pos[ i ], ( i >= MM - 1 ) ? ") OK\n" : "," );
+	return( true );
+}
+
+//	The ? report's position lines into a tg_posreport_t, in motor order.
+typedef struct
+{
+	double		*pos;
+	int			n;																//	motors read
+	bool		wrong;															//	a line wasn't the next motor's
+} tg_posreport_t;
+
+static void tg_posline( void *ctx, tgline_kind_t kind, const char *line, const tgjson_t *j )
+{
+	tg_posreport_t	*r = (tg_posreport_t *) ctx;
+
+	if ( kind != TGLINE_OTHER || r -> n >= MM || r -> wrong ) return;
+
+	if ( tolower( *line ) != *tg_mname[ r -> n ] || sscanf( line + 15, "%lf", r -> pos + r -> n ) != 1 )
+	{
+		printf( "Wrong motor %s\n", line );
+		r -> wrong = true;
+		return;
+	}
+	printf( "%s%.3lf%s", tg_mname[ r -> n ], r -> pos[ r -> n ], ( r -> n >= MM - 1 ) ? ") OK\n" : "," );
+	r -> n ++;
+}
+
+//	Ask TinyG for the MM motor positions.  Not while the async worker (tgasync.cpp) is running a
+//	request on the device: the command and its answer would cross the worker's.  The worker's own
+//	calls can (owner is recursive), and the worker doesn't start one on the device meanwhile.
+static bool tg_askpos( double pos[ ] );
+
+static bool tg_querypos( double pos[ ] )
+{
+	bool	ok;
+
+	if ( !tg_dev -> owner.try_lock() )
+	{
+		printf( "getpos: no status reports, and a motion request is running\n" );
+		return( false );
+	}
+	ok = tg_askpos( pos );
+	tg_dev -> owner.unlock();
+	return( ok );
+}
+
+static bool tg_askpos( double pos[ ] )
+{
+	tg_posreport_t	report;
+	tg_reply_t		r;
+
+	if ( tg_dev -> jsonmode ) return( tg_getpos_json( pos ) );
+
+	for ( int retry = 0; retry < 3 && !tg_expired(); retry ++ )
+	{
+		printf( "getpos(" );
+
+		//	X position:          0.000 mm
+		//	Y position :         0.000 mm
+		//	Z position :         0.000 mm
+		//	A position :         0.000 deg
+		//	Feed rate:           0.000 mm / min
+		//	Velocity:            0.000 mm / min
+		//	Units:            G21 - millimeter mode
+		//	Coordinate system : G54 - coordinate system 1
+		//	Distance mode : G90 - absolute distance mode
+		//	Feed rate mode : G94 - units - per - minute mode( i.e.feedrate mode )
+		//	Machine state : Stop
+		//	tinyg [mm] ok >
+
+		report = tg_posreport_t{ pos, 0, false };
+		r = tg_reply_t{ 0, 0, NULL, 0, NULL, tg_posline, &report };
+
+		if ( !tg_send( "?\r", 2, tg_replied, &r ) || !tg_await( &r, 1, tg_replywait() ) )
+		{
+			printf( "getpos: no reply\ngetpos(" );
+			break;
+		}
+		if ( report.n >= MM ) return( true );
+	}	//	retry
+
+	return( false );
+}
+
+//	tg_home() in JSON mode: {"gc":"g28.2 x0"} for each motor, it's home when a status report says stat 3.
+static bool tg_home_json( bool home[ MM ], int tosec, double pos[ MM ] )
+{
+	char			buf[ 300 ];
+	tgcmd_t			cmd;
+	tgjson_t		j;
+	tgline_kind_t	kind;
+	double			stat;
+
+	for ( int i = 0; i < MM; i ++ )
+	{
+		if ( !home[ i ] ) continue;
+
+		for ( int retry = 0; ; retry ++ )
+		{
+			if ( retry >= 3 || tg_expired() ) return( false );					//	didn't home in 3 tries
+
+			stat = 0.0;															//	this g28.2's stop, not the last motor's
+			printf( "home(%s) ", tg_mname[ i ] );
+			tgcmd_gcode( &cmd, true );
+			tgcmd_put( &cmd, "g28.2" );
+			tgcmd_axis( &cmd, *tg_mname[ i ], 0.0 );
+			tgcmd_end( &cmd, true );
+
+			if ( !tg_jsoncmd( cmd.line, tg_replywait(), buf, sizeof( buf ), &j ) ) continue;
+
+			while ( tg_pump( tg_within( tosec * CLOCKS_PER_SEC ), buf, sizeof( buf ), &j, &kind ) )
+				if ( kind == TGLINE_SR && tgjson_number( &j, "stat", &stat ) && (int) stat == STAT_STOP ) break;
+
+			if ( (int) stat == STAT_STOP )
+			{
+				printf( "OK\n" );
+				break;
+			}
+		}	//	for retry
+	}	//	for each possible motor
+
+	return( tg_getpos( pos ) );
+}
+
+//	tg_home() in one homing cycle: a single g28.2 naming every motor to home, done when a status
+//	report says stat 3.  The positions to verify are that report's (the snapshot), they're only
+//	asked for if there are no status reports.
+static bool tg_home_all( bool home[ MM ], int tosec, double pos[ MM ] )
+{
+	char			buf[ 300 ];
+	tgcmd_t			cmd;
+	tgjson_t		j;
+	tgline_kind_t	kind;
+	double			stat = 0.0;
+	int				i, n;
+
+	for ( int retry = 0; retry < 3 && !tg_expired(); retry ++ )
+	{
+		printf( "home(" );
+
+		tgcmd_gcode( &cmd, tg_dev -> jsonmode );
+		tgcmd_put( &cmd, "g28.2" );
+		for ( i = n = 0; i < MM; i ++ )
+		{
+			if ( home[ i ] )
+			{
+				printf( "%s%s", ( n ++ ) ? "," : "", tg_mname[ i ] );
+				tgcmd_axis( &cmd, *tg_mname[ i ], 0.0 );
+			}
+		}
+
+		if ( !n )
+		{
+			printf( ") OK\n" );
+			return( tg_getpos_ex( pos, NULL ) );									//	no motors homing, success
+		}
+
+		tgcmd_end( &cmd, tg_dev -> jsonmode );
+		printf( ") " );
+
+		if ( tg_dev -> jsonmode )
+		{
+			if ( !tg_jsoncmd( cmd.line, tg_replywait(), buf, sizeof( buf ), &j ) ) continue;
+
+			while ( tg_pump( tg_within( tosec * CLOCKS_PER_SEC ), buf, sizeof( buf ), &j, &kind ) )
+				if ( kind == TGLINE_SR && tgjson_number( &j, "stat", &stat ) && (int) stat == STAT_STOP ) break;
+		}
+		else
+		{
+			if ( !tg_textcmd( cmd.line, buf, sizeof( buf ) ) ) continue;
+
+			while ( tg_pump( tg_within( tosec * CLOCKS_PER_SEC ), buf, sizeof( buf ), &j, &kind ) )
+			{
+				if ( kind == TGLINE_SR && ( tgline_marks( buf ) & TGMARK_STOP ) )
+				{
+					stat = STAT_STOP;
+					break;
+				}
+			}
+		}
+
+		if ( (int) stat == STAT_STOP )
+		{
+			printf( "OK\n" );
+			return( tg_getpos_ex( pos, NULL ) );
+		}
+		printf( "error\n" );
+	}	//	retry
+
+	return( false );															//	didn't home in 3 tries
+}
+
+//	Home motors one at a time (the default), or all in one cycle.
+void tg_home_combined( bool on )
+{
+	tg_homecombined = on;
+}
+
+//	Home up to MM motors.
+//	True on success
+bool tg_home( bool home[ MM ], int tosec )
+{
+	tg_use			use( NULL );
+	tg_call			call( tosec );
+	char			buf[ 300 ], *p;
+	tgcmd_t			cmd;
+	tgjson_t		j;
+	tgline_kind_t	kind;
+	int				i = 0;
+	int				retry;
+	double			pos[ MM ];
+
+	if ( !use.ok ) return( false );
+
+	if ( tg_homecombined < 0 )
+		tg_homecombined = ( p = getenv( "TINYG_HOME_COMBINED" ) ) != NULL && atoi( p ) != 0;
+
+	if ( tg_homecombined )
+	{
+		if ( !tg_home_all( home, tosec, pos ) ) return( false );
+		goto verify;
+	}
+
+	if ( tg_dev -> jsonmode )
+	{
+		if ( !tg_home_json( home, tosec, pos ) ) return( false );
+		goto verify;
+	}
+
+	for ( i = 0; i < MM; i ++ )													//	for each possible motor
+	{
+		if ( home[ i ] )														//	if we're to home it
+		{
+			for ( retry = 0; retry < 3 && !tg_expired(); retry ++ )				//	try 3 times
+			{
+				printf( "home(%s) ", tg_mname[ i ] );
 
 				//	Build the home command by listing the motors we've been asked to home.
-				//	printf(buf, "g28.2 %s0\r", tg_mname[i]);
-				sprintf( buf, "g28.2 %s0\r", tg_mname[ i ] );
+				tgcmd_gcode( &cmd, false );
+				tgcmd_put( &cmd, "g28.2" );
+				tgcmd_axis( &cmd, *tg_mname[ i ], 0.0 );
+				tgcmd_end( &cmd, false );
 
 				//	Send the home command g29.2 axis0
 
-				while ( cmdio( buf, CLOCKS_PER_SEC / 2, buf, sizeof( buf ), (char *) "\xA", false ) )
+				if ( !tg_textcmd( cmd.line, buf, sizeof( buf ) ) ) continue;
+
+				while ( tg_pump( tg_reportwait(), buf, sizeof( buf ), &j, &kind ) )
 				{
-					if ( strstr( buf, "stat:3" ) != NULL )
+					if ( kind == TGLINE_SR && ( tgline_marks( buf ) & TGMARK_STOP ) )
 					{
 						printf( "OK\n" );
 						goto next_motor;
 					}
-					*buf = 0;													//	only send the command once
 				}
 			}	//	for retry
 			return( false );													//	didn't home in 3 tries
@@ -290,7 +1506,8 @@ next_motor:;
 	//	verify all homed motor positions are 0
 	if ( tg_getpos( pos ) )
 	{
-		for ( i = 0; i < 4; i ++ )
+verify:
+		for ( i = 0; i < MM; i ++ )
 		{
 			if ( home[ i ] && fabs( pos[ i ] ) > 0.0001 )
 			{
@@ -305,22 +1522,132 @@ next_motor:;
 	return( true );
 }
 
-//	Move up to 4 motors to their specified positions
+//	The g0 for the motors in move that aren't at pos yet (motors has where they are), framed for
+//	tg_dev's protocol.  With say the motors are listed on stdout too.  Returns how many move.
+static int tg_movecmd( tgcmd_t *cmd, const bool move[ MM ], const double pos[ MM ], const double motors[ MM ], bool say )
+{
+	int		n = 0;
+
+	tgcmd_gcode( cmd, tg_dev -> jsonmode );
+	tgcmd_put( cmd, "g0" );
+
+	for ( int i = 0; i < MM; i ++ )
+	{
+		if ( !move[ i ] || motors[ i ] == pos[ i ] ) continue;
+
+		if ( say ) printf( "%s%s%.3lf", ( n ) ? "," : "", tg_mname[ i ], pos[ i ] );
+		tgcmd_axis( cmd, *tg_mname[ i ], pos[ i ] );
+		n ++;
+	}
+
+	tgcmd_end( cmd, tg_dev -> jsonmode );
+	return( n );
+}
+
+//	Time everything (timeouts, deadlines, round trips, report ages) on now() instead of the steady
+//	clock, for tests that move time themselves.  NULL for the steady clock again.  Waits still
+//	sleep in real time, for no longer than now()'s time left.
+void tg_clock( tg_clock_t now )
+{
+	tgclock_set( now );
+}
+
+//	How close a motor has to get to where it was sent for a move to be done, in its units (mm
+//	or deg).  0.0005 unless this or TINYG_TOLERANCE says otherwise.
+void tg_move_tolerance( double tol )
+{
+	tg_tolerance = tol;
+}
+
+//	Move completion: has the move to pos of the motors in move finished?  It has on the first
+//	status report since the move was sent (at status_now() time since) that has the machine
+//	stopped (stat 3 or 4, velocity 0, which TinyG reports exactly once it's stopped) with each of
+//	those motors within the tolerance of pos.  The tolerance is a distance, it isn't held against
+//	the velocity (mm/min).
+//	The values are the snapshot's, parsed as numbers, so the firmware's rounding doesn't matter
+//	and a report that only carries what changed still counts.
+static bool tg_arrived( const bool move[ MM ], const double pos[ MM ], int64_t since )
+{
+	tgstatus_t	s;
+	char		*p;
+
+	if ( tg_tolerance < 0.0 )
+		tg_tolerance = ( ( p = getenv( "TINYG_TOLERANCE" ) ) != NULL && atof( p ) > 0.0 ) ? atof( p ) : TG_TOLERANCE;
+
+	if ( !status_read( &tg_dev -> snapshot, &s ) || s.ns < since ) return( false );
+	if ( ( s.stat != STAT_STOP && s.stat != STAT_END ) || s.vel != 0.0 ) return( false );
+
+	for ( int i = 0; i < MM; i ++ )
+		if ( move[ i ] && fabs( s.pos[ i ] - pos[ i ] ) > tg_tolerance ) return( false );
+	return( true );
+}
+
+//	tg_move() in JSON mode: {"gc":"g0 x10.000 y5.000"}, then it's done when a status report says
+//	the motors have arrived (tg_arrived()).
+static bool tg_move_json( bool move[ MM ], double pos[ MM ], int tosec )
+{
+	char			buf[ 300 ];
+	tgcmd_t			cmd;
+	double			motors[ MM ];
+	tgjson_t		j;
+	tgline_kind_t	kind;
+	int64_t			sent;
+
+	for ( int retry = 0; retry < 3 && !tg_expired(); retry ++ )
+	{
+		if ( !tg_getpos( motors ) )
+		{
+			printf( "Can't retrieve motor positions\n" );
+			break;
+		}
+
+		printf( "mmnove(" );
+
+		if ( !tg_movecmd( &cmd, move, pos, motors, true ) ) return( true );	//	no motors moving, success
+
+		printf( ") " );
+
+		sent = status_now();
+		j.kind = TGJSON_NONE;
+		if ( !tg_jsoncmd( cmd.line, tg_replywait(), buf, sizeof( buf ), &j ) )
+		{
+			printf( "Move command failed\n" );
+			if ( j.kind != TGJSON_R ) continue;									//	no reply, the line or its answer was lost: again
+			break;
+		}
+		printf( "OK\n" );
+
+		while ( tg_pump( tg_within( tosec * CLOCKS_PER_SEC ), buf, sizeof( buf ), &j, &kind ) )
+			if ( kind == TGLINE_SR && tg_arrived( move, pos, sent ) ) return( true );	//	all axis match expected positions
+
+		printf( "error\n" );
+	}	//	retry
+	return( false );															//	didn't get proper status
+}
+
+//	Move up to MM motors to their specified positions
 //	move is true if a motor is being moved.
-//	values are in x, y, z, a order.
+//	values are in x, y, z, a (, b, c) order.
 //	True on success.
 bool tg_move( bool move[ MM ], double pos[ MM ], int tosec )
 {
-	char	buf[ 300 ],															//	tinyg command
-			rbuf[ 300 ],														//	receive
-			sbuf[ 300 ],														//	completion status
-			*p, *q;
+	tg_use			use( NULL );
+	tg_call			call( tosec );
+	char			rbuf[ 300 ];												//	receive
+	tgcmd_t			cmd;														//	tinyg command
+	tgjson_t		j;
+	tgline_kind_t	kind;
+	tg_reply_t		r;
+	int64_t			sent;
 
 	double	motors[ MM ];
 
 	int		retry;
 
-	for ( retry = 0; retry < 3; retry ++ )
+	if ( !use.ok ) return( false );
+	if ( tg_dev -> jsonmode ) return( tg_move_json( move, pos, tosec ) );
+
+	for ( retry = 0; retry < 3 && !tg_expired(); retry ++ )
 	{
 		if ( !tg_getpos( motors ) )
 		{
@@ -330,61 +1657,35 @@ bool tg_move( bool move[ MM ], double pos[ MM ], int tosec )
 
 		printf( "mmnove(" );
 
-		strcpy( buf, "g0 " );
-		p = buf + 3;
-		q = sbuf;
-		for ( int i = 0; i < 4; i ++ )
-		{
-			if ( move[ i ] && motors[ i ] != pos[ i ] )
-			{
-				printf( "%s%s%.3lf", ( p > buf + 3 ) ? "," : "", tg_mname[ i ], pos[ i ] );
-
-				if ( p != buf + 3 )
-				{
-					strcat( p, " " );
-					p ++;
-				}
-				p += sprintf( p, "%s%.3lf", tg_mname[ i ], pos[ i ] );
-				if ( q != sbuf )
-				{
-					strcat( sbuf, "," );
-					q ++;
-				}
-				q += sprintf( q, "pos%s:%.3lf", tg_mname[ i ], pos[ i ] );		//	build the expected status reply
-			}
-		}	// for each possible motor
-
-		if ( p != buf + 3 )
+		if ( tg_movecmd( &cmd, move, pos, motors, true ) )
 		{
 			printf( ") " );
-			strcat( p, "\r" );
 
-			if ( !cmdio( buf, tosec * CLOCKS_PER_SEC, rbuf, sizeof( rbuf ), (char *) "\xA" ) )
+			sent = status_now();
+			r = tg_reply_t{ 0, 0, rbuf, sizeof( rbuf ), NULL };
+			if ( !tg_send( cmd.line, cmd.len, tg_replied, &r ) || !tg_await( &r, 1, tg_replywait() ) )
 			{
+				if ( r.failed )
+				{
+					printf( "Move command failed (%s)\n", rbuf );
+					break;
+				}
 				printf( "Move command failed\n" );
-				break;
-			}
-			if ( strstr( rbuf, "err" ) != NULL )
-			{
-				printf( "Move command failed (%s)\n", rbuf );
-				break;
+				continue;														//	no reply, the line or its answer was lost: again
 			}
 			printf( "OK\n" );
 
-			while ( cmdio( (char *) "", tosec * CLOCKS_PER_SEC, rbuf, sizeof( rbuf ), (char *) "\xA", false ) )
+			do
 			{
 				//	Process each line as we receive it
 				//	lines contain posm1:<pos>,posm2:<pos>,...vel:<vel>,stat:<status>
-				//	The final line contains all moving motors with their positions equal to pos[].
+				//	The receive tap has put a report's values in the snapshot by the time it's read.
 
 				//	printf( "%s\n", rbuf );
 
-				if (strstr(rbuf, sbuf) != NULL) {
-					//closeports();
-					return(true);
-				}//	all axis match expected positions
-
+				if ( tg_arrived( move, pos, sent ) ) return( true );			//	all axis match expected positions
 			}
+			while ( tg_pump( tg_within( tosec * CLOCKS_PER_SEC ), rbuf, sizeof( rbuf ), &j, &kind ) );
 			printf( "error\n" );
 		}	//	any motor is being moved
 		else {
@@ -395,74 +1696,474 @@ bool tg_move( bool move[ MM ], double pos[ MM ], int tosec )
 	return( false );															//	didn't get proper status
 }
 
-const char *rmin = "$%stn\r";													//	request min range
-const char *rmax = "$%stm\r";													//	and max range
-bool tg_getranges( tg_range_t *mrange )
+//	Group moves: one move over the axes of several boards (tg_group_move()).  Each board's
+//	command is formatted and its input cleared beforehand, then the commands go out back to back
+//	from this thread, so the boards start within the time a few writes take.  (A feedhold/resume
+//	barrier doesn't work here: TinyG drops a feedhold while it's idle, and the move would run.)
+//	Each board is then waited for on its own thread, the group is done when they all are.
+
+//	Wait up to tosec (between lines) for the motors in move on tg_dev to arrive at pos (a report
+//	since sent, tg_arrived()), reading the replies and reports.  r is what the command's
+//	answer goes to.
+static bool tg_groupwait( const bool move[ MM ], const double pos[ MM ], int64_t sent, int tosec, tg_reply_t *r )
 {
-	int		i, retry;
-	char	buf[ 300 ], rbuf[ 300 ];
+	char			buf[ 300 ];
+	tgjson_t		j;
+	tgline_kind_t	kind;
 
-	for ( retry = 0; retry < 3; retry ++ )
+	while ( tg_pump( tg_within( tosec * CLOCKS_PER_SEC ), buf, sizeof( buf ), &j, &kind ) )
 	{
-		for ( i = 0; i < 4; i ++ )
+		if ( r -> failed )
 		{
-			sprintf( buf, rmin, tg_mname[ i ] );								//	form command for the min range
+			printf( "Group move failed (%s)\n", buf );
+			return( false );
+		}
 
-			while ( cmdio( buf, CLOCKS_PER_SEC, rbuf, sizeof( rbuf ), (char *) "\xA", false ) )
-			{
-				//	printf( "%s\n", rbuf );
-				//	[xtn] x travel minimum            0.000 mm
-				//	tinyg [mm] ok>
+		if ( r -> answered && tg_arrived( move, pos, sent ) ) return( true );
+	}
+	printf( "Group move timed out\n" );
+	tgdispatch_clear( &tg_dev -> dispatch );
+	return( false );
+}
 
-				if ( *buf )
-				{
-					if ( sscanf( rbuf + 25, "%lf", &mrange[ i ].min ) == 1 )
-					{
-					}
-					else
-						break;
-					*buf = 0;
-				}
-				else
-					if ( strstr( rbuf, "ok>" ) == NULL ) break;
-			}
+//	Move the motors of several boards together: targets[ i ] names a device (NULL for the
+//	default one), its motors to move and where to.  Waits up to tosec for all of them, true if
+//	every board got there.  *skewms (if skewms isn't NULL) gets the time the commands took to
+//	go out, first to last.
+bool tg_group_move( tg_target_t targets[ ], int n, int tosec, double *skewms )
+{
+	tg_call		call( tosec );
+	tgcmd_t		cmd[ TG_GROUPMAX ];
+	tg_reply_t	reply[ TG_GROUPMAX ];											//	where each board's answer goes
+	tg_device	*dev[ TG_GROUPMAX ];
+	int			port[ TG_GROUPMAX ], i, k;
+	double		motors[ MM ];
+	int64_t		t0, t1;
+	bool		ok[ TG_GROUPMAX ];
+	std::thread	waiter[ TG_GROUPMAX ];
 
-			//	do the same for max range
+	if ( n < 1 || n > TG_GROUPMAX ) return( false );
 
-			sprintf( buf, rmax, tg_mname[ i ] );								//	form command for the max range
+	//	Each board once: two waiters on one port would take each other's replies and reports
 
-			while ( cmdio( buf, CLOCKS_PER_SEC, rbuf, sizeof( rbuf ), (char *) "\xA", false ) )
+	for ( i = 0; i < n; i ++ )
+	{
+		dev[ i ] = ( targets[ i ].dev != NULL ) ? targets[ i ].dev : &tg_dev0;
+		for ( k = 0; k < i; k ++ )
+		{
+			if ( dev[ k ] == dev[ i ] )
 			{
-//				printf( "%s\n", rbuf );
-				//	[xtm] x travel minimum            0.000 mm
-				//	tinyg [mm] ok>
-
-				if ( *buf )
-				{
-					if ( sscanf( rbuf + 25, "%lf", &mrange[ i ].max ) == 1 )
-					{
-					}
-					else
-						break;
-					*buf = 0;
-				}
-				else
-					if ( strstr( rbuf, "ok>" ) == NULL ) break;
+				printf( "Group move: board %d is board %d again\n", i, k );
+				return( false );
 			}
-		}	//	for each motor
+		}
+	}
+
+	//	Stage each board's command: it needs status reports, and its input read so the wait
+	//	only sees what the move brings.  Its answer is expected as it goes out.
+
+	for ( i = 0; i < n; i ++ )
+	{
+		tg_use	use( targets[ i ].dev );
+
+		port[ i ] = -1;
+		ok[ i ] = true;
+		if ( !use.ok || !tg_dev -> subscribed || !tg_getpos_ex( motors, NULL ) )
+		{
+			printf( "Group move: board %d isn't ready\n", i );
+			return( false );
+		}
+
+		tg_drain();
+
+		if ( tgdispatch_pending( &tg_dev -> dispatch ) >= TGDISPATCH_DEPTH )
+		{
+			printf( "Group move: board %d is busy\n", i );
+			return( false );
+		}
+
+		reply[ i ] = tg_reply_t{ 0, 0, NULL, 0, NULL };
+		dev[ i ] = tg_dev;
+		if ( tg_movecmd( &cmd[ i ], targets[ i ].move, targets[ i ].pos, motors, false ) ) port[ i ] = tg_dev -> port;	//	or nothing to move on this one
+	}
+
+	//	Release: the commands out back to back.  A board whose command can't go out has failed, and
+	//	isn't waited for.
+
+	t0 = status_now();
+	for ( i = 0; i < n; i ++ )
+	{
+		if ( port[ i ] < 0 ) continue;
+
+		if ( !portselect( port[ i ] ) && tgdispatch_push( &dev[ i ] -> dispatch, tg_replied, &reply[ i ], 0 ) )
+			outcoms( cmd[ i ].line, (unsigned long) cmd[ i ].len );
+		else
+		{
+			port[ i ] = -1;
+			ok[ i ] = false;
+		}
+	}
+	t1 = status_now();
+	for ( i = 0; i < n; i ++ )
+		if ( !ok[ i ] ) printf( "Group move: board %d's move couldn't be sent\n", i );	//	after, not to hold the others up
+	if ( skewms != NULL ) *skewms = ( t1 - t0 ) / 1e6;
+	if ( tg_dev != NULL && tg_dev -> port >= 0 ) portselect( tg_dev -> port );		//	the caller's port again
+
+	//	Wait for each board on its own thread, the last on this one
+
+	for ( i = 0; i < n; i ++ )
+	{
+		if ( port[ i ] < 0 ) continue;
+
+		auto	wait = [ &targets, &ok, &reply, t0, tosec ]( int b )
+		{
+			tg_use	use( targets[ b ].dev );
+			tg_call	call( tosec );													//	this thread's own, the same as the caller's
+
+			ok[ b ] = use.ok && tg_groupwait( targets[ b ].move, targets[ b ].pos, t0, tosec, &reply[ b ] );
+		};
+
+		if ( i < n - 1 )
+			waiter[ i ] = std::thread( wait, i );
+		else
+			wait( i );
+	}
+
+	for ( i = 0, k = true; i < n; i ++ )
+	{
+		if ( waiter[ i ].joinable() ) waiter[ i ].join();
+		k = k && ok[ i ];
+	}
+	return( k );
+}
+
+//	Streaming: gcode lines are sent as fast as TinyG's planner takes them, so moves run back to back
+//	instead of coming to a stop while tg_move() waits for each one.  Queue reports ($qv=1) say how
+//	many planner buffers are free.  A line goes out while more than STREAM_RESERVE would stay free
+//	and fewer than STREAM_INFLIGHT lines are waiting for their answers, which also keeps TinyG's
+//	serial buffer from overflowing.
+//
+//		tg_stream_open();
+//		tg_stream_push( "g0 x10 y5", 10 );	...
+//		tg_stream_drain( 30 );
+
+//	The answer to a streamed line, ctx is its device.  A line that's dropped unanswered isn't
+//	in flight any more either.
+static void tg_streamed( void *ctx, tgline_kind_t kind, const char *line, const tgjson_t *j )
+{
+	tg_device	*dev = (tg_device *) ctx;
+
+	if ( !tgline_answer( kind ) && kind != TGLINE_NONE ) return;				//	echoes
+
+	if ( kind == TGLINE_ERROR )
+	{
+		dev -> stream.failed = true;
+		printf( "Stream error: %s\n", line );
+	}
+	if ( dev -> stream.inflight > 0 ) dev -> stream.inflight --;
+}
+
+//	Read a line while streaming, the answers to streamed lines go to tg_streamed().  False on
+//	a timeout.
+static bool tg_streamline( long timeout )
+{
+	char			buf[ 300 ];
+	tgjson_t		j;
+	tgline_kind_t	kind;
+
+	return( tg_pump( timeout, buf, sizeof( buf ), &j, &kind ) );
+}
+
+//	Start streaming: queue reports on, and how many planner buffers are free.
+bool tg_stream_open( void )
+{
+	static const char	*json[ 2 ] = { "{\"qv\":1}\n", "{\"qr\":null}\n" };
+	static const char	*text[ 2 ] = { "$qv=1\r", "$qr\r" };
+	tg_use				use( NULL );
+	tg_call				call( 0 );
+
+	tg_dev -> stream.open = tg_dev -> stream.failed = false;
+	if ( !use.ok ) return( false );
+	tg_dev -> stream.inflight = 0;
+	tg_dev -> qr.store( -1 );
+
+	if ( !tg_commands( ( tg_dev -> jsonmode ) ? json : text, 2 ) || tg_dev -> qr.load() < 0 )
+	{
+		printf( "Can't turn queue reports on\n" );
+		return( false );
+	}
+
+	tg_dev -> stream.qrstart = tg_dev -> qr.load();
+	tg_dev -> stream.open = true;
+	return( true );
+}
+
+//	Send a gcode line once the planner has room for it, waiting up to tosec for the room.
+//	False if it timed out or TinyG has refused a line.
+bool tg_stream_push( const char *gcode, int tosec )
+{
+	tg_use	use( NULL );
+	tg_call	call( tosec );
+	tgcmd_t	cmd;
+
+	if ( !use.ok || !tg_dev -> stream.open ) return( false );
+
+	tgcmd_gcode( &cmd, tg_dev -> jsonmode );
+	tgcmd_put( &cmd, gcode, strlen( gcode ) );
+	tgcmd_end( &cmd, tg_dev -> jsonmode );
+	if ( !tgcmd_ok( &cmd ) )
+	{
+		printf( "Gcode line too long (%s)\n", gcode );
+		return( false );
+	}
+
+	//	Take the answers and reports that are in, then wait for room
+
+	tg_drain();
+
+	while ( !tg_dev -> stream.failed && ( tg_dev -> stream.inflight >= STREAM_INFLIGHT || tg_dev -> qr.load() - tg_dev -> stream.inflight <= STREAM_RESERVE ) )
+	{
+		if ( !tg_streamline( tg_within( tosec * CLOCKS_PER_SEC ) ) )
+		{
+			printf( "Stream stalled\n" );
+			return( false );
+		}
+	}
+
+	if ( tg_dev -> stream.failed ) return( false );
+
+	if ( !tg_send( cmd.line, cmd.len, tg_streamed, tg_dev, false ) ) return( false );
+	tg_dev -> stream.inflight ++;
+	return( true );
+}
+
+//	Wait up to tosec (between reports) for everything pushed to have run, and end the stream.
+//	True if it all ran.
+bool tg_stream_drain( int tosec )
+{
+	tg_use		use( NULL );
+	tg_call		call( -1 );
+	char		buf[ 300 ];
+	tgjson_t	j;
+	tgstatus_t	s;
+	bool		done = true;
+
+	if ( !use.ok || !tg_dev -> stream.open ) return( false );
+
+	while ( tg_dev -> stream.inflight > 0 || tg_dev -> qr.load() < tg_dev -> stream.qrstart
+			|| !status_read( &tg_dev -> snapshot, &s ) || ( s.stat != STAT_STOP && s.stat != STAT_END ) )
+	{
+		if ( !tg_streamline( tg_within( tosec * CLOCKS_PER_SEC ) ) )
+		{
+			printf( "Stream didn't finish\n" );
+			done = false;
+			break;
+		}
+	}
+
+	tg_dev -> stream.open = false;
+	if ( tg_dev -> jsonmode )
+		tg_jsoncmd( "{\"qv\":0}\n", tg_replywait(), buf, sizeof( buf ), &j );
+	else
+		tg_textcmd( "$qv=0\r", buf, sizeof( buf ) );
+
+	return( done && !tg_dev -> stream.failed );
+}
+
+//	Which range a setting's name is: 0 for xtn, 1 for xtm, 2 for ytn.. 7 for atm (11 for ctm),
+//	-1 if it isn't one.
+static int tg_rangeslot( std::string_view name )
+{
+	int		i;
+
+	if ( name.size() != 3 || name[ 1 ] != 't' || ( name[ 2 ] != 'n' && name[ 2 ] != 'm' ) ) return( -1 );
+	if ( ( i = tg_axes_t::of( name[ 0 ] ) ) < 0 ) return( -1 );
+	return( 2 * i + ( name[ 2 ] == 'm' ) );
+}
+
+//	A range query's answer (JSON) or echo (text) into a tg_ranges_t.
+typedef struct
+{
+	tg_range_t	*mrange;
+	unsigned	got;															//	a bit per tg_rangeslot()
+} tg_ranges_t;
+
+static void tg_rangeline( void *ctx, tgline_kind_t kind, const char *line, const tgjson_t *j )
+{
+	tg_ranges_t	*r = (tg_ranges_t *) ctx;
+	int			i;
+	double		v;
+
+	if ( kind == TGLINE_RESPONSE )
+	{
+		if ( j -> npairs < 1 || !j -> pair[ 0 ].number || ( i = tg_rangeslot( j -> pair[ 0 ].name ) ) < 0 ) return;
+		v = j -> pair[ 0 ].value;
+	}
+	else
+	{
+		if ( kind != TGLINE_ECHO || strlen( line ) < 26 || line[ 4 ] != ']' || ( i = tg_rangeslot( std::string_view( line + 1, 3 ) ) ) < 0 || sscanf( line + 25, "%lf", &v ) != 1 ) return;
+	}
+
+	if ( i & 1 )
+		r -> mrange[ i / 2 ].max = v;
+	else
+		r -> mrange[ i / 2 ].min = v;
+	r -> got |= 1 << i;
+}
+
+//	Ask TinyG for the motor ranges.  The queries, two per motor ($xtn, $xtm, $ytn.. or
+//	{"xtn":null}.., put together at compile time, tgaxes.h) go out together, a request each, and
+//	the replies are sorted out by name as they come back:
+//
+//		[xtn] x travel minimum            0.000 mm							text, then the prompt
+//		{"r":{"xtn":0.000},"f":[1,0,13,5823]}									JSON
+static bool tg_queryranges( tg_range_t *mrange )
+{
+	const char	*cmd;
+	size_t		len;
+	tg_ranges_t	ranges;
+	tg_reply_t	r;
+	int			i;
+
+	cmd = ( tg_dev -> jsonmode ) ? tg_axes_t::rangejson.data() : tg_axes_t::rangetext.data();
+	len = ( tg_dev -> jsonmode ) ? tg_axes_t::rangejson.size() - 1 : tg_axes_t::rangetext.size() - 1;
+
+	for ( int retry = 0; retry < 3 && !tg_expired(); retry ++ )
+	{
+		ranges = tg_ranges_t{ mrange, 0 };
+		r = tg_reply_t{ 0, 0, NULL, 0, NULL, tg_rangeline, &ranges };
 
-		if ( i >= 4 )
+		for ( i = 0; i < 2 * MM && tg_expect( tg_replied, &r, true ); i ++ ) ;
+		if ( i < 2 * MM )
 		{
-			printf( "Motor Ranges:\n" );
-			for ( i = 0; i < 4; i ++ )
-				printf( "%s\t%.3lf\t%.3lf\n", tg_mname[ i ], mrange[ i ].min, mrange[ i ].max );
-			return( true );
+			printf( "Motor ranges: too many commands waiting for answers\n" );
+			tg_await( &r, i, tg_replywait() );
+			return( false );
 		}
+
+		outcoms( (char *) cmd, (unsigned long) len );
+		tg_await( &r, 2 * MM, tg_replywait() );								//	what's refused is missing from got
+
+		if ( ranges.got == ( 1u << 2 * MM ) - 1 ) return( true );
+		printf( "Motor ranges: no reply\n" );
 	}	//	for retry
 	return( false );
 }
 
+//	Forget the ranges if cmd ($xtn=100, {"xtn":100}) changes a setting, they're asked for again.
+static void tg_setting( const char *cmd )
+{
+	const char	*p;
+
+	if ( *cmd == '$' && strchr( cmd, '=' ) != NULL )
+		tg_dev -> rangesknown = false;
+	else
+		if ( *cmd == '{' && strncmp( cmd, "{\"gc\"", 5 ) && ( p = strchr( cmd, ':' ) ) != NULL && strncmp( p + 1, "null", 4 ) )
+			tg_dev -> rangesknown = false;
+}
+
+//	Motor ranges, as TinyG gave them when the port was opened or since the last setting changed.
+bool tg_getranges( tg_range_t *mrange )
+{
+	tg_use	use( NULL );
+	tg_call	call( 0 );
+	int		i;
+
+	if ( !use.ok ) return( false );
+
+	if ( !tg_dev -> rangesknown )
+	{
+		if ( !( tg_dev -> rangesknown = tg_queryranges( tg_dev -> ranges ) ) ) return( false );
+		tg_cachesave();
+	}
+
+	memcpy( mrange, tg_dev -> ranges, sizeof( tg_dev -> ranges ) );
+	printf( "Motor Ranges:\n" );
+	for ( i = 0; i < MM; i ++ )
+		printf( "%s\t%.3lf\t%.3lf\n", tg_mname[ i ], mrange[ i ].min, mrange[ i ].max );
+	return( true );
+}
+
 void tg_comm( char *msg )
 {
+	tg_use		use( NULL );
+
+	if ( !use.ok ) return;
+
+	tg_dev -> rangesknown = false;												//	anything may be typed
 	simplecomma( 0x1B, true, msg, true );
-}
\ No newline at end of file
+}
+//	The calls on a device tg_open() opened, NULL for the default device.  Calls on different
+//	devices can be made from different threads at the same time.
+
+bool tg_dev_getpos( tg_device *dev, double pos[ MM ] )
+{
+	tg_use	use( dev );
+
+	return( use.ok && tg_getpos( pos ) );
+}
+
+bool tg_dev_getpos_ex( tg_device *dev, double pos[ MM ], double *agems )
+{
+	tg_use	use( dev );
+
+	return( use.ok && tg_getpos_ex( pos, agems ) );
+}
+
+bool tg_dev_home( tg_device *dev, bool home[ MM ], int tosec )
+{
+	tg_use	use( dev );
+
+	return( use.ok && tg_home( home, tosec ) );
+}
+
+bool tg_dev_move( tg_device *dev, bool move[ MM ], double pos[ MM ], int tosec )
+{
+	tg_use	use( dev );
+
+	return( use.ok && tg_move( move, pos, tosec ) );
+}
+
+//	An async request (tgasync.cpp) on dev, on the worker thread.  The device is the worker's while
+//	it runs, see tg_querypos().
+bool tg_async_run( tg_device *dev, bool home, bool motors[ MM ], double pos[ MM ], int tosec )
+{
+	std::lock_guard<std::recursive_mutex>	l( ( dev != NULL ) ? dev -> owner : tg_dev0.owner );
+
+	return( ( home ) ? tg_dev_home( dev, motors, tosec ) : tg_dev_move( dev, motors, pos, tosec ) );
+}
+
+bool tg_dev_getranges( tg_device *dev, tg_range_t mrange[ MM ] )
+{
+	tg_use	use( dev );
+
+	return( use.ok && tg_getranges( mrange ) );
+}
+
+bool tg_dev_json( tg_device *dev, bool on )
+{
+	tg_use	use( dev );
+
+	return( use.ok && tg_json( on ) );
+}
+
+bool tg_dev_stream_open( tg_device *dev )
+{
+	tg_use	use( dev );
+
+	return( use.ok && tg_stream_open() );
+}
+
+bool tg_dev_stream_push( tg_device *dev, const char *gcode, int tosec )
+{
+	tg_use	use( dev );
+
+	return( use.ok && tg_stream_push( gcode, tosec ) );
+}
+
+bool tg_dev_stream_drain( tg_device *dev, int tosec )
+{
+	tg_use	use( dev );
+
+	return( use.ok && tg_stream_drain( tosec ) );
+}
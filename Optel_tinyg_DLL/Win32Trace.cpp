@@ -4,6 +4,8 @@
 // ---------------------------------------------------------------------
 // Rev    Date      By     Description
 // -----  --------  -----  ---------------------------------------------
+//		  10/16/26  DV	   POSIX builds write to stderr when COMMTRACE is set.
+// -----  --------  -----  ---------------------------------------------
 //		  10/23/12  SRG	   Fixed return value bug from __vsnTRACE.
 // -----  --------  -----  ---------------------------------------------
 //		  10/23/09	SRG	   Original after discovering the
@@ -16,7 +18,9 @@
 #include <stdlib.h>
 #include <stdarg.h>
 #include <string.h>
+#ifdef	_WIN32
 #include <windows.h>
+#endif
 
 
 
@@ -39,6 +43,26 @@ int TRACE( char *fmt, ... )
 
 	va_start( argptr, fmt );							// Initialize va_ functions
 
+#ifndef	_WIN32
+	//	vsnprintf reports the length it needed rather than failing
+
+	va_list	args;
+
+	va_copy( args, argptr );
+	if ( ( cnt = vsnprintf( str, alloced, fmt, args ) ) >= (int) alloced )
+	{
+		alloced = cnt + 1;
+
+		if ( ( str = (char *) realloc( str, alloced ) ) == NULL )
+		{
+			va_end( args );
+			va_end( argptr );
+			return( 0 );
+		}
+		cnt = vsnprintf( str, alloced, fmt, argptr );
+	}
+	va_end( args );
+#else
 	while ( ( cnt = _vsnprintf( str, alloced - 1, fmt, argptr ) ) < 0 )
 	{
 		//	We converted the output and it filled our buffer,
@@ -51,9 +75,14 @@ int TRACE( char *fmt, ... )
 			return( 0 );
 		}
 	}
+#endif
 
 	va_end( argptr );									// Close va_ functions
+#ifdef	_WIN32
 	OutputDebugStringA( str );							// send to debug window
+#else
+	if ( getenv( "COMMTRACE" ) != NULL ) fputs( str, stderr );	// no debug window, use stderr on request
+#endif
 	free( str );										// we're done!
 	return( cnt );
 }
@@ -0,0 +1,84 @@
+//	==========================================================================================
+//	Serial port enumeration.  commenum() (win32comm.cpp with SetupDi, posixcomm.cpp from sysfs)
+//	lists the serial devices in one pass, with what the system knows about each.  Nothing is run
+//	and no files are written.
+//
+//	A filter picks ports out of the list.  It's words, all of which must match:
+//
+//		VID 0403		USB vendor id (hex)
+//		PID 6015		USB product id (hex)
+//		SN D30AOLGY		serial number, a prefix of it
+//		anything else	a prefix of the manufacturer
+//
+//	so "FTDI VID 0403" is an FTDI adapter with FTDI's vendor id.  Letter case doesn't matter.
+// ---------------------------------------------------------------------
+// Rev    Date      By     Description
+// -----  --------  -----  ---------------------------------------------
+//		  10/16/26	DV	   Original, replaces the mode and powershell dumps.
+//	==========================================================================================
+
+#pragma once
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define	MAXCOMMENUM		64														//	most ports commenum() is asked for at once
+
+typedef struct
+{
+	int				comport;													//	COM number, 5 = COM5
+	char			path[ 64 ];													//	device: COM5, /dev/ttyUSB0
+	char			id[ 200 ];													//	FTDIBUS\VID_0403+PID_6015+D30AOLGYA\0000, /dev/serial/by-id/..
+	unsigned		vid, pid;													//	0 if it isn't USB
+	char			serial[ 64 ];
+	char			manufacturer[ 64 ];
+	char			product[ 100 ];												//	description: USB Serial Port
+} commport_t;
+
+
+//	Case blind: does s start with prefix (of length n)?
+
+inline bool commenum_prefix( const char *s, const char *prefix, size_t n )
+{
+	for ( size_t i = 0; i < n; i ++ )
+		if ( !s[ i ] || tolower( (unsigned char) s[ i ] ) != tolower( (unsigned char) prefix[ i ] ) ) return( false );
+	return( true );
+}
+
+
+//	True if port matches filter (NULL or "" matches everything).
+
+inline bool commenum_match( const commport_t *port, const char *filter )
+{
+	const char	*p = filter, *w;
+	size_t		n;
+	int			key = 0;														//	'v', 'p' or 's' after VID, PID or SN
+
+	while ( p != NULL && *p )
+	{
+		while ( isspace( (unsigned char) *p ) ) p ++;
+		for ( w = p; *p && !isspace( (unsigned char) *p ); p ++ ) ;
+		if ( !( n = p - w ) ) break;
+
+		if ( key )
+		{
+			if ( ( key == 'v' && strtoul( w, NULL, 16 ) != port -> vid ) || ( key == 'p' && strtoul( w, NULL, 16 ) != port -> pid )
+					|| ( key == 's' && !commenum_prefix( port -> serial, w, n ) ) )
+				return( false );
+			key = 0;
+		}
+		else
+			if ( n == 3 && commenum_prefix( w, "VID", 3 ) )
+				key = 'v';
+			else
+				if ( n == 3 && commenum_prefix( w, "PID", 3 ) )
+					key = 'p';
+				else
+					if ( n == 2 && commenum_prefix( w, "SN", 2 ) )
+						key = 's';
+					else
+						if ( !commenum_prefix( port -> manufacturer, w, n ) ) return( false );
+	}
+	return( true );
+}
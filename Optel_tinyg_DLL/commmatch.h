@@ -0,0 +1,151 @@
+//	==========================================================================================
+//	Multi-pattern matcher for receive streams (Aho-Corasick).  The patterns are put in a trie
+//	and the trie made into a state machine that's fed one byte at a time.  match_step() says
+//	which patterns end at that byte, as a bit per pattern id.  Each byte is looked at once,
+//	however many patterns there are and however they overlap ("xxyz" is found in "xxxyz").
+//	Nothing is buffered, so a match can span reads.
+//
+//		commmatch_t	m;
+//		int			state = 0;
+//
+//		match_init( &m );
+//		ack = match_add( &m, "OK\r", 3 );								0
+//		nak = match_add( &m, "ERROR\r", 6 );							1
+//		match_build( &m );
+//		...
+//		hits = match_step( &m, &state, c );							for each byte c
+//		if ( hits & ( 1u << ack ) ) ...
+//
+//	Bytes that aren't in any pattern share one column of the table, so it stays small
+//	enough for the stack: MATCH_STATES states by MATCH_CLASSES distinct bytes.
+// ---------------------------------------------------------------------
+// Rev    Date      By     Description
+// -----  --------  -----  ---------------------------------------------
+//		  10/16/26	DV	   Original, replaces the sliding window compares in waitfor().
+//	==========================================================================================
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#define	MATCH_STATES	128														//	trie nodes: the patterns' total length + 1 at most
+#define	MATCH_CLASSES	64														//	distinct bytes in the patterns + 1
+#define	MATCH_PATTERNS	32														//	a bit each in a match
+
+typedef struct
+{
+	uint8_t		cls[ 256 ];														//	byte to column, 0 for bytes in no pattern
+	uint8_t		next[ MATCH_STATES ][ MATCH_CLASSES ];							//	state and column to the next state
+	uint32_t	out[ MATCH_STATES ];											//	patterns that end in each state
+	int			nstates;
+	int			nclasses;
+	int			npatterns;
+} commmatch_t;
+
+#define	MATCH_NONE		0xFF													//	no trie edge, until match_build()
+
+
+inline void match_init( commmatch_t *m )
+{
+	memset( m -> cls, 0, sizeof( m -> cls ) );
+	memset( m -> next[ 0 ], MATCH_NONE, sizeof( m -> next[ 0 ] ) );
+	m -> out[ 0 ] = 0;
+	m -> nstates = 1;
+	m -> nclasses = 1;
+	m -> npatterns = 0;
+}
+
+
+//	Add len bytes of p.  Returns its id, the bit it gets is 1 << id, or -1 if it doesn't fit.
+
+inline int match_add( commmatch_t *m, const char *p, int len )
+{
+	int				s = 0;
+	unsigned char	c;
+
+	if ( len <= 0 || m -> npatterns >= MATCH_PATTERNS ) return( -1 );
+
+	for ( int i = 0; i < len; i ++ )
+	{
+		c = (unsigned char) p[ i ];
+		if ( m -> cls[ c ] == 0 )
+		{
+			if ( m -> nclasses >= MATCH_CLASSES ) return( -1 );
+			m -> cls[ c ] = (uint8_t) m -> nclasses ++;
+		}
+
+		if ( m -> next[ s ][ m -> cls[ c ] ] == MATCH_NONE )
+		{
+			if ( m -> nstates >= MATCH_STATES ) return( -1 );
+			memset( m -> next[ m -> nstates ], MATCH_NONE, sizeof( m -> next[ 0 ] ) );
+			m -> out[ m -> nstates ] = 0;
+			m -> next[ s ][ m -> cls[ c ] ] = (uint8_t) m -> nstates ++;
+		}
+		s = m -> next[ s ][ m -> cls[ c ] ];
+	}
+
+	m -> out[ s ] |= 1u << m -> npatterns;
+	return( m -> npatterns ++ );
+}
+
+
+//	Make the trie a state machine: breadth first, each state's missing edges are taken from
+//	the state its longest proper suffix leads to (its failure link), and it inherits that
+//	state's matches.  After this no byte ever backs up.
+
+inline void match_build( commmatch_t *m )
+{
+	uint8_t		fail[ MATCH_STATES ], queue[ MATCH_STATES ];
+	int			head = 0, tail = 0, s, t;
+
+	for ( int c = 0; c < m -> nclasses; c ++ )
+	{
+		if ( ( t = m -> next[ 0 ][ c ] ) == MATCH_NONE )
+			m -> next[ 0 ][ c ] = 0;
+		else
+		{
+			fail[ t ] = 0;
+			queue[ tail ++ ] = (uint8_t) t;
+		}
+	}
+
+	while ( head < tail )
+	{
+		s = queue[ head ++ ];
+		m -> out[ s ] |= m -> out[ fail[ s ] ];
+
+		for ( int c = 0; c < m -> nclasses; c ++ )
+		{
+			if ( ( t = m -> next[ s ][ c ] ) == MATCH_NONE )
+				m -> next[ s ][ c ] = m -> next[ fail[ s ] ][ c ];
+			else
+			{
+				fail[ t ] = m -> next[ fail[ s ] ][ c ];
+				queue[ tail ++ ] = (uint8_t) t;
+			}
+		}
+	}
+}
+
+
+//	Feed c, *state is where the stream is (0 to start).  The patterns that end with c.
+
+inline uint32_t match_step( const commmatch_t *m, int *state, unsigned char c )
+{
+	*state = m -> next[ *state ][ m -> cls[ c ] ];
+	return( m -> out[ *state ] );
+}
+
+
+//	Every pattern found in n bytes of p.
+
+inline uint32_t match_scan( const commmatch_t *m, const char *p, size_t n )
+{
+	uint32_t	hits = 0;
+	int			s = 0;
+
+	for ( size_t i = 0; i < n; i ++ )
+		hits |= match_step( m, &s, (unsigned char) p[ i ] );
+	return( hits );
+}
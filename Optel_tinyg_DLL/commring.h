@@ -0,0 +1,200 @@
+//	==========================================================================================
+//	Receive ring shared by a port's reader thread (the producer) and the charin()/getbyte()
+//	family (the consumer).  Single producer, single consumer and lock-free: each side owns
+//	one index, and the indexes run free and are masked on use.
+//
+//	Errors the driver reports for a block (CE_FRAME, CE_OVERRUN, ...) are queued as markers
+//	holding the index of the block's first byte.  ring_read() hands them back with the block,
+//	getbyte() in the upper byte of its first character, as it always has.
+// ---------------------------------------------------------------------
+// Rev    Date      By     Description
+// -----  --------  -----  ---------------------------------------------
+//		  10/16/26	DV	   ring_read(): a block at a time, its errors with it.  ring_get() is one byte of it.
+//		  10/16/26	DV	   ring_take(): bytes up to a delimiter, a run at a time (commscan.h)
+//		  10/16/26	DV	   Original, replaces the one character readahead[] buffer.
+//	==========================================================================================
+
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+#include <string.h>
+
+#include "commscan.h"
+
+#define	RINGSIZE		8192													//	receive bytes buffered per port, a power of 2
+#define	MARKSIZE		64														//	error markers, a power of 2
+
+typedef struct
+{
+	unsigned char			data[ RINGSIZE ];
+	std::atomic<uint32_t>	head;												//	next byte written (producer)
+	std::atomic<uint32_t>	tail;												//	next byte read (consumer)
+
+	struct
+	{
+		uint32_t			at;													//	index of the first byte of the block
+		unsigned			errors;												//	CE_ bits
+	}						marks[ MARKSIZE ];
+	std::atomic<uint32_t>	mhead, mtail;
+} commring_t;
+
+
+//	Empty the ring.  Only while there's no producer (the reader thread isn't running).
+
+inline void ring_init( commring_t *r )
+{
+	r -> head.store( 0 );
+	r -> tail.store( 0 );
+	r -> mhead.store( 0 );
+	r -> mtail.store( 0 );
+}
+
+
+//	Bytes waiting (consumer side).
+
+inline uint32_t ring_count( commring_t *r )
+{
+	return( r -> head.load( std::memory_order_acquire ) - r -> tail.load( std::memory_order_relaxed ) );
+}
+
+
+//	Room left (producer side).
+
+inline uint32_t ring_space( commring_t *r )
+{
+	return( RINGSIZE - ( r -> head.load( std::memory_order_relaxed ) - r -> tail.load( std::memory_order_acquire ) ) );
+}
+
+
+//	Producer: append up to n bytes received with errors.  Returns the number stored.
+
+inline uint32_t ring_put( commring_t *r, const unsigned char *p, uint32_t n, unsigned errors )
+{
+	uint32_t	head = r -> head.load( std::memory_order_relaxed ), at, first;
+
+	if ( n > ring_space( r ) ) n = ring_space( r );
+
+	if ( errors )
+	{
+		uint32_t	m = r -> mhead.load( std::memory_order_relaxed );
+
+		if ( m - r -> mtail.load( std::memory_order_acquire ) < MARKSIZE )
+		{
+			r -> marks[ m & ( MARKSIZE - 1 ) ].at = head;
+			r -> marks[ m & ( MARKSIZE - 1 ) ].errors = errors;
+			r -> mhead.store( m + 1, std::memory_order_release );
+		}
+	}
+
+	at = head & ( RINGSIZE - 1 );
+	first = ( n < RINGSIZE - at ) ? n : RINGSIZE - at;
+	memcpy( r -> data + at, p, first );
+	memcpy( r -> data, p + first, n - first );
+
+	r -> head.store( head + n, std::memory_order_release );
+	return( n );
+}
+
+
+//	Consumer: up to max bytes into buf, *errors gets the error bits of the block they start in.
+//	A read stops short of the next block with errors, so the errors are always those of the
+//	bytes read.  Returns the bytes read, 0 if the ring is empty.
+
+inline uint32_t ring_read( commring_t *r, unsigned char *buf, uint32_t max, unsigned *errors )
+{
+	uint32_t	tail = r -> tail.load( std::memory_order_relaxed ), count, at, first, m;
+
+	*errors = 0;
+	if ( ( count = r -> head.load( std::memory_order_acquire ) - tail ) == 0 ) return( 0 );
+
+	//	Errors of blocks at or before the first byte (a marker's block may have been discarded)
+
+	while ( ( m = r -> mtail.load( std::memory_order_relaxed ) ) != r -> mhead.load( std::memory_order_acquire )
+			&& (int32_t) ( r -> marks[ m & ( MARKSIZE - 1 ) ].at - tail ) <= 0 )
+	{
+		*errors |= r -> marks[ m & ( MARKSIZE - 1 ) ].errors;
+		r -> mtail.store( m + 1, std::memory_order_release );
+	}
+
+	if ( m != r -> mhead.load( std::memory_order_acquire ) && r -> marks[ m & ( MARKSIZE - 1 ) ].at - tail < count )
+		count = r -> marks[ m & ( MARKSIZE - 1 ) ].at - tail;
+	if ( count > max ) count = max;
+
+	at = tail & ( RINGSIZE - 1 );
+	first = ( count < RINGSIZE - at ) ? count : RINGSIZE - at;
+	memcpy( buf, r -> data + at, first );
+	memcpy( buf + first, r -> data, count - first );
+
+	r -> tail.store( tail + count, std::memory_order_release );
+	return( count );
+}
+
+
+//	Consumer: next byte with its error bits in the upper byte, -1 if the ring is empty.
+
+inline int ring_get( commring_t *r )
+{
+	unsigned char	c;
+	unsigned		errors;
+
+	return( ( ring_read( r, &c, 1, &errors ) ) ? (int) ( c | errors << 8 ) : -1 );
+}
+
+
+//	Consumer: take bytes into buf up to the first one in s, at most max of them.  That one is
+//	taken too but not stored, *delim gets it (-1 if it hasn't arrived, or max came first).
+//	Returns the bytes stored, *errors gets the error bits of the blocks they were in.  The
+//	ring is scanned where it lies, in at most two runs, not a byte at a time.
+
+inline uint32_t ring_take( commring_t *r, unsigned char *buf, uint32_t max, const scanset_t *s, int *delim, unsigned *errors )
+{
+	uint32_t	tail = r -> tail.load( std::memory_order_relaxed ), count, n = 0, at, run, k, m;
+
+	count = r -> head.load( std::memory_order_acquire ) - tail;
+	*delim = -1;
+	*errors = 0;
+
+	while ( n < max && n < count )
+	{
+		at = ( tail + n ) & ( RINGSIZE - 1 );
+		run = count - n;
+		if ( run > RINGSIZE - at ) run = RINGSIZE - at;
+		if ( run > max - n ) run = max - n;
+
+		k = (uint32_t) scan_find( s, r -> data + at, run );
+		memcpy( buf + n, r -> data + at, k );
+		n += k;
+		if ( k < run )
+		{
+			*delim = r -> data[ at + k ];
+			break;
+		}
+	}
+
+	count = n + ( *delim >= 0 );
+
+	while ( ( m = r -> mtail.load( std::memory_order_relaxed ) ) != r -> mhead.load( std::memory_order_acquire )
+			&& (int32_t) ( r -> marks[ m & ( MARKSIZE - 1 ) ].at - ( tail + count ) ) < 0 )
+	{
+		*errors |= r -> marks[ m & ( MARKSIZE - 1 ) ].errors;
+		r -> mtail.store( m + 1, std::memory_order_release );
+	}
+
+	r -> tail.store( tail + count, std::memory_order_release );
+	return( n );
+}
+
+
+//	Consumer: throw away everything received so far.
+
+inline void ring_discard( commring_t *r )
+{
+	uint32_t	head = r -> head.load( std::memory_order_acquire ), m;
+
+	while ( ( m = r -> mtail.load( std::memory_order_relaxed ) ) != r -> mhead.load( std::memory_order_acquire )
+			&& (int32_t) ( r -> marks[ m & ( MARKSIZE - 1 ) ].at - head ) < 0 )
+		r -> mtail.store( m + 1, std::memory_order_release );
+
+	r -> tail.store( head, std::memory_order_release );
+}
@@ -0,0 +1,192 @@
+//	==========================================================================================
+//	Byte scanning for receive data, 16 or 32 bytes at a time.
+//
+//	scan_find() finds the first byte of a block that's in a small set (the delimiters a reply
+//	ends with: LF, CR, ACK/NAK...), for framing lines out of a ring or a reader block without
+//	a strchr() per byte.  scan_ifind() is strstr() without regard to case (ASCII letters),
+//	what stristr() is built on.
+//
+//		scanset_t	s;
+//
+//		scan_set( &s, "\r\n", 2 );
+//		k = scan_find( &s, p, n );											n if none of p is CR or LF
+//
+//	The vector code is picked when the DLL is compiled: AVX2 where the compiler targets it
+//	(-mavx2, /arch:AVX2), else SSE2 (every x64 compiler), else a byte at a time.  Each gives
+//	the same answers.
+// ---------------------------------------------------------------------
+// Rev    Date      By     Description
+// -----  --------  -----  ---------------------------------------------
+//		  10/16/26	DV	   Original, replaces the strchr( delims, c ) per byte in cmdio()
+//	==========================================================================================
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if	defined( __AVX2__ )
+#include <immintrin.h>
+#define	SCAN_AVX2
+#define	SCAN_SSE2
+#elif	defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#include <emmintrin.h>
+#define	SCAN_SSE2
+#endif
+
+#ifdef	_MSC_VER
+#include <intrin.h>
+#endif
+
+#define	SCAN_BYTES		4														//	set bytes compared in the vector loop, more go a byte at a time
+
+typedef struct
+{
+	uint8_t			in[ 256 ];													//	1 for the bytes in the set
+	unsigned char	c[ SCAN_BYTES ];											//	the set, the first repeated to fill it
+	int				n;															//	bytes in the set
+} scanset_t;
+
+
+//	The set of n bytes of p (NULs count, "\n" with n 2 is LF and NUL, as strchr() matched them).
+
+inline void scan_set( scanset_t *s, const char *p, int n )
+{
+	memset( s -> in, 0, sizeof( s -> in ) );
+	s -> n = 0;
+
+	for ( int i = 0; i < n; i ++ )
+	{
+		if ( s -> in[ (unsigned char) p[ i ] ] ) continue;
+		s -> in[ (unsigned char) p[ i ] ] = 1;
+		if ( s -> n < SCAN_BYTES ) s -> c[ s -> n ] = (unsigned char) p[ i ];
+		s -> n ++;
+	}
+
+	for ( int i = ( s -> n < SCAN_BYTES ) ? s -> n : SCAN_BYTES; i < SCAN_BYTES; i ++ )
+		s -> c[ i ] = s -> c[ 0 ];
+}
+
+
+//	Lowest set bit of a nonzero compare mask.
+
+inline int scan_ctz( uint32_t m )
+{
+#ifdef	_MSC_VER
+	unsigned long	i;
+
+	_BitScanForward( &i, m );
+	return( (int) i );
+#else
+	return( __builtin_ctz( m ) );
+#endif
+}
+
+
+//	Index of the first of n bytes of p that's in s, n if there isn't one.
+
+inline size_t scan_find( const scanset_t *s, const unsigned char *p, size_t n )
+{
+	size_t		i = 0;
+	uint32_t	m;
+
+	if ( s -> n == 0 ) return( n );
+
+	if ( s -> n <= SCAN_BYTES )
+	{
+#ifdef	SCAN_AVX2
+		const __m256i	c0 = _mm256_set1_epi8( (char) s -> c[ 0 ] ), c1 = _mm256_set1_epi8( (char) s -> c[ 1 ] );
+		const __m256i	c2 = _mm256_set1_epi8( (char) s -> c[ 2 ] ), c3 = _mm256_set1_epi8( (char) s -> c[ 3 ] );
+
+		for ( ; i + 32 <= n; i += 32 )
+		{
+			__m256i		x = _mm256_loadu_si256( (const __m256i *) ( p + i ) );
+
+			m = (uint32_t) _mm256_movemask_epi8( _mm256_or_si256( _mm256_or_si256( _mm256_cmpeq_epi8( x, c0 ), _mm256_cmpeq_epi8( x, c1 ) ),
+																 _mm256_or_si256( _mm256_cmpeq_epi8( x, c2 ), _mm256_cmpeq_epi8( x, c3 ) ) ) );
+			if ( m ) return( i + scan_ctz( m ) );
+		}
+#endif
+#ifdef	SCAN_SSE2
+		const __m128i	d0 = _mm_set1_epi8( (char) s -> c[ 0 ] ), d1 = _mm_set1_epi8( (char) s -> c[ 1 ] );
+		const __m128i	d2 = _mm_set1_epi8( (char) s -> c[ 2 ] ), d3 = _mm_set1_epi8( (char) s -> c[ 3 ] );
+
+		for ( ; i + 16 <= n; i += 16 )
+		{
+			__m128i		x = _mm_loadu_si128( (const __m128i *) ( p + i ) );
+
+			m = (uint32_t) _mm_movemask_epi8( _mm_or_si128( _mm_or_si128( _mm_cmpeq_epi8( x, d0 ), _mm_cmpeq_epi8( x, d1 ) ),
+														   _mm_or_si128( _mm_cmpeq_epi8( x, d2 ), _mm_cmpeq_epi8( x, d3 ) ) ) );
+			if ( m ) return( i + scan_ctz( m ) );
+		}
+#endif
+	}
+
+	for ( ; i < n; i ++ )
+		if ( s -> in[ p[ i ] ] ) return( i );
+	return( n );
+}
+
+
+inline unsigned char scan_upper( unsigned char c )
+{
+	return( ( c >= 'a' && c <= 'z' ) ? c - ( 'a' - 'A' ) : c );
+}
+
+
+//	m bytes of q, ignoring the case of the letters, equal?
+
+inline bool scan_iequal( const unsigned char *p, const unsigned char *q, size_t m )
+{
+	for ( size_t i = 0; i < m; i ++ )
+		if ( scan_upper( p[ i ] ) != scan_upper( q[ i ] ) ) return( false );
+	return( true );
+}
+
+
+//	The first place m bytes of q are in n bytes of p, ignoring the case of the letters, NULL if
+//	they aren't.  The vector loop looks for q's first and last bytes, in either case, m - 1
+//	apart, and only compares the whole of q where both are.
+
+inline const char *scan_ifind( const char *p, size_t n, const char *q, size_t m )
+{
+	const unsigned char	*s = (const unsigned char *) p, *t = (const unsigned char *) q;
+	unsigned char		first, last;
+	size_t				i = 0;
+
+	if ( m == 0 ) return( p );
+	if ( m > n ) return( NULL );
+
+	first = scan_upper( t[ 0 ] );
+	last = scan_upper( t[ m - 1 ] );
+
+#ifdef	SCAN_SSE2
+	{
+		const __m128i	f0 = _mm_set1_epi8( (char) first ), f1 = _mm_set1_epi8( (char) ( ( first >= 'A' && first <= 'Z' ) ? first + ( 'a' - 'A' ) : first ) );
+		const __m128i	l0 = _mm_set1_epi8( (char) last ), l1 = _mm_set1_epi8( (char) ( ( last >= 'A' && last <= 'Z' ) ? last + ( 'a' - 'A' ) : last ) );
+		uint32_t		k;
+
+		for ( ; i + m - 1 + 16 <= n; i += 16 )
+		{
+			__m128i		a = _mm_loadu_si128( (const __m128i *) ( s + i ) );
+			__m128i		b = _mm_loadu_si128( (const __m128i *) ( s + i + m - 1 ) );
+
+			k = (uint32_t) _mm_movemask_epi8( _mm_and_si128( _mm_or_si128( _mm_cmpeq_epi8( a, f0 ), _mm_cmpeq_epi8( a, f1 ) ),
+															_mm_or_si128( _mm_cmpeq_epi8( b, l0 ), _mm_cmpeq_epi8( b, l1 ) ) ) );
+			while ( k )
+			{
+				int		j = scan_ctz( k );
+
+				if ( scan_iequal( s + i + j + 1, t + 1, ( m >= 2 ) ? m - 2 : 0 ) ) return( p + i + j );
+				k &= k - 1;
+			}
+		}
+	}
+#endif
+
+	for ( ; i + m <= n; i ++ )
+		if ( scan_upper( s[ i ] ) == first && scan_upper( s[ i + m - 1 ] ) == last && scan_iequal( s + i + 1, t + 1, ( m >= 2 ) ? m - 2 : 0 ) )
+			return( p + i );
+	return( NULL );
+}
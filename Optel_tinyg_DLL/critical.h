@@ -1,5 +1,7 @@
 // critical_section.h
 #pragma once
-#include <Windows.h>
+#include "portcompat.h"
 
-extern CRITICAL_SECTION cmdio_critical_section;
\ No newline at end of file
+//	10/16/2026 -- one per port index (NUMCOMPORT), cmdio() holds the selected port's
+
+extern CRITICAL_SECTION cmdio_critical_section[];
\ No newline at end of file
@@ -1,34 +1,112 @@
 #pragma once
+#include <stdint.h>
+#include "portcompat.h"
 #include "optel_tinyg_dll.h"
+#include "tgaxes.h"
+
+#ifndef	_WIN32
+#define	__declspec(x)																//	shared library symbols are visible by default
+#endif
 
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-#define	MM			( 4 )														//	# motors supported
+#define	MM			( TG_AXES )													//	# motors supported, 4 or 6 (tgaxes.h)
+#define	TG_GROUPMAX	( 8 )														//	# boards in a group move
+
+typedef int64_t	( *tg_clock_t )( void );										//	a clock for tg_clock(), monotonic ns
+
+//	One board's part of a group move (tg_group_move()): the device (NULL for the default one),
+//	which of its motors move, and where to.
+
+typedef struct
+{
+	tg_device	*dev;
+	bool		move[ MM ];
+	double		pos[ MM ];
+} tg_target_t;
 
 #ifdef EXPORTING_DLL
 	extern __declspec( dllexport ) double  tg_version( void );						//	return DLL version as x.xxx
+	extern __declspec( dllexport ) int tg_axes( void );								//	the MM the DLL was built with
 //	extern __declspec( dllexport ) const char *tg_mname[ MM ];						//	motor names
 	extern __declspec( dllexport ) bool tg_getpos( double pos[ MM ] );				//	retrieve current motor positions
+	extern __declspec( dllexport ) bool tg_getpos_ex( double pos[ MM ], double *agems );	//	positions from the last status report, and its age in ms
 	extern __declspec( dllexport ) bool tg_home( bool home[ MM ], int tosec );		//	home specified motors, wait up to tosec seconds
+	extern __declspec( dllexport ) void tg_home_combined( bool on );					//	tg_home() homes all its motors in one g28.2 cycle
 	extern __declspec( dllexport ) bool tg_move( bool move[ MM ], double pos[ MM ], int tosec );	//	move named motors to pos, wait up to tosec
+	extern __declspec( dllexport ) void tg_move_tolerance( double tol );					//	how close a move has to get to be done (0.0005)
+	extern __declspec( dllexport ) bool tg_rtt( tg_device *dev, double *rttms, double *waitms );	//	the round trip timed so far on dev, and the reply wait it gives
+	extern __declspec( dllexport ) void tg_clock( tg_clock_t now );							//	time timeouts on now() instead of the steady clock, NULL for it again
 	extern __declspec( dllexport ) bool tg_getranges( tg_range_t mrange[ MM ] );	//	retrieve all motor ranges
 	extern __declspec( dllexport ) void tg_comm( char *msg );						//	activate interactive communication mode (w/TinyG)
 	extern __declspec( dllexport ) BOOL tg_open_ports();						    //	open ports
 	extern __declspec( dllexport ) void tg_close_ports();						    //	close ports
+	extern __declspec( dllexport ) bool tg_connect_async( void );						//	start opening the ports in the background
+	extern __declspec( dllexport ) int tg_connect_wait( int tosec );						//	wait for tg_connect_async(): 1, 0 or TG_PENDING
+	extern __declspec( dllexport ) tg_device *tg_open( const char *id );					//	open another TinyG: its port, or a filter ("SN D30A")
+	extern __declspec( dllexport ) void tg_close( tg_device *dev );						//	close a device tg_open() opened
+	extern __declspec( dllexport ) bool tg_dev_getpos( tg_device *dev, double pos[ MM ] );	//	the calls above on a device, NULL for the default one
+	extern __declspec( dllexport ) bool tg_dev_getpos_ex( tg_device *dev, double pos[ MM ], double *agems );
+	extern __declspec( dllexport ) bool tg_dev_home( tg_device *dev, bool home[ MM ], int tosec );
+	extern __declspec( dllexport ) bool tg_dev_move( tg_device *dev, bool move[ MM ], double pos[ MM ], int tosec );
+	extern __declspec( dllexport ) bool tg_dev_getranges( tg_device *dev, tg_range_t mrange[ MM ] );
+	extern __declspec( dllexport ) bool tg_dev_json( tg_device *dev, bool on );
+	extern __declspec( dllexport ) bool tg_dev_stream_open( tg_device *dev );
+	extern __declspec( dllexport ) bool tg_dev_stream_push( tg_device *dev, const char *gcode, int tosec );
+	extern __declspec( dllexport ) bool tg_dev_stream_drain( tg_device *dev, int tosec );
+	extern __declspec( dllexport ) bool tg_group_move( tg_target_t targets[ ], int n, int tosec, double *skewms );	//	move the motors of several boards together, wait for them all
+	extern __declspec( dllexport ) bool tg_json( bool on );						//	use the JSON protocol ($ej=1) or text reports
+	extern __declspec( dllexport ) bool tg_stream_open( void );						//	start streaming gcode
+	extern __declspec( dllexport ) bool tg_stream_push( const char *gcode, int tosec );	//	send a gcode line when the planner has room, wait up to tosec
+	extern __declspec( dllexport ) bool tg_stream_drain( int tosec );					//	wait for the streamed lines to run, end the stream
+	extern __declspec( dllexport ) int tg_move_async( bool move[ MM ], double pos[ MM ], int tosec, tg_done_t done, void *ctx );	//	tg_move() on the worker thread, returns the request or 0
+	extern __declspec( dllexport ) int tg_home_async( bool home[ MM ], int tosec, tg_done_t done, void *ctx );	//	tg_home() on the worker thread, returns the request or 0
+	extern __declspec( dllexport ) int tg_dev_move_async( tg_device *dev, bool move[ MM ], double pos[ MM ], int tosec, tg_done_t done, void *ctx );	//	the same on a device, NULL for the default one
+	extern __declspec( dllexport ) int tg_dev_home_async( tg_device *dev, bool home[ MM ], int tosec, tg_done_t done, void *ctx );
+	extern __declspec( dllexport ) int tg_wait( int request, int tosec );				//	wait for a request without a callback: 1, 0, TG_PENDING or TG_UNKNOWN
 
 #else
 	extern __declspec( dllimport ) double  tg_version( void );						//	return DLL version as x.xxx
+	extern __declspec( dllimport ) int tg_axes( void );								//	the MM the DLL was built with
 	extern __declspec( dllimport ) const char *tg_mname[ MM ];						//	motor names
 	extern __declspec( dllimport ) bool tg_getpos( double pos[ MM ] );				//	retrieve current motor positions
+	extern __declspec( dllimport ) bool tg_getpos_ex( double pos[ MM ], double *agems );	//	positions from the last status report, and its age in ms
 	extern __declspec( dllimport ) bool tg_home( bool home[ MM ], int tosec );		//	home specified motors, wait up to tosec seconds
+	extern __declspec( dllimport ) void tg_home_combined( bool on );					//	tg_home() homes all its motors in one g28.2 cycle
 	extern __declspec( dllimport ) bool tg_move( bool move[ MM ], double pos[ MM ], int tosec );	//	move named motors to pos, wait up to tosec
+	extern __declspec( dllimport ) void tg_move_tolerance( double tol );					//	how close a move has to get to be done (0.0005)
+	extern __declspec( dllimport ) bool tg_rtt( tg_device *dev, double *rttms, double *waitms );	//	the round trip timed so far on dev, and the reply wait it gives
+	extern __declspec( dllimport ) void tg_clock( tg_clock_t now );							//	time timeouts on now() instead of the steady clock, NULL for it again
 	extern __declspec( dllimport ) bool tg_getranges( tg_range_t mrange[ MM ] );	//	retrieve all motor ranges
 	extern __declspec( dllimport ) void tg_comm( char *msg );						//	activate interactive communication mode (w/TinyG)
 	extern __declspec( dllimport ) BOOL tg_open_ports();						    //	open ports
 	extern __declspec( dllimport ) void tg_close_ports();						    //	close ports
+	extern __declspec( dllimport ) bool tg_connect_async( void );						//	start opening the ports in the background
+	extern __declspec( dllimport ) int tg_connect_wait( int tosec );						//	wait for tg_connect_async(): 1, 0 or TG_PENDING
+	extern __declspec( dllimport ) tg_device *tg_open( const char *id );					//	open another TinyG: its port, or a filter ("SN D30A")
+	extern __declspec( dllimport ) void tg_close( tg_device *dev );						//	close a device tg_open() opened
+	extern __declspec( dllimport ) bool tg_dev_getpos( tg_device *dev, double pos[ MM ] );	//	the calls above on a device, NULL for the default one
+	extern __declspec( dllimport ) bool tg_dev_getpos_ex( tg_device *dev, double pos[ MM ], double *agems );
+	extern __declspec( dllimport ) bool tg_dev_home( tg_device *dev, bool home[ MM ], int tosec );
+	extern __declspec( dllimport ) bool tg_dev_move( tg_device *dev, bool move[ MM ], double pos[ MM ], int tosec );
+	extern __declspec( dllimport ) bool tg_dev_getranges( tg_device *dev, tg_range_t mrange[ MM ] );
+	extern __declspec( dllimport ) bool tg_dev_json( tg_device *dev, bool on );
+	extern __declspec( dllimport ) bool tg_dev_stream_open( tg_device *dev );
+	extern __declspec( dllimport ) bool tg_dev_stream_push( tg_device *dev, const char *gcode, int tosec );
+	extern __declspec( dllimport ) bool tg_dev_stream_drain( tg_device *dev, int tosec );
+	extern __declspec( dllimport ) bool tg_group_move( tg_target_t targets[ ], int n, int tosec, double *skewms );	//	move the motors of several boards together, wait for them all
+	extern __declspec( dllimport ) bool tg_json( bool on );						//	use the JSON protocol ($ej=1) or text reports
+	extern __declspec( dllimport ) bool tg_stream_open( void );						//	start streaming gcode
+	extern __declspec( dllimport ) bool tg_stream_push( const char *gcode, int tosec );	//	send a gcode line when the planner has room, wait up to tosec
+	extern __declspec( dllimport ) bool tg_stream_drain( int tosec );					//	wait for the streamed lines to run, end the stream
+	extern __declspec( dllimport ) int tg_move_async( bool move[ MM ], double pos[ MM ], int tosec, tg_done_t done, void *ctx );	//	tg_move() on the worker thread, returns the request or 0
+	extern __declspec( dllimport ) int tg_home_async( bool home[ MM ], int tosec, tg_done_t done, void *ctx );	//	tg_home() on the worker thread, returns the request or 0
+	extern __declspec( dllimport ) int tg_dev_move_async( tg_device *dev, bool move[ MM ], double pos[ MM ], int tosec, tg_done_t done, void *ctx );	//	the same on a device, NULL for the default one
+	extern __declspec( dllimport ) int tg_dev_home_async( tg_device *dev, bool home[ MM ], int tosec, tg_done_t done, void *ctx );
+	extern __declspec( dllimport ) int tg_wait( int request, int tosec );				//	wait for a request without a callback: 1, 0, TG_PENDING or TG_UNKNOWN
 #endif
 
 #ifdef	__cplusplus
@@ -11,3 +11,16 @@ typedef struct
 	double	min, max;
 } tg_range_t;
 
+//	A TinyG board opened with tg_open(), for the tg_dev_ calls.  The calls without one work on
+//	the default device, the one tg_open_ports() opens.
+
+typedef struct tg_device tg_device;
+
+//	Asynchronous requests (tg_move_async(), tg_home_async()): the callback gets the request's
+//	number, whether it worked, and the ctx it was given.  tg_wait() returns 1 or 0 for a
+//	request that's done, or one of these.
+
+typedef void (*tg_done_t)( int request, bool ok, void *ctx );
+
+#define	TG_PENDING	( -1 )														//	still queued or running (or connecting, tg_connect_wait())
+#define	TG_UNKNOWN	( -2 )														//	no such request (or it has a callback)
@@ -0,0 +1,142 @@
+//	==========================================================================================
+//	Windows types and the few WIN32 calls shared by the communication and TinyG modules.
+//	Under WIN32 this simply includes windows.h.  Elsewhere (Linux, other POSIX systems) it
+//	defines just enough of the same names so win32comm.h, critical.h and the DLL sources
+//	compile unchanged against posixcomm.cpp.
+// ---------------------------------------------------------------------
+// Rev    Date      By     Description
+// -----  --------  -----  ---------------------------------------------
+//		  10/16/26	DV	   Original, for the POSIX termios backend.
+//	==========================================================================================
+
+#pragma once
+
+#ifdef	_WIN32
+#include <windows.h>
+#else
+
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+typedef int				BOOL;
+typedef unsigned char	BYTE;
+typedef unsigned short	WORD;
+typedef uint32_t		DWORD;
+
+#ifndef	TRUE
+#define	TRUE			1
+#define	FALSE			0
+#endif
+#define	MAXDWORD		0xFFFFFFFF
+
+//	Device control block, laid out like the WIN32 one so the positional initializers work.
+
+typedef struct _DCB
+{
+	DWORD	DCBlength;															// sizeof(DCB)
+	DWORD	BaudRate;															// current baud rate
+	DWORD	fBinary: 1;															// binary mode, no EOF check
+	DWORD	fParity: 1;															// enable parity checking
+	DWORD	fOutxCtsFlow: 1;													// CTS output flow control
+	DWORD	fOutxDsrFlow: 1;													// DSR output flow control
+	DWORD	fDtrControl: 2;														// DTR flow control type
+	DWORD	fDsrSensitivity: 1;													// DSR sensitivity
+	DWORD	fTXContinueOnXoff: 1;												// XOFF continues Tx
+	DWORD	fOutX: 1;															// XON/XOFF out flow control
+	DWORD	fInX: 1;															// XON/XOFF in flow control
+	DWORD	fErrorChar: 1;														// enable error replacement
+	DWORD	fNull: 1;															// enable null stripping
+	DWORD	fRtsControl: 2;														// RTS flow control
+	DWORD	fAbortOnError: 1;													// abort reads/writes on error
+	DWORD	fDummy2: 17;														// reserved
+	WORD	wReserved;															// not currently used
+	WORD	XonLim;																// transmit XON threshold
+	WORD	XoffLim;															// transmit XOFF threshold
+	BYTE	ByteSize;															// number of bits/byte, 4-8
+	BYTE	Parity;																// 0-4=no,odd,even,mark,space
+	BYTE	StopBits;															// 0,1,2 = 1, 1.5, 2
+	char	XonChar;															// Tx and Rx XON character
+	char	XoffChar;															// Tx and Rx XOFF character
+	char	ErrorChar;															// error replacement character
+	char	EofChar;															// end of input character
+	char	EvtChar;															// received event character
+	WORD	wReserved1;															// reserved; do not use
+} DCB;
+
+#define	NOPARITY				0
+#define	ODDPARITY				1
+#define	EVENPARITY				2
+#define	MARKPARITY				3
+#define	SPACEPARITY				4
+
+#define	ONESTOPBIT				0
+#define	ONE5STOPBITS			1
+#define	TWOSTOPBITS				2
+
+#define	DTR_CONTROL_DISABLE		0
+#define	DTR_CONTROL_ENABLE		1
+#define	DTR_CONTROL_HANDSHAKE	2
+
+#define	RTS_CONTROL_DISABLE		0
+#define	RTS_CONTROL_ENABLE		1
+#define	RTS_CONTROL_HANDSHAKE	2
+#define	RTS_CONTROL_TOGGLE		3
+
+//	Receive error bits, returned in the upper byte of getbyte()
+
+#define	CE_RXOVER				0x0001
+#define	CE_OVERRUN				0x0002
+#define	CE_RXPARITY				0x0004
+#define	CE_FRAME				0x0008
+#define	CE_BREAK				0x0010
+
+//	Device capabilities (see getcomprop()), same fields as WIN32.
+
+typedef struct _COMMPROP
+{
+	WORD	wPacketLength;
+	WORD	wPacketVersion;
+	DWORD	dwServiceMask;
+	DWORD	dwReserved1;
+	DWORD	dwMaxTxQueue;
+	DWORD	dwMaxRxQueue;
+	DWORD	dwMaxBaud;
+	DWORD	dwProvSubType;
+	DWORD	dwProvCapabilities;
+	DWORD	dwSettableParams;
+	DWORD	dwSettableBaud;
+	WORD	wSettableData;
+	WORD	wSettableStopParity;
+	DWORD	dwCurrentTxQueue;
+	DWORD	dwCurrentRxQueue;
+	DWORD	dwProvSpec1;
+	DWORD	dwProvSpec2;
+	wchar_t	wcProvChar[ 1 ];
+} COMMPROP, *LPCOMMPROP;
+
+inline void Sleep( DWORD ms )
+{
+	usleep( (useconds_t) ms * 1000 );
+}
+
+//	Critical sections are recursive mutexes, just like WIN32.
+
+typedef pthread_mutex_t	CRITICAL_SECTION;
+
+inline void InitializeCriticalSection( CRITICAL_SECTION *cs )
+{
+	pthread_mutexattr_t	attr;
+
+	pthread_mutexattr_init( &attr );
+	pthread_mutexattr_settype( &attr, PTHREAD_MUTEX_RECURSIVE );
+	pthread_mutex_init( cs, &attr );
+	pthread_mutexattr_destroy( &attr );
+}
+
+inline void DeleteCriticalSection( CRITICAL_SECTION *cs )	{ pthread_mutex_destroy( cs ); }
+inline void EnterCriticalSection( CRITICAL_SECTION *cs )	{ pthread_mutex_lock( cs ); }
+inline void LeaveCriticalSection( CRITICAL_SECTION *cs )	{ pthread_mutex_unlock( cs ); }
+
+#endif
@@ -0,0 +1,1990 @@
+// ==============================================================================================================
+//	POSIX twin of win32comm.cpp.  Everything declared in win32comm.h is implemented here with termios,
+//	non-blocking file descriptors and epoll, so the TinyG DLL sources build and run on Linux -- against a real
+//	FTDI adapter, or against a pty when benchmarking.
+//
+//	Ports are still addressed by COM number (openport( 0 ) opens COM1).  findserialports() hands out COM
+//	numbers to /dev/ttyUSB* and /dev/ttyACM* devices the first time it sees them, and mapport() binds a COM
+//	number to any other tty.
+//
+//	Timeouts keep their clock() units (CLOCKS_PER_SEC per second) so callers don't change, but they're
+//	measured with the monotonic clock as deadlines (tgclock.h): on Linux clock() is CPU time and doesn't
+//	advance while we wait.
+//	Receive loops never spin on charin(), they sleep in epoll_wait() on the port until data arrives.
+// --------------------------------------------------------------------------------------------------------------
+// Rev		Date		By		Description
+// -----	--------	------	---------------------------------------------------------------------------------
+//			10/16/2026	DV		readavail(): what's arrived a block at a time, with the errors of its block.
+//								getbyte() is built on it and readstr() on ring_take().  rxcounts() counts
+//								the reader's read()s and their bytes.  setrxgap(): after a short block that
+//								doesn't end a message the reader naps for the rest of a gap of so many byte
+//								times, so a reply that trickles in comes in a few reads, not one per byte.
+// -----	--------	------	---------------------------------------------------------------------------------
+//			10/16/2026	DV		cmdio() takes what's waiting up to its delimiter with ring_take(), which scans
+//								the ring 16 or 32 bytes at a time (commscan.h), instead of a getbyte() and a
+//								strchr() per byte.
+// -----	--------	------	---------------------------------------------------------------------------------
+//			10/16/2026	DV		waitfor() feeds a multi-pattern matcher (commmatch.h) each byte once, no
+//								window is shifted.  The block waitfor()s keep what came before the match,
+//								store only what fits and fail on a nak or a timeout, not on a full buffer.
+// -----	--------	------	---------------------------------------------------------------------------------
+//			10/16/2026	DV		A reader with a full ring waits on an eventfd getbyte() signals when it makes
+//								room, instead of checking every ms.
+// -----	--------	------	---------------------------------------------------------------------------------
+//			10/16/2026	DV		Waits run to a tgdeadline_t (tgclock.h) instead of ticks() arithmetic, and
+//								rxwait() sleeps in ppoll() to the ns rather than to the next ms.
+// -----	--------	------	---------------------------------------------------------------------------------
+//			10/16/2026	DV		Several ports from several threads: selport is per thread, cmdio() holds the
+//								selected port's lock (critical.h) rather than one for all ports, opening and
+//								closing is serialized, and a closed port's slot is reused.  setrxtap() takes
+//								a context for the tap.
+// -----	--------	------	---------------------------------------------------------------------------------
+//			10/16/2026	DV		commenum(): the USB serial ports with their ids, from sysfs and /dev/serial/by-id.
+// -----	--------	------	---------------------------------------------------------------------------------
+//			10/16/2026	DV		setrxtap(): a callback the reader hands each block to before it's queued.
+// -----	--------	------	---------------------------------------------------------------------------------
+//			10/16/2026	DV		A reader thread per port drains the tty in blocks into a lock-free ring
+//								(commring.h).  charin()/getbyte() read the ring, waits sleep on an eventfd
+//								the reader signals.
+// -----	--------	------	---------------------------------------------------------------------------------
+//			10/16/2026	DV		Original, converted from win32comm.cpp.
+// ==============================================================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <limits.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <mutex>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#ifdef	__linux__
+#include <linux/serial.h>														//	TIOCGICOUNT error counters
+#endif
+
+#include "win32comm.h"
+#include "stristr.h"
+#include "Win32Trace.h"
+#include "critical.h"
+#include "commmatch.h"
+#include "commring.h"
+#include "tgclock.h"
+#include "KEYS.H"
+
+
+thread_local	int			selport = -1;										// which port (index) this thread has active -- default to none (for getport())
+static	volatile int		openedports = 0;									// # of registered COM ports (the ports may not be open if they have been disconnected)
+static	int					closeportsflag = 0;									// to tell us we're registered closeports
+static	volatile bool		closing = false;
+static	std::recursive_mutex	portlist;										// openport(), closeport() & closeports() change the tables
+
+
+DCB		defaultsettings =
+{
+	sizeof( defaultsettings ),													// sizeof(DCB)
+	9600,																		// current baud rate
+	1,																			// binary mode, no EOF check
+	0,																			// enable parity checking
+	0,																			// CTS output flow control
+	0,																			// DSR output flow control
+	0,																			// DTR flow control type
+	0,																			// DSR sensitivity
+	0,																			// XOFF continues Tx
+	0,																			// XON/XOFF out flow control
+	0,																			// XON/XOFF in flow control
+	0,																			// enable error replacement
+	0,																			// enable null stripping
+	0,																			// RTS flow control
+	1,																			// abort reads/writes on error
+	0,																			// reserved
+	0,																			// not currently used
+	0,																			// transmit XON threshold
+	0,																			// transmit XOFF threshold
+	8,																			// number of bits/byte, 4-8
+	0,																			// parity: 0-4=no,odd,even,mark,space
+	0,																			// stop bits: 0,1,2 = 1, 1.5, 2
+	0,																			// Tx and Rx XON character
+	0,																			// Tx and Rx XOFF character
+	0,																			// error replacement character
+	0,																			// end of input character
+	0,																			// received event character
+	0
+};																				// reserved; do not use
+
+
+//	Modem input signal names, in bit order from 0.
+
+char *portsignames[ 8 ] =
+{
+	(char *) "DTR",																//	bit 0- output
+	(char *) "RTS",																//		1- output
+	(char *) "B2",
+	(char *) "B3",
+	(char *) "CTS",																//		4
+	(char *) "DSR",
+	(char *) "RI",
+	(char *) "CD"
+};
+
+
+//	Same per-port tables as win32comm.cpp, indexed by the order ports were opened.  The file descriptor
+//	replaces the HANDLE.  Each port's reader thread waits in its own epoll instance for receive data
+//	or a stop request, and the receive ring replaces readahead[].
+
+char portnames[ NUMCOMPORT ][ 64 ];												// device paths of the ports we can simultaneously open
+int portfd[ NUMCOMPORT ] = { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 };			// open file descriptors
+int portepoll[ NUMCOMPORT ] = { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 };		// epoll descriptor the reader waits in
+int portnumbers[ NUMCOMPORT ] = { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 };		// numbers of the opened ports
+DCB portprams[ NUMCOMPORT ];													//	parameters for each port
+bool pstate[ NUMCOMPORT ] = { false, false, false, false, false, false, false, false, false, false };	//	port disconnect states
+bool pinit[ NUMCOMPORT ] = { false, false, false, false, false, false, false, false, false, false };	//	port parameters have been changed
+
+static char comports[ MAXCOMPORTNUMBER + 1 ][ 64 ];							//	device path for each COM number, "" if unassigned
+
+static commring_t			rxring[ NUMCOMPORT ];								//	received data
+static pthread_t			rxthread[ NUMCOMPORT ];								//	reader threads
+static int					rxstop[ NUMCOMPORT ] = { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 };	//	eventfd, tells the reader to quit
+static int					rxevent[ NUMCOMPORT ] = { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 };	//	eventfd, the reader wakes a waiting consumer
+static std::atomic<bool>	rxwaiting[ NUMCOMPORT ];							//	the consumer is waiting on rxevent
+static int					rxroom[ NUMCOMPORT ] = { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 };	//	eventfd, the consumer wakes a reader with a full ring
+static std::atomic<bool>	rxfull[ NUMCOMPORT ];								//	the reader is waiting on rxroom
+static std::atomic<bool>	rxdead[ NUMCOMPORT ];								//	the reader saw the device go away
+static std::atomic<rxtap_t>	rxtap[ NUMCOMPORT ];								//	setrxtap() callbacks
+static std::atomic<void *>	rxtapctx[ NUMCOMPORT ];								//	and their contexts
+static std::atomic<unsigned long>	rxreads[ NUMCOMPORT ], rxbytes[ NUMCOMPORT ];	//	read()s that returned data, and the bytes, for rxcounts()
+static std::atomic<int>		rxgap[ NUMCOMPORT ];								//	setrxgap() byte times, 0 to read each byte as it comes
+static std::atomic<long>	rxbytens[ NUMCOMPORT ];								//	ns a byte takes at the port's baud rate
+
+
+//	Baud rates termios knows about.
+
+static const struct
+{
+	DWORD	baud;
+	speed_t	code;
+}	baudcodes[] =
+{
+	{ 300, B300 }, { 600, B600 }, { 1200, B1200 }, { 2400, B2400 }, { 4800, B4800 }, { 9600, B9600 },
+	{ 19200, B19200 }, { 38400, B38400 }, { 57600, B57600 }, { 115200, B115200 }, { 230400, B230400 },
+#ifdef	B460800
+	{ 460800, B460800 },
+#endif
+#ifdef	B921600
+	{ 921600, B921600 },
+#endif
+#ifdef	B1000000
+	{ 1000000, B1000000 },
+#endif
+#ifdef	B2000000
+	{ 2000000, B2000000 },
+#endif
+#ifdef	B3000000
+	{ 3000000, B3000000 },
+#endif
+	{ 0, B0 }
+};
+
+
+//	Configure fd from a DCB.  Only the fields that mean something to termios are used.
+//	Returns 0 or an errno value.
+
+static int applyparams( int fd, DCB *p )
+{
+	struct termios	t;
+	speed_t			speed = B0;
+	int				sig;
+
+	if ( tcgetattr( fd, &t ) ) return( errno );
+
+	for ( int i = 0; baudcodes[ i ].baud; i ++ )
+		if ( baudcodes[ i ].baud == p -> BaudRate ) speed = baudcodes[ i ].code;
+
+	if ( speed == B0 ) return( EINVAL );
+
+	cfmakeraw( &t );
+	cfsetispeed( &t, speed );
+	cfsetospeed( &t, speed );
+
+	t.c_cflag |= CLOCAL | CREAD;
+	t.c_cflag &= ~( CSIZE | PARENB | PARODD | CSTOPB | CRTSCTS );
+#ifdef	CMSPAR
+	t.c_cflag &= ~CMSPAR;
+#endif
+
+	switch ( p -> ByteSize )
+	{
+	case 5:		t.c_cflag |= CS5;	break;
+	case 6:		t.c_cflag |= CS6;	break;
+	case 7:		t.c_cflag |= CS7;	break;
+	default:	t.c_cflag |= CS8;
+	}
+
+	switch ( p -> Parity )
+	{
+	case ODDPARITY:		t.c_cflag |= PARENB | PARODD;	break;
+	case EVENPARITY:	t.c_cflag |= PARENB;			break;
+#ifdef	CMSPAR
+	case MARKPARITY:	t.c_cflag |= PARENB | PARODD | CMSPAR;	break;
+	case SPACEPARITY:	t.c_cflag |= PARENB | CMSPAR;	break;
+#endif
+	default:			;
+	}
+
+	if ( p -> fParity ) t.c_iflag |= INPCK;
+	if ( p -> StopBits != ONESTOPBIT ) t.c_cflag |= CSTOPB;						//	1.5 stop bits becomes 2
+	if ( p -> fOutxCtsFlow || p -> fRtsControl == RTS_CONTROL_HANDSHAKE ) t.c_cflag |= CRTSCTS;
+
+	t.c_iflag &= ~( IXON | IXOFF | IXANY );
+	if ( p -> fOutX ) t.c_iflag |= IXON;
+	if ( p -> fInX ) t.c_iflag |= IXOFF;
+
+	//	With VMIN 1 an empty non-blocking read fails with EAGAIN, so read() returning 0 can only
+	//	mean the device hung up.  (With VMIN 0 it returns 0 either way.)  We wait in epoll, and
+	//	each read() takes all the driver has.  Bigger VMINs or a VTIME would only batch blocking
+	//	reads, and a VTIME holds each reply back a tenth of a second at least.  The reader batches
+	//	with a gap in byte times instead, setrxgap().
+
+	t.c_cc[ VMIN ] = 1;
+	t.c_cc[ VTIME ] = 0;
+
+	if ( tcsetattr( fd, TCSANOW, &t ) ) return( errno );
+
+	//	Output signals.  Failures are ignored, a pty has no modem lines.
+
+	sig = TIOCM_DTR;
+	ioctl( fd, ( p -> fDtrControl == DTR_CONTROL_DISABLE ) ? TIOCMBIC : TIOCMBIS, &sig );
+
+	if ( p -> fRtsControl != RTS_CONTROL_HANDSHAKE )
+	{
+		sig = TIOCM_RTS;
+		ioctl( fd, ( p -> fRtsControl == RTS_CONTROL_DISABLE ) ? TIOCMBIC : TIOCMBIS, &sig );
+	}
+	return( 0 );
+}
+
+
+//	Close port index i's descriptors and mark it disconnected.  It stays registered so charin() & co.
+//	can reopen it when the device comes back.
+
+static void dropport( int i )
+{
+	uint64_t	one = 1;
+
+	if ( rxstop[ i ] >= 0 )
+	{
+		if ( write( rxstop[ i ], &one, sizeof( one ) ) != sizeof( one ) ) TRACE( (char *) "reader stop failed\n" );
+		pthread_join( rxthread[ i ], NULL );
+		close( rxstop[ i ] );
+		close( rxevent[ i ] );
+		close( rxroom[ i ] );
+	}
+	if ( portepoll[ i ] >= 0 ) close( portepoll[ i ] );
+	if ( portfd[ i ] >= 0 ) close( portfd[ i ] );
+	rxstop[ i ] = -1;
+	rxevent[ i ] = -1;
+	rxroom[ i ] = -1;
+	portepoll[ i ] = -1;
+	portfd[ i ] = -1;
+	pstate[ i ] = false;
+}
+
+
+//	Wake port i's consumer if it's waiting for data.
+
+static void rxsignal( int i )
+{
+	uint64_t	one = 1;
+
+	std::atomic_thread_fence( std::memory_order_seq_cst );						//	ring head before rxwaiting, pairs with rxwait()
+	if ( rxwaiting[ i ].load() && write( rxevent[ i ], &one, sizeof( one ) ) != sizeof( one ) )
+		TRACE( (char *) "rx signal failed\n" );
+}
+
+
+//	The consumer took data from port i's ring: wake the reader if it's waiting for room.
+
+static void rxtaken( int i )
+{
+	uint64_t	one = 1;
+
+	std::atomic_thread_fence( std::memory_order_seq_cst );						//	ring tail before rxfull, pairs with rxroomwait()
+	if ( rxfull[ i ].load() && write( rxroom[ i ], &one, sizeof( one ) ) != sizeof( one ) )
+		TRACE( (char *) "rx room signal failed\n" );
+}
+
+
+//	Port i's ring is full: the reader waits for the consumer to take some (rxtaken()) rather than
+//	polling for it, the rest stays in the driver meanwhile.  False if it was told to quit.
+
+static bool rxroomwait( int i )
+{
+	struct pollfd	pfd[ 2 ];
+	uint64_t		count;
+	bool			run = true;
+
+	rxfull[ i ].store( true );
+	std::atomic_thread_fence( std::memory_order_seq_cst );						//	rxfull before the ring tail, pairs with rxtaken()
+
+	if ( ring_space( &rxring[ i ] ) == 0 )
+	{
+		pfd[ 0 ].fd = rxroom[ i ];
+		pfd[ 1 ].fd = rxstop[ i ];
+		pfd[ 0 ].events = pfd[ 1 ].events = POLLIN;
+
+		while ( poll( pfd, 2, -1 ) < 0 && errno == EINTR ) ;
+
+		if ( pfd[ 1 ].revents ) run = false;
+		if ( pfd[ 0 ].revents && read( rxroom[ i ], &count, sizeof( count ) ) != sizeof( count ) ) TRACE( (char *) "rx room wait failed\n" );
+	}
+
+	rxfull[ i ].store( false );
+	return( run );
+}
+
+
+//	Port i's reader thread.  Reads whatever the tty has (up to the room left in the ring) each time
+//	epoll says there's data, and tags the block with the line errors counted since the last one.
+//	Quits when told to, or when the device goes away (read() returns end of file or fails).
+//	A block shorter than the port's rxgap that doesn't end a message is followed by a nap for the
+//	rest of the gap, so the next read gets what's come in meanwhile (see setrxgap()).
+
+static void *reader( void *arg )
+{
+	int					i = (int) (intptr_t) arg, fd = portfd[ i ], n, gap;
+	unsigned char		buf[ 4096 ];
+	struct epoll_event	ev[ 2 ];
+	ssize_t				l;
+	unsigned			errors;
+	uint32_t			space;
+	rxtap_t				tap;
+	struct timespec		nap;
+
+#ifdef	TIOCGICOUNT
+	struct serial_icounter_struct	count, last;
+	bool				counting = !ioctl( fd, TIOCGICOUNT, &last );			//	not on a pty
+#endif
+
+	while ( true )
+	{
+		if ( ( n = epoll_wait( portepoll[ i ], ev, 2, -1 ) ) < 0 )
+		{
+			if ( errno == EINTR ) continue;
+			break;
+		}
+
+		for ( int j = 0; j < n; j ++ )
+			if ( ev[ j ].data.fd == rxstop[ i ] ) return( NULL );
+
+		if ( ( space = ring_space( &rxring[ i ] ) ) == 0 )
+		{
+			if ( !rxroomwait( i ) ) return( NULL );								//	the consumer is behind, leave it in the driver
+			continue;
+		}
+
+		if ( ( l = read( fd, buf, ( space < sizeof( buf ) ) ? space : sizeof( buf ) ) ) > 0 )
+		{
+			errors = 0;
+#ifdef	TIOCGICOUNT
+			if ( counting && !ioctl( fd, TIOCGICOUNT, &count ) )
+			{
+				if ( count.frame != last.frame ) errors |= CE_FRAME;
+				if ( count.overrun != last.overrun ) errors |= CE_OVERRUN;
+				if ( count.parity != last.parity ) errors |= CE_RXPARITY;
+				if ( count.brk != last.brk ) errors |= CE_BREAK;
+				if ( count.buf_overrun != last.buf_overrun ) errors |= CE_RXOVER;
+				last = count;
+			}
+#endif
+			if ( ( tap = rxtap[ i ].load( std::memory_order_acquire ) ) != NULL ) tap( buf, (int) l, rxtapctx[ i ].load() );
+			ring_put( &rxring[ i ], buf, (uint32_t) l, errors );
+			rxsignal( i );
+			rxreads[ i ].fetch_add( 1, std::memory_order_relaxed );
+			rxbytes[ i ].fetch_add( (unsigned long) l, std::memory_order_relaxed );
+
+			if ( ( gap = rxgap[ i ].load( std::memory_order_relaxed ) ) > l && buf[ l - 1 ] != '\n' && buf[ l - 1 ] != '\r' && buf[ l - 1 ] != ACK && buf[ l - 1 ] != NAK )
+			{
+				nap.tv_sec = 0;
+				nap.tv_nsec = ( gap - l ) * rxbytens[ i ].load( std::memory_order_relaxed );
+				if ( nap.tv_nsec > 0 && nap.tv_nsec < 1000000000L ) nanosleep( &nap, NULL );
+			}
+		}
+		else
+			if ( l == 0 || ( errno != EAGAIN && errno != EINTR ) ) break;
+	}
+
+	rxdead[ i ].store( true );
+	rxsignal( i );
+	return( NULL );
+}
+
+
+//	Make sure the selected port is open, reopening it if it was dropped (e.g. USB unplug & replug).
+
+static bool portready( void )
+{
+	if ( selport < 0 || selport >= NUMCOMPORT || portnumbers[ selport ] < 1 ) return( false );
+	return( portfd[ selport ] >= 0 || openport( portnumbers[ selport ] - 1 ) == 0 );
+}
+
+
+//	Wait till deadline d for the selected port to have something for charin(): receive data or
+//	a hang-up.  Also returns when fd (if not -1) is readable.
+//	Returns > 0 if there's something, 0 on timeout.
+
+static int rxwait( tgdeadline_t d, int fd = -1 )
+{
+	struct pollfd	pfd[ 2 ];
+	struct timespec	ts;
+	uint64_t		count;
+	int64_t			left;
+	int				n;
+
+	if ( selport < 0 || ring_count( &rxring[ selport ] ) || rxdead[ selport ].load() ) return( 1 );
+	if ( ( left = tgdeadline_left( d ) ) <= 0 ) return( 0 );
+
+	if ( rxevent[ selport ] < 0 )
+	{
+		//	The port is closed, don't hammer on reopening it.
+
+		Sleep( ( tgdeadline_ms( d ) < 50 ) ? tgdeadline_ms( d ) : 50 );
+		return( 0 );
+	}
+
+	rxwaiting[ selport ].store( true );
+	std::atomic_thread_fence( std::memory_order_seq_cst );						//	rxwaiting before the ring head, pairs with rxsignal()
+
+	if ( ring_count( &rxring[ selport ] ) || rxdead[ selport ].load() )
+		n = 1;
+	else
+	{
+		pfd[ 0 ].fd = rxevent[ selport ];
+		pfd[ 0 ].events = POLLIN;
+		pfd[ 1 ].fd = fd;
+		pfd[ 1 ].events = POLLIN;
+
+		ts.tv_sec = left / 1000000000;
+		ts.tv_nsec = left % 1000000000;
+		while ( ( n = ppoll( pfd, ( fd < 0 ) ? 1 : 2, &ts, NULL ) ) < 0 && errno == EINTR ) ;
+		if ( n > 0 && pfd[ 0 ].revents && read( rxevent[ selport ], &count, sizeof( count ) ) != sizeof( count ) ) n = 0;
+	}
+
+	rxwaiting[ selport ].store( false );
+	return( n );
+}
+
+
+//	Write n bytes to the selected port, waiting for room when the driver's buffer is full.
+//	Returns the number of bytes written.
+
+static unsigned long txall( const char *p, unsigned long n )
+{
+	unsigned long	sent = 0;
+	ssize_t			l;
+	struct pollfd	pfd;
+
+	while ( sent < n )
+	{
+		if ( ( l = write( portfd[ selport ], p + sent, n - sent ) ) > 0 )
+			sent += (unsigned long) l;
+		else
+			if ( l < 0 && ( errno == EAGAIN || errno == EWOULDBLOCK ) )
+			{
+				pfd.fd = portfd[ selport ];
+				pfd.events = POLLOUT;
+				if ( poll( &pfd, 1, 1000 ) <= 0 ) break;						//	transmitter stuck for a second
+			}
+			else
+				if ( l >= 0 || errno != EINTR ) break;
+	}
+	return( sent );
+}
+
+
+// Close all open com ports.
+
+void closeports( void )
+{
+	std::lock_guard<std::recursive_mutex>	l( portlist );
+
+	if ( closing ) return;
+	closing = true;
+
+	for ( int i = 0; i < openedports; i ++ )
+	{
+		if ( portfd[ i ] >= 0 )
+		{
+			dropport( i );
+			portnumbers[ i ] = -1;
+			pinit[ i ] = false;
+		}
+		rxtap[ i ].store( NULL );
+		rxtapctx[ i ].store( NULL );
+		rxgap[ i ].store( 0 );
+	}
+	openedports = 0;
+	closing = false;
+}
+
+
+int closeport( int port )
+{
+	std::lock_guard<std::recursive_mutex>	l( portlist );
+	int		i;
+
+	if ( port < 0 || port > MAXCOMPORTNUMBER ) return( ERROR_BAD_PORT );
+	if ( closing ) return( BUSY );
+
+	for ( i = 0; i < openedports && portnumbers[ i ] != port + 1; i ++ ) ;
+
+	if ( i >= NUMCOMPORT ) return( ERROR_TOO_MANY );
+
+	if ( i < openedports )
+	{
+		closing = true;
+
+		if ( portfd[ i ] >= 0 ) dropport( i );
+		portnumbers[ i ] = -1;													//	unregistered even if it was dropped
+		pinit[ i ] = false;
+		rxtap[ i ].store( NULL );
+		rxtapctx[ i ].store( NULL );
+		rxgap[ i ].store( 0 );
+
+		//	Now we must update openedports, the ports after this one keep their indexes
+
+		for ( openedports = NUMCOMPORT; openedports > 0 && portnumbers[ openedports - 1 ] < 1; openedports -- ) ;
+
+		closing = false;
+		return( NOERROR );
+	}
+
+	return( ERROR_BAD_PORT );													//	this port isn't open, and we're not going to open it
+}
+
+
+// open a serial port for I/O.  0 <= port < MAXCOMPORTNUMBER.  0 -> COM-1, 1 -> COM-2, ...
+// Returns an errno value on error else 0 and port ready for access.
+// Does nothing if the port is already open
+
+int openport( int port )
+{
+	std::lock_guard<std::recursive_mutex>	l( portlist );
+	DCB					params;
+	struct epoll_event	ev;
+	int					i, fd, ep, err, stop, event, room;
+
+	if ( port < 0 || port >= MAXCOMPORTNUMBER ) return( ERROR_BAD_PORT );
+
+	if ( !*comports[ port + 1 ] ) findserialports( NULL );						//	give the number a device if we can
+	if ( !*comports[ port + 1 ] ) return( ERROR_BAD_PORT );
+
+	//	Scan the opened port list to see if the requested port is already open
+
+	for ( i = 0; i < openedports && portnumbers[ i ] != port + 1; i ++ ) ;
+
+	if ( i < openedports )
+	{
+		selport = i;															//	the port is in the list, select it
+		if ( portfd[ i ] >= 0 ) return( 0 );									//	and it's open
+	}
+	else
+		for ( i = 0; i < openedports && portnumbers[ i ] >= 1; i ++ ) ;			//	a closed port's slot, else a new one
+
+	if ( i >= NUMCOMPORT ) return( ERROR_TOO_MANY );
+
+	snprintf( portnames[ i ], sizeof( portnames[ i ] ), "%s", comports[ port + 1 ] );
+
+	if ( ( fd = open( portnames[ i ], O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC ) ) < 0 )
+		return( errno );
+
+	if ( !isatty( fd ) )
+	{
+		close( fd );
+		return( ERROR_NOT_A_COM_PORT );
+	}
+
+	//	Default 9600, N, 8, 1, all handshake off.  A port that was configured then disconnected
+	//	is reopened with its last settings.
+
+	memcpy( &params, ( pinit[ i ] ) ? &portprams[ i ] : &defaultsettings, sizeof( params ) );
+
+	if ( ( err = applyparams( fd, &params ) ) != 0 )
+	{
+		close( fd );
+		return( err );
+	}
+
+	tcflush( fd, TCIOFLUSH );													//	clear any pending data
+
+	//	The reader thread waits for receive data or a stop request
+
+	stop = eventfd( 0, EFD_CLOEXEC );
+	event = eventfd( 0, EFD_CLOEXEC );
+	room = eventfd( 0, EFD_CLOEXEC );
+	ep = epoll_create1( EPOLL_CLOEXEC );
+	err = ( stop < 0 || event < 0 || room < 0 || ep < 0 ) ? errno : 0;
+
+	memset( &ev, 0, sizeof( ev ) );
+	ev.events = EPOLLIN;
+	ev.data.fd = fd;
+
+	if ( !err && epoll_ctl( ep, EPOLL_CTL_ADD, fd, &ev ) ) err = errno;
+
+	ev.data.fd = stop;
+
+	if ( !err && epoll_ctl( ep, EPOLL_CTL_ADD, stop, &ev ) ) err = errno;
+
+	if ( !err )
+	{
+		portfd[ i ] = fd;
+		portepoll[ i ] = ep;
+		rxstop[ i ] = stop;
+		rxevent[ i ] = event;
+		rxroom[ i ] = room;
+		ring_init( &rxring[ i ] );
+		rxwaiting[ i ].store( false );
+		rxfull[ i ].store( false );
+		rxdead[ i ].store( false );
+		rxreads[ i ].store( 0 );
+		rxbytes[ i ].store( 0 );
+		rxbytens[ i ].store( ( params.BaudRate ) ? 10000000000L / (long) params.BaudRate : 0 );
+
+		if ( ( err = pthread_create( &rxthread[ i ], NULL, reader, (void *) (intptr_t) i ) ) != 0 )
+		{
+			portfd[ i ] = portepoll[ i ] = rxstop[ i ] = rxevent[ i ] = rxroom[ i ] = -1;
+		}
+	}
+
+	if ( err )
+	{
+		if ( ep >= 0 ) close( ep );
+		if ( event >= 0 ) close( event );
+		if ( room >= 0 ) close( room );
+		if ( stop >= 0 ) close( stop );
+		close( fd );
+		return( err );
+	}
+
+	portnumbers[ i ] = port + 1;												//	remember which COM port number this is.
+
+	if ( !closeportsflag )
+	{
+		atexit( closeports );													// setup to auto close the ports on exit
+		closeportsflag = 1;														// and signal we've done it
+	}
+
+	selport = i;																// remember which one's active
+	memcpy( &portprams[ selport ], &params, sizeof( portprams[ selport ] ) );
+	if ( i + 1 > openedports ) openedports = i + 1;
+	return( 0 );
+}
+
+
+// pick the specified port for I/O
+//	Port is 0..n-1, 0-> COM1.
+//	returns non-zero error code.
+
+int portselect( int port )
+{
+	return( openport( port ) );
+}
+
+
+// pick the 'next' port
+
+int otherport( void )
+{
+	return( openport( portnumbers[ ( ( selport + 1 ) % openedports ) ] - 1 ) );
+}
+
+
+//	Return the currently selected COM port # or -1
+
+int getport( void )
+{
+	if ( selport >= 0 )
+		return( portnumbers[ selport ] );
+	else
+		return( -1 );
+}
+
+
+//	Tap the selected port's receive data, see win32comm.h
+
+void setrxtap( rxtap_t tap, void *ctx )
+{
+	if ( selport < 0 || selport >= NUMCOMPORT ) return;
+
+	rxtap[ selport ].store( NULL );
+	rxtapctx[ selport ].store( ctx );
+	rxtap[ selport ].store( tap, std::memory_order_release );
+}
+
+
+//	Let the selected port's reader wait for a message to gather, see win32comm.h
+
+void setrxgap( int bytes )
+{
+	if ( selport < 0 || selport >= NUMCOMPORT ) return;
+
+	rxgap[ selport ].store( ( bytes > 0 ) ? bytes : 0 );
+}
+
+
+//	True if selected port remains open
+
+BOOL isconnected( void )
+{
+	if ( selport < 0 || selport >= NUMCOMPORT ) return( ERROR_BAD_PORT );
+	return( pstate[ selport ] );
+}
+
+
+BOOL isconnected( int port )
+{
+	int		i;
+
+	if ( port < 0 || port > MAXCOMPORTNUMBER ) return( ERROR_BAD_PORT );
+
+	for ( i = 0; i < openedports && portnumbers[ i ] != port + 1; i ++ ) ;
+
+	if ( i >= NUMCOMPORT ) return( ERROR_TOO_MANY );
+
+	if ( i < openedports )
+	{
+		return( pstate[ i ] );
+	}
+
+	return( ERROR_BAD_PORT );
+}
+
+
+// return # characters pending or -1 if the port has disappeared.
+// The reader thread has already read what's arrived into the ring, so this is just a look at the ring.
+// Disconnects show up in the reader as read() returning end-of-file or an error.
+
+int charin( void )
+{
+	uint32_t	n;
+
+	if ( !portready() ) return( -1 );											//	port isn't opened and trying to do so fails
+
+	if ( !pstate[ selport ] )
+	{
+		pstate[ selport ] = true;
+		TRACE( (char *) "Port config\n" );
+	}
+
+	if ( ( n = ring_count( &rxring[ selport ] ) ) != 0 ) return( (int) n );
+
+	if ( !rxdead[ selport ].load() ) return( 0 );
+	if ( ( n = ring_count( &rxring[ selport ] ) ) != 0 ) return( (int) n );	//	what arrived before it went away
+
+	//	The device is gone (USB unplugged, pty closed).
+
+	TRACE( (char *) "Port %s closed\n", portnames[ selport ] );
+	dropport( selport );
+	return( -1 );
+}
+
+
+// Same as charin() for port index port, the selected port doesn't change.
+
+int charin( int port )
+{
+	int		i, oldport = selport;
+
+	if ( port < 0 || port >= openedports ) return( 0 );
+
+	selport = port;
+	i = charin();
+	selport = oldport;
+	return( i );
+}
+
+
+// Get next character.  If called when no character is available, we wait up to 1/2 second for one.
+// The upper byte is 0xFF when the port is closed or nothing arrived.
+
+unsigned getbyte( void )
+{
+	tgdeadline_t	d = tgdeadline_ticks( CLOCKS_PER_SEC / 2 );
+	unsigned char	c;
+	unsigned		errors;
+	int				i = 0;
+
+	if ( !portready() ) return( 0xFF00 );
+
+	if ( !ring_count( &rxring[ selport ] ) )
+	{
+		TRACE( (char *) "no char available\n" );
+
+		while ( ( i = charin() ) == 0 && !tgdeadline_passed( d ) )
+			rxwait( d );
+
+		if ( i <= 0 ) return( 0xFF00 );
+	}
+
+	if ( readavail( &c, 1, &errors ) <= 0 ) return( 0xFF00 );
+	return( c | errors << 8 );
+}
+
+
+// Take what's arrived without waiting: up to size bytes into buf, and the receive errors (CE_ bits) of
+// the block they came in into *errors (if it isn't NULL).  A read stops short of the next block with
+// errors, so the errors are always those of the bytes read.
+// Returns the bytes read, 0 if there's nothing or -1 if the port has disappeared.
+
+int readavail( unsigned char *buf, int size, unsigned *errors )
+{
+	unsigned	e = 0;
+	int			n;
+
+	if ( ( n = charin() ) > 0 && size > 0 )
+	{
+		n = (int) ring_read( &rxring[ selport ], buf, (uint32_t) size, &e );
+		rxtaken( selport );
+	}
+	else
+		if ( n > 0 ) n = 0;
+
+	if ( errors != NULL ) *errors = e;
+	return( n );
+}
+
+
+// Same as readavail() for port index port, the selected port doesn't change.
+
+int readavail( int port, unsigned char *buf, int size, unsigned *errors )
+{
+	int		n, oldport = selport;
+
+	if ( errors != NULL ) *errors = 0;
+	if ( port < 0 || port >= openedports ) return( 0 );
+
+	selport = port;
+	n = readavail( buf, size, errors );
+	selport = oldport;
+	return( n );
+}
+
+
+// The reads port index port's reader has made that returned data, and the bytes they returned, since
+// it was opened.  False if it isn't a port.
+
+BOOL rxcounts( int port, unsigned long *reads, unsigned long *bytes )
+{
+	if ( port < 0 || port >= openedports ) return( FALSE );
+
+	if ( reads != NULL ) *reads = rxreads[ port ].load();
+	if ( bytes != NULL ) *bytes = rxbytes[ port ].load();
+	return( TRUE );
+}
+
+
+// input string s (till cr) up to maxlen chars before timeout.  What's arrived is taken up to the cr at
+// once (ring_take()), not a getbyte() at a time.
+// Returns true if string (a carriage return) is received before timeout.
+
+int readstr( long timeout, char *s, int maxlen )
+{
+	static const scanset_t	cr = []
+	{
+		scanset_t	s;
+
+		scan_set( &s, "\r\x8D", 2 );												//	a CR with or without its parity bit
+		return( s );
+	}();
+	tgdeadline_t	d;
+	uint32_t		n, j, k;
+	unsigned		errors;
+	int				i, c;
+
+	if ( !portready() )
+	{
+		printf( "Can't open port.\n" );
+		return( 0 );
+	}
+
+	d = tgdeadline_ticks( timeout );
+	*s = 0;
+
+	while ( maxlen > 1 && !tgdeadline_passed( d ) )
+	{
+		if ( ( i = charin() ) > 0 )
+		{
+			//	What's come up to the CR at once, then parity bits off and LFs out
+
+			n = ring_take( &rxring[ selport ], (unsigned char *) s, (uint32_t) ( maxlen - 1 ), &cr, &c, &errors );
+			rxtaken( selport );
+
+			for ( j = k = 0; j < n; j ++ )
+				if ( ( s[ k ] = (char) ( s[ j ] & 0x7F ) ) != 0xA ) k ++;
+			s += k;
+			*s = 0;
+			maxlen -= (int) k;
+
+			if ( c >= 0 ) return( 1 );
+			d = tgdeadline_ticks( timeout );
+		}
+		else
+			if ( i < 0 ) return( 0 );
+			else rxwait( d );
+	}
+	return( 0 );
+}
+
+
+// input maxlen chars into s before timeout, clearing the parity bit when mask is 0x7F.
+// Returns true if maxlen chars are received before timeout.
+
+static BOOL getmasked( long timeout, unsigned char *s, int maxlen, unsigned mask )
+{
+	tgdeadline_t	d;
+	int				i;
+
+	if ( !portready() ) return( 0 );
+
+	d = tgdeadline_ticks( timeout );
+
+	while ( maxlen && !tgdeadline_passed( d ) )
+	{
+		if ( ( i = charin() ) > 0 )
+		{
+			*s ++ = (unsigned char) ( getbyte() & mask );
+			d = tgdeadline_ticks( timeout );
+			maxlen --;
+		}
+		else
+			if ( i < 0 ) break;
+			else rxwait( d );
+	}
+	*s = 0;
+	return( maxlen == 0 );
+}
+
+
+BOOL getnt( long timeout, char *s, int maxlen )
+{
+	return( getmasked( timeout, (unsigned char *) s, maxlen, 0x7F ) );
+}
+
+
+BOOL getntx( long timeout, unsigned char *s, int maxlen )
+{
+	return( getmasked( timeout, s, maxlen, 0xFF ) );
+}
+
+
+// Receive half of the cmdio family.  Input into recvbuf until a character in delims arrives (or ACK/NAK
+// when delims is NULL), the buffer fills or there's timeout between characters.  What's waiting is taken
+// a run at a time with ring_take(), not a getbyte() per character.
+// keepack stores the ACK/NAK in recvbuf, echo prints what's received and callback is called while we wait.
+// Returns true on ACK or a delimiter.
+
+char	lastcommand[ 1000 ] = "";
+
+static BOOL cmdrecv( char *cmd, long timeout, char *recvbuf, int maxlen, const char *delims, bool keepack, bool echo, void (*callback)( void ) )
+{
+	static const char	acknak[] = { ACK, NAK };
+	tgdeadline_t		d = tgdeadline_ticks( timeout );
+	scanset_t			s;
+	uint32_t			n;
+	unsigned			errors;
+	int					i, c;
+
+	if ( delims != NULL )
+		scan_set( &s, delims, (int) strlen( delims ) + 1 );						//	with its NUL, strchr() found that too
+	else
+		scan_set( &s, acknak, sizeof( acknak ) );
+
+	*recvbuf = 0;
+
+	while ( maxlen > 1 && !tgdeadline_passed( d ) )
+	{
+		if ( ( i = charin() ) > 0 )
+		{
+			//	All that's come up to the delimiter at once
+
+			n = ring_take( &rxring[ selport ], (unsigned char *) recvbuf, (uint32_t) ( maxlen - 1 ), &s, &c, &errors );
+			rxtaken( selport );
+
+			if ( echo ) fwrite( recvbuf, 1, n, stdout );
+			recvbuf += n;
+			*recvbuf = 0;
+			maxlen -= (int) n;
+
+			if ( c >= 0 && delims != NULL ) return( TRUE );
+
+			if ( c >= 0 )
+			{
+				if ( keepack ) *recvbuf ++ = (char) c;
+				*recvbuf = 0;
+				return( c == ACK );
+			}
+			d = tgdeadline_ticks( timeout );
+		}
+		else
+		{
+			if ( i < 0 )
+			{
+				TRACE( (char *) "Port disconnect\n" );
+				return( FALSE );
+			}
+
+			if ( callback != NULL )
+			{
+				callback();
+				rxwait( tgdeadline_min( d, tgdeadline_ticks( CLOCKS_PER_SEC / 100 ) ) );
+			}
+			else
+				rxwait( d );
+		}
+	}
+
+	if ( maxlen > 1 )
+		TRACE( (char *) "cmdio timeout to \"%s\"\n", cmd );
+	else
+		TRACE( (char *) "RX buffer filled\n" );
+	return( FALSE );
+}
+
+
+// Send a command to the port, then input a response into recvbuf (up to maxlen characters incl/null terminator).
+// The response ends with an ACK (0x06) or NAK (0x15), which isn't returned in the buffer.
+// Returns true if an ACK terminated response is received within timeout.
+
+BOOL cmdio( char *cmd, long timeout, char *recvbuf, int maxlen )
+{
+	if ( !portready() ) return( FALSE );
+
+	outcoms( cmd );																//	send the command
+	return( cmdrecv( cmd, timeout, recvbuf, maxlen, NULL, false, false, NULL ) );
+}
+
+
+//	Save as cmdio with a callback function
+
+BOOL cmdio( char *cmd, long timeout, char *recvbuf, int maxlen, void (*callback)( void ) )
+{
+	if ( !portready() ) return( FALSE );
+
+	outcoms( cmd );
+	return( cmdrecv( cmd, timeout, recvbuf, maxlen, NULL, false, false, callback ) );
+}
+
+
+//	Same as cmdio with a list of input string delimiters
+
+BOOL cmdio( char *cmd, long timeout, char *recvbuf, int maxlen, char *delims )
+{
+	return( cmdio( cmd, timeout, recvbuf, maxlen, delims, true ) ? TRUE : FALSE );
+}
+
+
+//	Same as cmdio with a list of input string delimiters & option to not clear input buffer
+
+bool cmdio( char *cmd, long timeout, char *recvbuf, int maxlen, char *delims, bool clearbuf )
+{
+	BOOL				result;
+	CRITICAL_SECTION	*cs;
+
+	if ( !portready() ) return( false );
+
+	EnterCriticalSection( cs = &cmdio_critical_section[ selport ] );
+
+	snprintf( lastcommand, sizeof( lastcommand ), "%s", cmd );					//	save a diagnosic copy
+
+	outcoms( cmd );																//	send the command all at once
+	result = cmdrecv( cmd, timeout, recvbuf, maxlen, delims, false, false, NULL );
+
+	LeaveCriticalSection( cs );
+	return( result != FALSE );
+}
+
+
+BOOL cmdio( char *cmd, long timeout, char *recvbuf, int maxlen, int pacing )
+{
+	if ( !portready() ) return( FALSE );
+
+	snprintf( lastcommand, sizeof( lastcommand ), "%s", cmd );
+	*recvbuf = 0;
+
+	//	Check for unsolicited data
+
+	if ( charin() > 0 )
+	{
+		TRACE( (char *) "Unsolicited:" );
+		while ( charin() > 0 ) TRACE( (char *) " %02X", getbyte() );
+		TRACE( (char *) "\n" );
+	}
+
+	//	send the command with character pacing
+
+	for ( int i = 0; i < (int) strlen( cmd ); i ++ )
+	{
+		Sleep( pacing );
+		outcom( cmd[ i ] );
+		Sleep( pacing );
+	}
+
+	return( cmdrecv( cmd, timeout, recvbuf, maxlen, NULL, true, false, NULL ) );
+}
+
+
+//	This one echos received characters as we get them if echo is true.
+
+BOOL cmdio( char *cmd, long timeout, char *recvbuf, int maxlen, bool echo )
+{
+	if ( !portready() ) return( FALSE );
+
+	outcoms( cmd );
+	return( cmdrecv( cmd, timeout, recvbuf, maxlen, NULL, false, echo, NULL ) );
+}
+
+
+//	cmdio for a full-duplex system (where transmitted characters are echoed back to us)
+
+BOOL cmdiof( char *cmd, long timeout, char *recvbuf, int maxlen )
+{
+	if ( !portready() ) return( FALSE );
+
+	snprintf( lastcommand, sizeof( lastcommand ), "%s", cmd );
+
+	if ( strlen( cmd ) )
+		while ( charin() > 0 ) getbyte();
+
+	//	send the command waiting for each character to echo back to us.
+
+	for ( int i = 0; cmd[ i ]; i ++ )
+	{
+		tgdeadline_t	d = tgdeadline_ticks( CLOCKS_PER_SEC / 2 );
+		unsigned char	c = (unsigned char) ( cmd[ i ] + 1 );
+		int				j;
+
+		outcom( cmd[ i ] );
+
+		while ( !tgdeadline_passed( d ) )
+		{
+			if ( ( j = charin() ) > 0 )
+			{
+				c = (unsigned char) ( getbyte() & 0xFF );
+				if ( c == (unsigned char) cmd[ i ] ) break;
+			}
+			else
+				if ( j < 0 )
+				{
+					TRACE( (char *) "Port disconnect\n" );
+					return( FALSE );
+				}
+				else
+					rxwait( d );
+		}
+		if ( c != (unsigned char) cmd[ i ] )
+			return( FALSE );
+	}
+
+	return( cmdrecv( cmd, timeout, recvbuf, maxlen, NULL, true, false, NULL ) );
+}
+
+
+//	A routine like cmdio that sends a command then inputs a cr/lf terminated line.
+//	neither the CR or LF is returned in the return string.
+//	Returns true if the linefeed is received within maxlen characters of the reply,
+//	and the time between characters is less than timeout.
+
+bool getline( char *cmd, time_t timeout, char *buf, int maxlen )
+{
+	tgdeadline_t	d;
+	char			c;
+	int				i;
+
+	if ( !maxlen ) return( false );
+
+	if ( !portready() ) return( false );
+
+	if ( cmd != NULL && *cmd ) outcoms( cmd );									// send the optional command
+
+	d = tgdeadline_ticks( (long) timeout );										//	mark start time
+	*buf = 0;																	//	delimit the output line
+
+	while ( maxlen > 1 && !tgdeadline_passed( d ) )
+	{
+		if ( ( i = charin() ) > 0 )
+		{
+			c = (char) ( getbyte() & 0xFF );									//	get the received character
+
+			switch ( c )
+			{
+			case LF:
+				return( true );
+
+			case CR:
+				break;
+
+			default:
+				*buf ++ = c;
+				*buf = 0;
+				maxlen --;
+			}
+			d = tgdeadline_ticks( (long) timeout );
+		}
+		else
+			if ( i < 0 ) return( false );
+			else rxwait( d );
+	}
+	return( false );
+}
+
+
+// wait for a character string or timeout.
+// The input is run through a matcher (commmatch.h), each character is looked at once.
+// Returns true if time out/error
+
+BOOL waitfor( long timeout, char *str )
+{
+	commmatch_t		m;
+	tgdeadline_t	d;
+	int				i, state = 0;
+
+	if ( !portready() ) return( 1 );
+	if ( !*str ) return( 0 );
+
+	match_init( &m );
+	if ( match_add( &m, str, (int) strlen( str ) ) < 0 ) return( 1 );		//	too long
+	match_build( &m );
+	d = tgdeadline_ticks( timeout );
+
+	while ( !tgdeadline_passed( d ) )
+	{
+		if ( ( i = charin() ) > 0 )
+		{
+			if ( match_step( &m, &state, (unsigned char) ( getbyte() & 0xFF ) ) ) return( 0 );
+			d = tgdeadline_ticks( timeout );
+		}
+		else
+			if ( i < 0 ) break;
+			else rxwait( d );
+	}
+	return( 1 );
+}
+
+
+//	Receive into bufr (what fits of it) till ack, or nak if it isn't NULL, turns up or timeout.
+//	The match is cut off the end of bufr.  Returns false on the ack.
+
+static BOOL waitmatch( char *bufr, int bufsiz, long timeout, const char *ack, int acklen, const char *nak, int naklen )
+{
+	commmatch_t		m;
+	tgdeadline_t	d;
+	uint32_t		hits;
+	int				i, n = 0, state = 0, a;
+
+	if ( !portready() ) return( TRUE );
+
+	memset( bufr, 0, bufsiz );													//	null out the receive buffer
+
+	match_init( &m );
+	if ( ( a = match_add( &m, ack, acklen ) ) < 0 || ( nak != NULL && match_add( &m, nak, naklen ) < 0 ) ) return( TRUE );
+	match_build( &m );
+	d = tgdeadline_ticks( timeout );											//	mark start time
+
+	while ( !tgdeadline_passed( d ) )
+	{
+		if ( ( i = charin() ) > 0 )
+		{
+			i = getbyte() & 0xFF;
+			if ( n < bufsiz - 1 ) bufr[ n ++ ] = (char) i;						//	past that it's only matched
+
+			if ( ( hits = match_step( &m, &state, (unsigned char) i ) ) != 0 )
+			{
+				i = ( hits & ( 1u << a ) ) ? acklen : naklen;
+				if ( n >= i ) bufr[ n - i ] = 0;								//	remove the match
+				return( ( hits & ( 1u << a ) ) ? FALSE : TRUE );
+			}
+			d = tgdeadline_ticks( timeout );									//	reset mark time
+		}
+		else
+			if ( i < 0 ) break;
+			else rxwait( d );
+	}
+	return( TRUE );																//	never got the string
+}
+
+
+//	Wait for a block of len or timeout.
+//	Returns true if time out/error
+//	Inputs data into caller's buffer
+
+BOOL waitfor( char *bufr, int bufsiz, long timeout, char *block, int len )
+{
+	return( waitmatch( bufr, bufsiz, timeout, block, len, NULL, 0 ) );
+}
+
+
+//	Wait for a block of len or timeout.
+//	This one accepts both the ACKnowledge and NAK strings to reduce the wait time.
+//	Returns true if time out/error
+//	Inputs data into caller's buffer
+
+BOOL waitfor( char *bufr, int bufsiz, long timeout, char *ack, int acklen, char *nak, int naklen )
+{
+	return( waitmatch( bufr, bufsiz, timeout, ack, acklen, nak, naklen ) );
+}
+
+
+// Transmit routines
+
+// send c -> port
+
+void outcom( char c )
+{
+	if ( !portready() ) return;
+	txall( &c, 1 );
+}
+
+
+//	Wait up to 1/10 second for c to echo back in a full-duplex system.
+
+static void eatecho( char c )
+{
+	tgdeadline_t	d = tgdeadline_ticks( CLOCKS_PER_SEC / 10 );
+	int				i;
+
+	while ( !tgdeadline_passed( d ) )
+	{
+		if ( ( i = charin() ) > 0 )
+		{
+			if ( (char) ( getbyte() & 0xFF ) == c ) break;
+		}
+		else
+			if ( i < 0 ) break;
+			else rxwait( d );
+	}
+}
+
+
+// send c -> port for a full-duplex system, eat the echo back.
+
+void outcome( char c )
+{
+	if ( !portready() ) return;
+
+	txall( &c, 1 );
+	eatecho( c );
+}
+
+
+// send string to port
+
+void outcoms( char *str )
+{
+	if ( !portready() ) return;
+	txall( str, strlen( str ) );
+}
+
+
+// send string to port in full-duplex system (e.g. eat the echo back characters)
+
+void outcomsf( char *str )
+{
+	if ( !portready() ) return;
+
+	for ( char *p = str; *p; p ++ )
+	{
+		txall( p, 1 );
+		eatecho( *p );
+	}
+}
+
+
+unsigned long outcoms( char *str, unsigned long n )
+{
+	if ( !portready() ) return( 0 );
+	return( txall( str, n ) );
+}
+
+
+void outcoms( char *str, int pacing )
+{
+	for ( unsigned i = 0; i < strlen( str ); i ++ )
+	{
+		Sleep( pacing );
+		outcom( str[ i ] );
+	}
+}
+
+
+void outcomblock( unsigned char *block, int blocksize )
+{
+	if ( !portready() ) return;
+	txall( (char *) block, (unsigned long) blocksize );
+}
+
+
+// wait till transmitter is ready
+
+void waitxmitrdy( void )
+{
+	if ( !portready() ) return;
+	tcdrain( portfd[ selport ] );
+}
+
+
+// reset receive & transmit
+// returns true on error (with error code)
+
+DWORD rstcom( void )
+{
+	if ( !portready() ) return( ERROR_BAD_PORT );
+
+	if ( tcflush( portfd[ selport ], TCIOFLUSH ) ) return( errno );
+	ring_discard( &rxring[ selport ] );
+	rxtaken( selport );
+	return( 0 );
+}
+
+
+// get port parameters
+// Returns true on error
+
+BOOL getcomprm( DCB *params )
+{
+	if ( !portready() ) return( ERROR_BAD_PORT );
+
+	memcpy( params, &portprams[ selport ], sizeof( DCB ) );
+	return( 0 );
+}
+
+
+// set port parameters
+// Returns true on error
+//	Caution: as with win32comm, params also sets RTS and DTR.
+
+BOOL setcomprm( DCB *params )
+{
+	if ( !portready() ) return( true );
+
+	if ( applyparams( portfd[ selport ], params ) ) return( true );
+
+	memcpy( &portprams[ selport ], params, sizeof( portprams[ 0 ] ) );			//	update saved settings
+	rxbytens[ selport ].store( ( params -> BaudRate ) ? 10000000000L / (long) params -> BaudRate : 0 );
+	pinit[ selport ] = true;													//	signal the user has initialized the port
+	return( false );
+}
+
+
+// activate port setup menu
+
+void pramsetup( void )
+{
+
+}
+
+
+// Simple terminal program
+
+#define	NONPRINT	32
+
+char	*nonprint[ NONPRINT + 1 ] =
+{
+	(char *) "NUL[00]",
+	(char *) "SOH[01]",
+	(char *) "STX[02]",
+	(char *) "ETX[03]",
+	(char *) "EOT[04]",
+	(char *) "ENQ[05]",
+	(char *) "ACK[06]",
+	(char *) "BEL[07]",
+	(char *) "BS[08]",
+	(char *) "TAB[09]",
+	(char *) "LF[0A]",
+	(char *) "VT[0B]",
+	(char *) "FF[0C]",
+	(char *) "CR[0D]",
+	(char *) "SO[0E]",
+	(char *) "SI[0F]",
+	(char *) "DLE[10]",
+	(char *) "DC1[11]",
+	(char *) "DC2[12]",
+	(char *) "DC3[13]",
+	(char *) "DC4[14]",
+	(char *) "NAK[15]",
+	(char *) "SYN[16]",
+	(char *) "ETB[17]",
+	(char *) "CAN[18]",
+	(char *) "EM[19]",
+	(char *) "SUB[1A]",
+	(char *) "ESC[1B]",
+	(char *) "FS[1C]",
+	(char *) "GS[1D]",
+	(char *) "RS[1E]",
+	(char *) "US[1F]",
+	NULL
+};
+
+
+//	The console is put in non-canonical mode so keys go out as they're typed.  There are no
+//	function keys here, so termcode has to be an ordinary character (tg_comm uses ESC).
+
+void simplecomma( unsigned termcode, bool halfduplex, char *msg, bool autolf )
+{
+	struct termios	saved, raw;
+	bool			tty = isatty( STDIN_FILENO ) != 0;
+	unsigned char	c;
+	int				i;
+
+	printf( "%s", msg );
+	if ( termcode < NONPRINT )
+		printf( "Press %s to terminate.\n", nonprint[ termcode ] );
+	else
+		printf( "Press %02X to terminate.\n", termcode );
+	fflush( stdout );
+
+	if ( tty && !tcgetattr( STDIN_FILENO, &saved ) )
+	{
+		raw = saved;
+		raw.c_lflag &= ~( ICANON | ECHO );
+		raw.c_cc[ VMIN ] = 1;
+		raw.c_cc[ VTIME ] = 0;
+		tcsetattr( STDIN_FILENO, TCSANOW, &raw );
+	}
+	else
+		tty = false;
+
+	while ( portready() )
+	{
+		struct pollfd	key = { STDIN_FILENO, POLLIN, 0 };
+
+		rxwait( tgdeadline_ticks( CLOCKS_PER_SEC / 10 ), STDIN_FILENO );
+
+		if ( poll( &key, 1, 0 ) > 0 )
+		{
+			if ( read( STDIN_FILENO, &c, 1 ) != 1 || c == termcode ) break;
+			outcom( (char) c );
+			if ( halfduplex ) putchar( c );
+		}
+
+		while ( charin() > 0 )
+		{
+			i = getbyte() & 0xFF;
+
+			if ( i < NONPRINT && !( i == 0xD || i == 0xA || i == 0x9 ) )
+				printf( "%s", nonprint[ i ] );
+			else
+			{
+				if ( i > 0x7E )
+					printf( "[%02X]", i );
+				else
+				{
+					putchar( i );
+					if ( i == CR && autolf ) putchar( '\n' );
+				}
+			}
+		}
+		fflush( stdout );
+	}
+
+	if ( tty ) tcsetattr( STDIN_FILENO, TCSANOW, &saved );
+}
+
+
+//	This one is compatible with older module versions.
+
+void simplecomm( unsigned termcode, bool halfduplex, char *msg )
+{
+	simplecomma( termcode, halfduplex, msg, false );
+}
+
+
+// Retrieve MODEM status: the input signals plus the last set output signal states.
+
+int getcomsig( void )
+{
+	int		bits, status = 0;
+
+	if ( !portready() ) return( ERROR_BAD_PORT );
+
+	if ( ioctl( portfd[ selport ], TIOCMGET, &bits ) ) return( errno );
+
+	if ( bits & TIOCM_CTS ) status |= CTS;
+	if ( bits & TIOCM_DSR ) status |= DSR;
+	if ( bits & TIOCM_RI ) status |= RI;
+	if ( bits & TIOCM_CD ) status |= RLSD;
+
+	if ( portprams[ selport ].fRtsControl != 0 ) status |= RTS;
+	if ( portprams[ selport ].fDtrControl != 0 ) status |= DTR;
+	return( status );
+}
+
+
+int getcomsig( int port )
+{
+	int	oldport = selport;
+	int	result;
+
+	portselect( port );
+	result = getcomsig();
+	selport = oldport;
+	return( result );
+}
+
+
+// set port's MODEM control signals
+// Returns error code ( > 0 ) if error else false.
+// newstat is 0, RTS, DTR, or RTS | DTR
+
+BOOL setcomsig( int newstat )
+{
+	int		sig;
+
+	if ( !portready() ) return( ERROR_BAD_PORT );
+
+	portprams[ selport ].fRtsControl = ( newstat & RTS ) ? RTS_CONTROL_ENABLE : RTS_CONTROL_DISABLE;
+	portprams[ selport ].fDtrControl = ( newstat & DTR ) ? DTR_CONTROL_ENABLE : DTR_CONTROL_DISABLE;
+
+	sig = TIOCM_RTS;
+	if ( ioctl( portfd[ selport ], ( newstat & RTS ) ? TIOCMBIS : TIOCMBIC, &sig ) ) return( errno );
+	sig = TIOCM_DTR;
+	if ( ioctl( portfd[ selport ], ( newstat & DTR ) ? TIOCMBIS : TIOCMBIC, &sig ) ) return( errno );
+	return( 0 );
+}
+
+
+//	Set the communication signals of a different port
+//	Returns true on error
+
+BOOL setcomsig( int port, int newstat )
+{
+	int	oldport = selport;
+
+	portselect( port );
+	setcomsig( newstat );
+	selport = oldport;
+	return( FALSE );
+}
+
+
+// Here's the original Borland function
+// Returns true on error
+
+BOOL sendbreak( int breakon )
+{
+	if ( !portready() ) return( ERROR_BAD_PORT );
+
+	if ( ioctl( portfd[ selport ], ( breakon ) ? TIOCSBRK : TIOCCBRK ) ) return( errno );
+	return( 0 );
+}
+
+
+// Send a break for howlong ticks
+// Returns true on error
+
+BOOL sendbreak_timed( int howlong )
+{
+	if ( !portready() ) return( ERROR_BAD_PORT );
+
+	if ( ioctl( portfd[ selport ], TIOCSBRK ) ) return( errno );
+	Sleep( (DWORD) tgdeadline_ms( tgdeadline_ticks( howlong ) ) );
+	if ( ioctl( portfd[ selport ], TIOCCBRK ) ) return( errno );
+	return( 0 );
+}
+
+
+//	Check all opened com ports for receive data.
+//	Returns the COM port # of received data 1..N, and updates rx with the data
+//	otherwise it returns false (0).
+//	Use a rotating priority scheme so one port doesn't hug all the action.
+
+int	anyrx( unsigned char *rx )
+{
+	int		oldport = selport;													// remember which port the app had selected
+
+	for ( int i = ( oldport + 1 ) % NUMCOMPORT; i != oldport; i = ( i + 1 ) % NUMCOMPORT )
+	{
+		if ( portfd[ i ] >= 0 )													// if the port 'i' is active
+		{
+			selport = i;														// select it
+			if ( charin() > 0 )
+			{
+				if ( rx != NULL )
+					*rx = (unsigned char) ( getbyte() & 0xFF );					// get the received char
+				else
+					getbyte();													// else just toss it
+				return( i + 1 );
+			}
+		}
+	}
+	selport = oldport;
+	return( 0 );
+}
+
+
+//	Return device capabilities in a COMMPROP structure.  termios has little of this to offer,
+//	we fill in the queue depths.  Returns 0 on success or an error value.
+
+int getcomprop( LPCOMMPROP p )
+{
+	int		n;
+
+	if ( !portready() ) return( ERROR_BAD_PORT );
+
+	memset( p, 0, sizeof( *p ) );
+	p -> wPacketLength = sizeof( *p );
+	p -> dwProvSubType = 1;														//	RS-232
+	if ( !ioctl( portfd[ selport ], FIONREAD, &n ) ) p -> dwCurrentRxQueue = n;
+	if ( !ioctl( portfd[ selport ], TIOCOUTQ, &n ) ) p -> dwCurrentTxQueue = n;
+	return( 0 );
+}
+
+
+//	Serial devices we list: USB CDC-ACM and USB serial converters.
+
+static int ttyfilter( const struct dirent *d )
+{
+	return( !strncmp( d -> d_name, "ttyUSB", 6 ) || !strncmp( d -> d_name, "ttyACM", 6 ) );
+}
+
+
+//	Return the number of serial ports, and their COM port numbers.
+//	USB serial devices get COM numbers in name order the first time we see them and keep them
+//	for the life of the process.  Ports bound with mapport() are listed as well.
+//	ports may be NULL if only the count (or the numbering) is wanted.
+
+int findserialports( int ports[] )
+{
+	struct dirent	**names;
+	char			path[ 64 ];
+	int				n, i, j, numports = 0;
+
+	if ( ( n = scandir( "/dev", &names, ttyfilter, alphasort ) ) >= 0 )
+	{
+		for ( i = 0; i < n; i ++ )
+		{
+			if ( strlen( names[ i ] -> d_name ) + 5 >= sizeof( path ) )
+			{
+				free( names[ i ] );
+				continue;														//	no room for it in comports[]
+			}
+			snprintf( path, sizeof( path ), "/dev/%.58s", names[ i ] -> d_name );
+			free( names[ i ] );
+
+			for ( j = 1; j <= MAXCOMPORTNUMBER && strcmp( comports[ j ], path ); j ++ ) ;
+
+			if ( j > MAXCOMPORTNUMBER )
+			{
+				//	A new device, give it the lowest free number
+
+				for ( j = 1; j <= MAXCOMPORTNUMBER && *comports[ j ]; j ++ ) ;
+				if ( j <= MAXCOMPORTNUMBER ) strcpy( comports[ j ], path );
+			}
+		}
+		free( names );
+	}
+
+	for ( j = 1; j <= MAXCOMPORTNUMBER; j ++ )
+	{
+		if ( *comports[ j ] && access( comports[ j ], F_OK ) == 0 )
+		{
+			if ( ports != NULL ) ports[ numports ] = j;
+			numports ++;
+		}
+	}
+	return( numports );
+}
+
+
+//	Return a list of available COM ports, same as findserialports() here.
+
+int getcomports( int *comportlist )
+{
+	return( findserialports( comportlist ) );
+}
+
+
+//	Bind COM<comport> to the tty at path (a pty for instance).  Returns 0 or an error value.
+
+int mapport( int comport, const char *path )
+{
+	if ( comport < 1 || comport > MAXCOMPORTNUMBER ) return( ERROR_BAD_PORT );
+	if ( path == NULL || strlen( path ) >= sizeof( comports[ 0 ] ) ) return( EINVAL );
+
+	strcpy( comports[ comport ], path );
+	return( 0 );
+}
+
+
+//	Device path of COM<comport> or NULL.
+
+const char *portpath( int comport )
+{
+	if ( comport < 1 || comport > MAXCOMPORTNUMBER || !*comports[ comport ] ) return( NULL );
+	return( comports[ comport ] );
+}
+
+
+//	Read sysfs attribute attr of the USB device behind tty into buf.  Returns false if there's none.
+
+static bool usbattribute( const char *tty, const char *attr, char *buf, size_t bufsize )
+{
+	char	dev[ PATH_MAX ], path[ PATH_MAX + 64 ], *p;
+	FILE	*f;
+	bool	found = false;
+
+	snprintf( path, sizeof( path ), "/sys/class/tty/%s/device", tty );
+	if ( realpath( path, dev ) == NULL ) return( false );
+
+	//	Walk up from the tty's device to the USB device, the directory with an idVendor
+
+	for ( int level = 0; level < 4 && !found; level ++ )
+	{
+		snprintf( path, sizeof( path ), "%s/idVendor", dev );
+		if ( access( path, R_OK ) == 0 )
+			found = true;
+		else
+			if ( ( p = strrchr( dev, '/' ) ) != NULL && p != dev )
+				*p = 0;
+			else
+				break;
+	}
+	if ( !found ) return( false );
+
+	snprintf( path, sizeof( path ), "%s/%s", dev, attr );
+	if ( ( f = fopen( path, "rt" ) ) == NULL ) return( false );
+
+	found = fgets( buf, (int) bufsize, f ) != NULL;
+	fclose( f );
+
+	if ( found && ( p = strchr( buf, '\n' ) ) != NULL ) *p = 0;
+	return( found );
+}
+
+
+//	Return one of the fields Windows reports for a serial port (see win32comm.cpp), from sysfs.
+//	field is any of: manufacturer, description, caption, name, product, serialnumber, vid, pid or
+//	deviceid; letter case doesn't matter.  comport is the COM number.
+//	Returns NULL if the port isn't a USB device or doesn't have the field.
+
+const char *getportinfo( const char *field, int comport )
+{
+	static const char	*fields[][ 2 ] =
+	{
+		{ "manufacturer",	"manufacturer" },
+		{ "description",	"product" },
+		{ "caption",		"product" },
+		{ "name",			"product" },
+		{ "product",		"product" },
+		{ "serialnumber",	"serial" },
+		{ "vid",			"idVendor" },
+		{ "pid",			"idProduct" },
+		{ NULL,				NULL }
+	};
+	static char		rbuf[ 500 ];
+	const char		*tty;
+	char			vid[ 16 ], pid[ 16 ], serial[ 100 ];
+
+	if ( comport < 1 || comport > MAXCOMPORTNUMBER || !*comports[ comport ] ) findserialports( NULL );
+	if ( comport < 1 || comport > MAXCOMPORTNUMBER || !*comports[ comport ] ) return( NULL );
+
+	tty = strrchr( comports[ comport ], '/' ) + 1;
+
+	if ( !strcasecmp( field, "deviceid" ) || !strcasecmp( field, "pnpdeviceid" ) )
+	{
+		if ( !usbattribute( tty, "idVendor", vid, sizeof( vid ) ) || !usbattribute( tty, "idProduct", pid, sizeof( pid ) ) )
+			return( NULL );
+		if ( !usbattribute( tty, "serial", serial, sizeof( serial ) ) ) *serial = 0;
+		snprintf( rbuf, sizeof( rbuf ), "USB\\VID_%s&PID_%s\\%s", vid, pid, serial );
+		return( rbuf );
+	}
+
+	for ( int i = 0; fields[ i ][ 0 ] != NULL; i ++ )
+	{
+		if ( !strcasecmp( field, fields[ i ][ 0 ] ) )
+			return( usbattribute( tty, fields[ i ][ 1 ], rbuf, sizeof( rbuf ) ) ? rbuf : NULL );
+	}
+	return( NULL );
+}
+
+
+//	The /dev/serial/by-id name of device into id, empty if it hasn't one.
+
+static void serialbyid( const char *device, char *id, size_t idsize )
+{
+	char			dev[ PATH_MAX ], real[ PATH_MAX ], path[ PATH_MAX + 64 ];
+	DIR				*d;
+	struct dirent	*e;
+
+	*id = 0;
+	if ( realpath( device, dev ) == NULL || ( d = opendir( "/dev/serial/by-id" ) ) == NULL ) return;
+
+	while ( ( e = readdir( d ) ) != NULL )
+	{
+		if ( *e -> d_name == '.' ) continue;
+
+		snprintf( path, sizeof( path ), "/dev/serial/by-id/%s", e -> d_name );
+		if ( realpath( path, real ) != NULL && !strcmp( real, dev ) )
+		{
+			if ( strlen( path ) < idsize ) strcpy( id, path );
+			break;
+		}
+	}
+	closedir( d );
+}
+
+
+//	List up to maxports serial ports that match filter into ports.  Returns the number listed.
+
+int commenum( commport_t *ports, int maxports, const char *filter )
+{
+	int			list[ MAXCOMPORTNUMBER + 1 ], n, count = 0;
+	commport_t	port;
+	const char	*tty;
+	char		buf[ 16 ];
+
+	n = findserialports( list );
+
+	for ( int i = 0; i < n && count < maxports; i ++ )
+	{
+		memset( &port, 0, sizeof( port ) );
+		port.comport = list[ i ];
+		snprintf( port.path, sizeof( port.path ), "%s", comports[ list[ i ] ] );
+		tty = ( ( tty = strrchr( port.path, '/' ) ) != NULL ) ? tty + 1 : port.path;
+
+		if ( usbattribute( tty, "idVendor", buf, sizeof( buf ) ) ) port.vid = strtoul( buf, NULL, 16 );
+		if ( usbattribute( tty, "idProduct", buf, sizeof( buf ) ) ) port.pid = strtoul( buf, NULL, 16 );
+		usbattribute( tty, "serial", port.serial, sizeof( port.serial ) );
+		usbattribute( tty, "manufacturer", port.manufacturer, sizeof( port.manufacturer ) );
+		usbattribute( tty, "product", port.product, sizeof( port.product ) );
+		serialbyid( port.path, port.id, sizeof( port.id ) );
+
+		if ( commenum_match( &port, filter ) ) ports[ count ++ ] = port;
+	}
+	return( count );
+}
+
+
+//	Return true if COM<comnumber> is an attached serial port.
+
+bool isaserialport( int comnumber )
+{
+	int		portlist[ MAXCOMPORTNUMBER + 1 ], i, j;
+
+	if ( ( i = findserialports( portlist ) ) > 0 )
+	{
+		for ( j = 0; j < i; j ++ ) if ( comnumber == portlist[ j ] ) return( true );
+	}
+	else
+		TRACE( (char *) "getserialports failed\n" );
+
+	return( false );
+}
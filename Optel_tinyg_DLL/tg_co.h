@@ -0,0 +1,264 @@
+//	==========================================================================================
+//	C++20 coroutines over the async requests (tgasync.cpp).  A motion sequence is written as a
+//	coroutine and any number of them run on one thread, the one that calls loop::run():
+//
+//		tg::task inspect( int part )
+//		{
+//			bool	xy[ MM ] = { true, true, false, false };
+//			double	at[ MM ] = { 10.0 * part, 5.0, 0.0, 0.0 };
+//
+//			if ( !co_await tg::move( xy, at, 10 ) ) co_return;
+//			tg::position_t	p = co_await tg::position();
+//			...
+//		}
+//
+//		tg::loop	l;
+//		for ( int i = 0; i < 1000; i ++ ) l.spawn( inspect( i ) );
+//		l.run();															//	till they've all finished
+//
+//	A move or home suspends its task, goes to the DLL's worker as a request (which talks to
+//	TinyG with cmdio() like tg_move() always has), and the worker's callback queues the task
+//	to be resumed by run().  At most INFLIGHT requests are handed to the worker at a time, the
+//	rest wait their turn in the loop.  position() reads the status snapshot and doesn't suspend.
+//	Each takes a device tg_open() opened first if it's not for the default one:
+//	tg::move( dev, xy, at, 10 ), tg::position( dev ).
+// ---------------------------------------------------------------------
+// Rev    Date      By     Description
+// -----  --------  -----  ---------------------------------------------
+//		  10/16/26	DV	   move(), home() and position() on a device
+//		  10/16/26	DV	   Original
+//	==========================================================================================
+
+#pragma once
+
+#if !( __cplusplus >= 202002L || ( defined( _MSVC_LANG ) && _MSVC_LANG >= 202002L ) )
+#error tg_co.h needs C++20 (coroutines)
+#endif
+
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string.h>
+
+#include "optel_tinyg_api.h"
+
+namespace tg
+{
+	class loop;
+
+	//	A motion task.  Starts when its loop first runs it, and is freed when it returns.
+
+	struct task
+	{
+		struct promise_type
+		{
+			loop	*owner = nullptr;
+
+			task get_return_object( void ) { return( task{ std::coroutine_handle<promise_type>::from_promise( *this ) } ); }
+			std::suspend_always initial_suspend( void ) noexcept { return( std::suspend_always() ); }
+			std::suspend_never final_suspend( void ) noexcept { return( std::suspend_never() ); }
+			void return_void( void ) { }
+			void unhandled_exception( void ) { std::terminate(); }
+			~promise_type();
+		};
+
+		std::coroutine_handle<promise_type>	h;
+	};
+
+
+	//	A move or home, co_await gives true if it worked.
+
+	struct request
+	{
+		loop					*owner;
+		tg_device				*dev;											//	NULL for the default one
+		bool					home;
+		bool					motors[ MM ];
+		double					pos[ MM ];
+		int						tosec;
+		bool					ok;
+		std::coroutine_handle<>	h;
+
+		bool await_ready( void ) { return( false ); }
+		void await_suspend( std::coroutine_handle<> c );
+		bool await_resume( void ) { return( ok ); }
+	};
+
+
+	//	Positions from the status snapshot (tg_getpos_ex()).
+
+	struct position_t
+	{
+		bool	ok;
+		double	pos[ MM ];
+		double	agems;															//	age of the report they came from
+	};
+
+	struct position_request
+	{
+		tg_device	*dev;
+		position_t	p;
+
+		bool await_ready( void ) { p.ok = tg_dev_getpos_ex( dev, p.pos, &p.agems ); return( true ); }
+		void await_suspend( std::coroutine_handle<> ) { }
+		position_t await_resume( void ) { return( p ); }
+	};
+
+
+	class loop
+	{
+	public:
+		static constexpr int	INFLIGHT = 16;									//	requests handed to the worker at once, it holds 32
+
+		//	Add a task, it starts when run() gets to it.
+
+		void spawn( task t )
+		{
+			t.h.promise().owner = this;
+			tasks ++;
+			post( t.h );
+		}
+
+		//	Resume tasks as their requests finish until they've all returned.
+
+		void run( void )
+		{
+			std::unique_lock<std::mutex>	l( lock );
+
+			current() = this;
+			while ( tasks > 0 )
+			{
+				ready.wait( l, [ this ] { return( !resumable.empty() ); } );
+
+				std::coroutine_handle<>	h = resumable.front();
+
+				resumable.pop_front();
+				l.unlock();
+				h.resume();
+
+				while ( !waiting.empty() && inflight.load() < INFLIGHT )
+				{
+					request	*r = waiting.front();
+
+					waiting.pop_front();
+					start( r );
+				}
+				l.lock();
+			}
+			current() = nullptr;
+		}
+
+		//	The loop running on this thread.
+
+		static loop *&current( void )
+		{
+			static thread_local loop	*l = nullptr;
+
+			return( l );
+		}
+
+	private:
+		friend struct task::promise_type;
+		friend struct request;
+
+		std::mutex						lock;									//	resumable
+		std::condition_variable			ready;
+		std::deque<std::coroutine_handle<>>	resumable;
+		std::deque<request *>			waiting;								//	loop thread only, like tasks
+		std::atomic<int>				inflight{ 0 };
+		int								tasks = 0;
+
+		void post( std::coroutine_handle<> h )
+		{
+			std::lock_guard<std::mutex>	l( lock );
+
+			resumable.push_back( h );
+			ready.notify_one();
+		}
+
+		static void done( int, bool ok, void *ctx )								//	on the worker thread
+		{
+			request	*r = (request *) ctx;
+
+			r -> ok = ok;
+			r -> owner -> inflight --;
+			r -> owner -> post( r -> h );
+		}
+
+		void submit( request *r )
+		{
+			if ( inflight.load() < INFLIGHT )
+				start( r );
+			else
+				waiting.push_back( r );
+		}
+
+		void start( request *r )
+		{
+			inflight ++;
+			if ( ( ( r -> home ) ? tg_dev_home_async( r -> dev, r -> motors, r -> tosec, done, r ) : tg_dev_move_async( r -> dev, r -> motors, r -> pos, r -> tosec, done, r ) ) == 0 )
+			{
+				inflight --;
+				r -> ok = false;
+				post( r -> h );
+			}
+		}
+	};
+
+
+	inline task::promise_type::~promise_type()
+	{
+		if ( owner != nullptr ) owner -> tasks --;
+	}
+
+
+	inline void request::await_suspend( std::coroutine_handle<> c )
+	{
+		h = c;
+		owner -> submit( this );
+	}
+
+
+	//	co_await tg::move( motors, pos, tosec ), tg::home( motors, tosec ) and tg::position(), in a
+	//	task that loop::run() is running.  With a device first, on that device.
+
+	inline request move( tg_device *dev, const bool motors[ MM ], const double pos[ MM ], int tosec )
+	{
+		request	r = { loop::current(), dev, false, { }, { }, tosec, false, nullptr };
+
+		memcpy( r.motors, motors, sizeof( r.motors ) );
+		memcpy( r.pos, pos, sizeof( r.pos ) );
+		return( r );
+	}
+
+	inline request home( tg_device *dev, const bool motors[ MM ], int tosec )
+	{
+		request	r = { loop::current(), dev, true, { }, { }, tosec, false, nullptr };
+
+		memcpy( r.motors, motors, sizeof( r.motors ) );
+		return( r );
+	}
+
+	inline position_request position( tg_device *dev )
+	{
+		return( position_request{ dev, { } } );
+	}
+
+	inline request move( const bool motors[ MM ], const double pos[ MM ], int tosec )
+	{
+		return( move( nullptr, motors, pos, tosec ) );
+	}
+
+	inline request home( const bool motors[ MM ], int tosec )
+	{
+		return( home( nullptr, motors, tosec ) );
+	}
+
+	inline position_request position( void )
+	{
+		return( position( nullptr ) );
+	}
+}
@@ -0,0 +1,61 @@
+//	==========================================================================================
+//	std::future flavors of tg_move_async() and tg_home_async() for C++ callers:
+//
+//		std::future<bool>	moved = tg_move_future( move, pos, 10 );
+//		... grab and process an image ...
+//		if ( !moved.get() ) ...
+//
+//	The future is ready (false) at once if the request couldn't be queued.  tg_dev_move_future()
+//	and tg_dev_home_future() take the device, NULL for the default one.
+// ---------------------------------------------------------------------
+// Rev    Date      By     Description
+// -----  --------  -----  ---------------------------------------------
+//		  10/16/26	DV	   tg_dev_move_future(), tg_dev_home_future()
+//		  10/16/26	DV	   Original
+//	==========================================================================================
+
+#pragma once
+
+#include <future>
+
+#include "optel_tinyg_api.h"
+
+inline void tg_fulfil( int, bool ok, void *ctx )
+{
+	std::promise<bool>	*p = (std::promise<bool> *) ctx;
+
+	p -> set_value( ok );
+	delete p;
+}
+
+
+inline std::future<bool> tg_dev_move_future( tg_device *dev, bool move[ MM ], double pos[ MM ], int tosec )
+{
+	std::promise<bool>	*p = new std::promise<bool>;
+	std::future<bool>	f = p -> get_future();
+
+	if ( !tg_dev_move_async( dev, move, pos, tosec, tg_fulfil, p ) ) tg_fulfil( 0, false, p );
+	return( f );
+}
+
+
+inline std::future<bool> tg_dev_home_future( tg_device *dev, bool home[ MM ], int tosec )
+{
+	std::promise<bool>	*p = new std::promise<bool>;
+	std::future<bool>	f = p -> get_future();
+
+	if ( !tg_dev_home_async( dev, home, tosec, tg_fulfil, p ) ) tg_fulfil( 0, false, p );
+	return( f );
+}
+
+
+inline std::future<bool> tg_move_future( bool move[ MM ], double pos[ MM ], int tosec )
+{
+	return( tg_dev_move_future( NULL, move, pos, tosec ) );
+}
+
+
+inline std::future<bool> tg_home_future( bool home[ MM ], int tosec )
+{
+	return( tg_dev_home_future( NULL, home, tosec ) );
+}
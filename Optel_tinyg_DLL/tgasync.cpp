@@ -0,0 +1,295 @@
+//	==========================================================================================
+//	Asynchronous moves and homing.  tg_move_async() and tg_home_async() queue a request for a
+//	worker thread, which runs the requests one at a time with tg_move() and tg_home(), and return
+//	its number straight away.  tg_dev_move_async() and tg_dev_home_async() do it on a device
+//	tg_open() opened.  The caller hears how it went from its callback (called on the
+//	worker thread), by waiting for it with tg_wait(), or through a std::future (tg_future.h).
+//
+//	While a request is running its device's port is the worker's.  The caller can use tg_getpos()
+//	and tg_getpos_ex(), which read the status snapshot, but not the calls that talk to TinyG.
+//	Without a snapshot (no status reports) they'd ask TinyG, so they fail on the device while a
+//	request runs on it instead (tg_async_run() holds the device, see tg_querypos()).
+// ---------------------------------------------------------------------
+// Rev    Date      By     Description
+// -----  --------  -----  ---------------------------------------------
+//		  10/16/26	DV	   tg_async_stop( true ) at process termination: no wait, no callbacks
+//		  10/16/26	DV	   Requests name their device, the device rather than the worker is held while one runs
+//		  10/16/26	DV	   tg_async_claim(): the port for a call on another thread, while no request runs
+//		  10/16/26	DV	   A worker tg_async_stop() gave up on is never joined by a second one, see alive
+//		  10/16/26	DV	   Original
+//	==========================================================================================
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "optel_tinyg_api.h"
+
+#define	REQUESTS		32														//	requests queued, running, or done and not waited for yet
+
+typedef enum
+{
+	FREE,
+	QUEUED,
+	RUNNING,
+	DONE																		//	till tg_wait() has the result
+} state_t;
+
+typedef struct
+{
+	int			id;
+	state_t		state;
+	tg_device	*dev;															//	NULL for the default one
+	bool		home;															//	tg_home() rather than tg_move()
+	bool		motors[ MM ];
+	double		pos[ MM ];
+	int			tosec;
+	tg_done_t	done;															//	callback, NULL to be waited for
+	void		*ctx;
+	bool		ok;
+} request_t;
+
+static request_t				requests[ REQUESTS ];
+static int						queue[ REQUESTS ], qhead, qcount;				//	indexes of the queued requests, oldest first
+static int						lastid;
+static std::mutex				lock;											//	everything above, and the flags below
+static std::condition_variable	changed;										//	a request was queued or is done, or the worker quit
+static std::thread				worker;
+static unsigned					generation;										//	the worker that should run, one that was started for another stops
+static bool						alive;											//	a worker is running, even one tg_async_stop() stopped waiting for
+
+bool tg_async_run( tg_device *dev, bool home, bool motors[ MM ], double pos[ MM ], int tosec );	//	Optel_tinyg_DLL.cpp
+
+
+//	A request is done.  Called locked, with the lock dropped around its callback (requests with
+//	a callback are forgotten once it's been called).
+
+static void finish( std::unique_lock<std::mutex> &l, request_t *r, bool ok )
+{
+	r -> ok = ok;
+
+	if ( r -> done != NULL )
+	{
+		tg_done_t	done = r -> done;
+		void		*ctx = r -> ctx;
+		int			id = r -> id;
+
+		r -> state = FREE;
+		l.unlock();
+		done( id, ok, ctx );
+		l.lock();
+	}
+	else
+		r -> state = DONE;
+
+	changed.notify_all();
+}
+
+
+//	The worker, started as generation mine.  It takes requests till the generation moves on.
+
+static void work( unsigned mine )
+{
+	std::unique_lock<std::mutex>	l( lock );
+	request_t						*r;
+	bool							ok;
+
+	while ( true )
+	{
+		changed.wait( l, [ mine ] { return( generation != mine || qcount > 0 ); } );
+		if ( generation != mine ) break;
+
+		r = &requests[ queue[ qhead ] ];
+		qhead = ( qhead + 1 ) % REQUESTS;
+		qcount --;
+		r -> state = RUNNING;
+
+		l.unlock();
+		ok = tg_async_run( r -> dev, r -> home, r -> motors, r -> pos, r -> tosec );
+		l.lock();
+
+		finish( l, r, ok );
+	}
+
+	alive = false;
+	changed.notify_all();
+}
+
+
+//	Queue a request, starting the worker if it isn't running.  Returns its number, 0 if it can't
+//	(also while a worker tg_async_stop() stopped waiting for is still running its request).
+
+static int submit( tg_device *dev, bool home, bool motors[ MM ], double pos[ MM ], int tosec, tg_done_t done, void *ctx )
+{
+	std::lock_guard<std::mutex>	l( lock );
+	request_t					*r;
+	int							i;
+
+	for ( i = 0; i < REQUESTS && requests[ i ].state != FREE; i ++ ) ;
+	if ( i >= REQUESTS )
+	{
+		printf( "Too many motion requests\n" );
+		return( 0 );
+	}
+
+	if ( !worker.joinable() )
+	{
+		if ( alive )
+		{
+			printf( "The last motion request is still running\n" );
+			return( 0 );
+		}
+		alive = true;
+		worker = std::thread( work, ++ generation );
+	}
+
+	r = &requests[ i ];
+	if ( ++ lastid <= 0 ) lastid = 1;
+	r -> id = lastid;
+	r -> state = QUEUED;
+	r -> dev = dev;
+	r -> home = home;
+	memcpy( r -> motors, motors, sizeof( r -> motors ) );
+	if ( pos != NULL ) memcpy( r -> pos, pos, sizeof( r -> pos ) );
+	r -> tosec = tosec;
+	r -> done = done;
+	r -> ctx = ctx;
+
+	queue[ ( qhead + qcount ++ ) % REQUESTS ] = i;
+	changed.notify_all();
+	return( r -> id );
+}
+
+
+int tg_move_async( bool move[ MM ], double pos[ MM ], int tosec, tg_done_t done, void *ctx )
+{
+	return( submit( NULL, false, move, pos, tosec, done, ctx ) );
+}
+
+
+int tg_home_async( bool home[ MM ], int tosec, tg_done_t done, void *ctx )
+{
+	return( submit( NULL, true, home, NULL, tosec, done, ctx ) );
+}
+
+
+int tg_dev_move_async( tg_device *dev, bool move[ MM ], double pos[ MM ], int tosec, tg_done_t done, void *ctx )
+{
+	return( submit( dev, false, move, pos, tosec, done, ctx ) );
+}
+
+
+int tg_dev_home_async( tg_device *dev, bool home[ MM ], int tosec, tg_done_t done, void *ctx )
+{
+	return( submit( dev, true, home, NULL, tosec, done, ctx ) );
+}
+
+
+//	Wait up to tosec (0 to just look) for a request without a callback.  Its result (1 it worked,
+//	0 it didn't) can be had once, TG_PENDING if it's still queued or running, TG_UNKNOWN if
+//	there's no such request.
+
+int tg_wait( int request, int tosec )
+{
+	std::unique_lock<std::mutex>	l( lock );
+	request_t						*r = NULL;
+
+	for ( int i = 0; i < REQUESTS && r == NULL; i ++ )
+		if ( requests[ i ].state != FREE && requests[ i ].id == request && requests[ i ].done == NULL ) r = &requests[ i ];
+
+	if ( r == NULL ) return( TG_UNKNOWN );
+
+	if ( !changed.wait_for( l, std::chrono::seconds( tosec ), [ r ] { return( r -> state == DONE ); } ) ) return( TG_PENDING );
+
+	r -> state = FREE;
+	return( r -> ok );
+}
+
+
+//	Stop the worker (tg_close_ports()).  Queued requests fail, the running one is waited for.
+//	The thread is detached rather than joined: this also runs from DllMain(), where waiting for
+//	a thread to end holds the loader lock it needs.  True once no worker is running; false if it
+//	still is after the wait, and the port is still its.
+//
+//	exiting is DllMain() at process termination: the worker has been terminated already, so it
+//	isn't waited for, and the queued requests are dropped without calling their callbacks.
+
+bool tg_async_stop( bool exiting )
+{
+	std::unique_lock<std::mutex>	l( lock );
+	int								tosec = 1;
+
+	if ( !worker.joinable() ) return( !alive || exiting );
+
+	generation ++;
+	while ( qcount > 0 )
+	{
+		request_t	*r = &requests[ queue[ qhead ] ];
+
+		qhead = ( qhead + 1 ) % REQUESTS;
+		qcount --;
+		if ( exiting )
+			r -> state = FREE;
+		else
+			finish( l, r, false );
+	}
+
+	if ( exiting )
+	{
+		worker.detach();
+		return( true );
+	}
+
+	for ( int i = 0; i < REQUESTS; i ++ )
+		if ( requests[ i ].state == RUNNING ) tosec += requests[ i ].tosec;
+
+	changed.notify_all();
+	changed.wait_for( l, std::chrono::seconds( tosec ), [] { return( !alive ); } );	//	not forever, the process may be exiting and the worker gone
+
+	worker.detach();
+	return( !alive );
+}
+
+
+//	A worker tg_async_stop() stopped waiting for is still running its request.
+
+bool tg_async_stopping( void )
+{
+	std::lock_guard<std::mutex>	l( lock );
+
+	return( alive && !worker.joinable() );
+}
+
+
+
+//	dev is being closed (tg_close()): its queued requests fail, and one that's running is waited
+//	for.  Not on the worker thread (from a request's callback).
+
+void tg_async_drop( tg_device *dev )
+{
+	std::unique_lock<std::mutex>	l( lock );
+	int								dropped[ REQUESTS ], n = 0, kept = 0, k;
+
+	for ( int j = 0; j < qcount; j ++ )
+	{
+		k = queue[ ( qhead + j ) % REQUESTS ];
+		if ( requests[ k ].dev == dev )
+			dropped[ n ++ ] = k;
+		else
+			queue[ ( qhead + kept ++ ) % REQUESTS ] = k;
+	}
+	qcount = kept;
+
+	for ( int j = 0; j < n; j ++ )
+		finish( l, &requests[ dropped[ j ] ], false );
+
+	changed.wait( l, [ dev ]
+	{
+		for ( int i = 0; i < REQUESTS; i ++ )
+			if ( requests[ i ].state == RUNNING && requests[ i ].dev == dev ) return( false );
+		return( true );
+	} );
+}
@@ -0,0 +1,118 @@
+//	==========================================================================================
+//	The motors the DLL is built for.  TinyG drives up to six axes, xyzabc, and the DLL is built
+//	for the first TG_AXES of them: 4 (xyza, the default) or 6 (make AXES=6, or TG_AXES=6 in
+//	the project's preprocessor definitions).  MM is TG_AXES, so a caller has to be
+//	built with the same value; tg_axes() says what the DLL was built with.
+//
+//	tg_axisset<'x','y',...> works out at compile time what depends on the axis set: the names,
+//	an axis letter's index (a table, nothing is searched), the status report filter, the range
+//	queries and the bits that say a report has had every position.
+//
+//	In text mode the status report has the fields TinyG saved ($sr is JSON only): a 6-axis
+//	board needs posb and posc added to it once, in JSON, for the snapshot to fill.
+// ---------------------------------------------------------------------
+// Rev    Date      By     Description
+// -----  --------  -----  ---------------------------------------------
+//		  10/16/26	DV	   Original
+//	==========================================================================================
+
+#pragma once
+
+#ifndef	TG_AXES
+#define	TG_AXES		4
+#endif
+
+#if	TG_AXES != 4 && TG_AXES != 6
+#error	TG_AXES is 4 (xyza) or 6 (xyzabc)
+#endif
+
+#ifdef	__cplusplus
+
+#include <array>
+
+template <char... Names>
+struct tg_axisset
+{
+	static constexpr int		n = sizeof...( Names );
+	static constexpr char		name[ n + 1 ] = { Names..., 0 };				//	"xyza"
+	static constexpr unsigned	seen = ( 1u << n ) - 1;							//	a bit per position reported
+
+	//	Axis index by letter, -1 if it isn't one of ours.
+
+	static constexpr std::array<signed char, 128>	index = []
+	{
+		std::array<signed char, 128>	t{ };
+		int								i = 0;
+
+		for ( auto &v : t ) v = -1;
+		( ( t[ Names ] = (signed char) i ++ ), ... );
+		return( t );
+	}();
+
+	static constexpr int of( char c )
+	{
+		return( ( c > 0 ) ? index[ c ] : -1 );
+	}
+
+	//	{"sr":{"posx":true,...,"vel":true,"stat":true}}, the status report fields we use.
+
+	static constexpr std::array<char, 7 + 12 * n + 26>	srfilter = []
+	{
+		std::array<char, 7 + 12 * n + 26>	s{ };
+		int									k = 0;
+
+		auto put = [ & ]( const char *p ) { while ( *p ) s[ k ++ ] = *p ++; };
+
+		put( "{\"sr\":{" );
+		for ( char c : { Names... } )
+		{
+			put( "\"pos" );
+			s[ k ++ ] = c;
+			put( "\":true," );
+		}
+		put( "\"vel\":true,\"stat\":true}}\n" );
+		return( s );
+	}();
+
+	//	The range queries, two per motor, all in one: $xtn\r$xtm\r$ytn\r... in text mode and
+	//	{"xtn":null}\n{"xtm":null}\n... in JSON.
+
+	static constexpr std::array<char, 10 * n + 1>	rangetext = []
+	{
+		std::array<char, 10 * n + 1>	s{ };
+		int								k = 0;
+
+		for ( char c : { Names... } )
+			for ( char m : { 'n', 'm' } )
+				for ( char ch : { '$', c, 't', m, '\r' } ) s[ k ++ ] = ch;
+		return( s );
+	}();
+
+	static constexpr std::array<char, 26 * n + 1>	rangejson = []
+	{
+		std::array<char, 26 * n + 1>	s{ };
+		int								k = 0;
+
+		auto put = [ & ]( const char *p ) { while ( *p ) s[ k ++ ] = *p ++; };
+
+		for ( char c : { Names... } )
+			for ( char m : { 'n', 'm' } )
+			{
+				put( "{\"" );
+				for ( char ch : { c, 't', m } ) s[ k ++ ] = ch;
+				put( "\":null}\n" );
+			}
+		return( s );
+	}();
+};
+
+#if	TG_AXES == 6
+typedef tg_axisset<'x', 'y', 'z', 'a', 'b', 'c'>	tg_axes_t;
+#else
+typedef tg_axisset<'x', 'y', 'z', 'a'>				tg_axes_t;
+#endif
+
+static_assert( tg_axes_t::n == TG_AXES, "tg_axes_t doesn't match TG_AXES" );
+static_assert( tg_axes_t::of( 'a' ) == 3 && tg_axes_t::of( 'q' ) < 0, "axis index table" );
+
+#endif
@@ -0,0 +1,114 @@
+//	==========================================================================================
+//	Connection cache file, see tgcache.h.
+// ---------------------------------------------------------------------
+// Rev    Date      By     Description
+// -----  --------  -----  ---------------------------------------------
+//		  10/16/26	DV	   Original
+//		  10/16/26	DV	   Ranges for the build's axis set (tgaxes.h), all of them or they aren't used
+//	==========================================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tgcache.h"
+
+
+//	The cache file's name into path.  False if there's nowhere to put it.
+
+static bool cachepath( char *path, size_t size )
+{
+	const char	*p;
+
+	if ( ( p = getenv( "TINYG_CACHE" ) ) != NULL && *p )
+		return( snprintf( path, size, "%s", p ) < (int) size );
+
+#ifdef	_WIN32
+	if ( ( p = getenv( "LOCALAPPDATA" ) ) != NULL && *p )
+		return( snprintf( path, size, "%s\\optel_tinyg.cache", p ) < (int) size );
+#else
+	if ( ( p = getenv( "HOME" ) ) != NULL && *p )
+		return( snprintf( path, size, "%s/.optel_tinyg.cache", p ) < (int) size );
+#endif
+	return( false );
+}
+
+
+bool tgcache_load( tgcache_t *c )
+{
+	char		path[ 300 ], buf[ 200 ], name[ 16 ], axis;
+	FILE		*f;
+	int			json, got = 0, i;
+	unsigned	ranges = 0;
+	double		min, max;
+
+	memset( c, 0, sizeof( *c ) );
+	if ( !cachepath( path, sizeof( path ) ) || ( f = fopen( path, "rt" ) ) == NULL ) return( false );
+
+	while ( fgets( buf, sizeof( buf ), f ) != NULL )
+	{
+		buf[ strcspn( buf, "\r\n" ) ] = 0;
+		if ( sscanf( buf, "%15s", name ) != 1 ) continue;
+
+		if ( !strcmp( name, "path" ) )
+			got += sscanf( buf + 4, " %63s", c -> path );
+		else if ( !strcmp( name, "serial" ) )
+			sscanf( buf + 6, " %63s", c -> serial );
+		else if ( !strcmp( name, "baud" ) )
+			got += sscanf( buf + 4, "%ld", &c -> baud );
+		else if ( !strcmp( name, "build" ) )
+			sscanf( buf + 5, "%lf", &c -> build );
+		else if ( !strcmp( name, "json" ) && sscanf( buf + 4, "%d", &json ) == 1 )
+			c -> json = json != 0;
+		else if ( !strcmp( name, "range" ) && sscanf( buf + 5, " %c %lf %lf", &axis, &min, &max ) == 3 && ( i = tg_axes_t::of( axis ) ) >= 0 )
+		{
+			c -> range[ i ].min = min;
+			c -> range[ i ].max = max;
+			ranges |= 1 << i;
+		}
+	}
+	fclose( f );
+	c -> ranges = ranges == tg_axes_t::seen;									//	a 4-axis build's file has no b or c
+
+	if ( got < 2 || c -> baud <= 0 )
+	{
+		memset( c, 0, sizeof( *c ) );
+		return( false );
+	}
+	return( true );
+}
+
+
+//	Written to a temporary and renamed, so a reader never sees half a file.
+
+bool tgcache_save( const tgcache_t *c )
+{
+	char	path[ 300 ], tmp[ 310 ];
+	FILE	*f;
+	bool	ok;
+
+	if ( !cachepath( path, sizeof( path ) ) ) return( false );
+	snprintf( tmp, sizeof( tmp ), "%s.tmp", path );
+	if ( ( f = fopen( tmp, "wt" ) ) == NULL ) return( false );
+
+	fprintf( f, "path %s\n", c -> path );
+	if ( *c -> serial ) fprintf( f, "serial %s\n", c -> serial );
+	fprintf( f, "baud %ld\n", c -> baud );
+	if ( c -> build > 0.0 ) fprintf( f, "build %.2f\n", c -> build );
+	fprintf( f, "json %d\n", c -> json );
+	for ( int i = 0; c -> ranges && i < tg_axes_t::n; i ++ )
+		fprintf( f, "range %c %.3f %.3f\n", tg_axes_t::name[ i ], c -> range[ i ].min, c -> range[ i ].max );
+
+	ok = !ferror( f );
+	ok = !fclose( f ) && ok;
+
+#ifdef	_WIN32
+	if ( ok ) remove( path );													//	rename() won't replace a file
+#endif
+	if ( !ok || rename( tmp, path ) )
+	{
+		remove( tmp );
+		return( false );
+	}
+	return( true );
+}
@@ -0,0 +1,39 @@
+//	==========================================================================================
+//	Connection cache.  The last TinyG tg_open_ports() talked to is kept in a small file so the
+//	next process can go straight to it with a short probe, and skip asking for the motor ranges
+//	if the firmware build hasn't changed.  The file is TINYG_CACHE, or optel_tinyg.cache in
+//	%LOCALAPPDATA% (.optel_tinyg.cache in $HOME on POSIX systems):
+//
+//		path /dev/ttyUSB0
+//		serial D30AOLGYA
+//		baud 115200
+//		build 440.20
+//		json 0
+//		range x 0.000 200.000
+//		...
+//
+//	It's only a hint: a port that doesn't answer, or a different build, and it's ignored.
+// ---------------------------------------------------------------------
+// Rev    Date      By     Description
+// -----  --------  -----  ---------------------------------------------
+//		  10/16/26	DV	   Original
+//	==========================================================================================
+
+#pragma once
+
+#include "optel_tinyg_dll.h"
+#include "tgaxes.h"
+
+typedef struct
+{
+	char		path[ 64 ];														//	device, COM5 or /dev/ttyUSB0
+	char		serial[ 64 ];													//	USB serial number, "" if it has none
+	long		baud;
+	double		build;															//	firmware build ($fb)
+	bool		json;															//	JSON protocol
+	bool		ranges;															//	range[] is good
+	tg_range_t	range[ TG_AXES ];												//	x, y, z, a (, b, c)
+} tgcache_t;
+
+bool tgcache_load( tgcache_t *c );												//	false if there's no cache (c is cleared)
+bool tgcache_save( const tgcache_t *c );										//	false if it can't be written
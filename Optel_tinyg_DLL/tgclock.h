@@ -0,0 +1,123 @@
+//	==========================================================================================
+//	Time for the DLL and the comm layer: a monotonic clock in ns and deadlines on it.  clock()
+//	won't do for waits: on Linux it's CPU time and stands still while we sleep, on Windows it
+//	ticks in ms and wall time.  tgclock_now() is the steady clock (QueryPerformanceCounter on
+//	Windows, CLOCK_MONOTONIC on Linux) unless a virtual clock has been put in with tgclock_set(),
+//	for tests that want to move time themselves.
+//
+//	Timeouts passed around keep their clock() units (CLOCKS_PER_SEC per second) so callers
+//	don't change; a wait turns its timeout into a deadline once and then asks it what's left.
+//
+//		tgdeadline_t	d = tgdeadline_ticks( timeout );
+//
+//		while ( !tgdeadline_passed( d ) )
+//			... rxwait( d ) ...
+//
+//	With a virtual clock the deadlines follow it, but the waits still sleep on the real one,
+//	for no longer than the virtual time left.
+// ---------------------------------------------------------------------
+// Rev    Date      By     Description
+// -----  --------  -----  ---------------------------------------------
+//		  10/16/26	DV	   Original
+//	==========================================================================================
+
+#pragma once
+
+#include <stdint.h>
+#include <limits.h>
+#include <time.h>
+#include <atomic>
+#include <chrono>
+
+#define	TGCLOCK_TICKNS	( 1000000000LL / CLOCKS_PER_SEC )						//	ns per clock() unit
+
+typedef int64_t	( *tgclock_fn )( void );
+
+inline std::atomic<tgclock_fn>	tgclock_source( nullptr );						//	the virtual clock, nullptr for the real one
+
+typedef struct
+{
+	int64_t		at;																//	tgclock_now() when it's up
+} tgdeadline_t;
+
+
+//	The steady clock, ns.
+
+inline int64_t tgclock_real( void )
+{
+	return( std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count() );
+}
+
+
+inline int64_t tgclock_now( void )
+{
+	tgclock_fn	fn = tgclock_source.load( std::memory_order_relaxed );
+
+	return( ( fn != nullptr ) ? fn() : tgclock_real() );
+}
+
+
+//	Put in a virtual clock, nullptr for the real one again.  It has to be monotonic.
+
+inline void tgclock_set( tgclock_fn fn )
+{
+	tgclock_source.store( fn );
+}
+
+
+inline tgdeadline_t tgdeadline_ns( int64_t ns )
+{
+	return( tgdeadline_t{ tgclock_now() + ns } );
+}
+
+
+//	timeout in clock() units from now.
+
+inline tgdeadline_t tgdeadline_ticks( long timeout )
+{
+	return( tgdeadline_ns( (int64_t) timeout * TGCLOCK_TICKNS ) );
+}
+
+
+//	ns left, 0 once it's passed.
+
+inline int64_t tgdeadline_left( tgdeadline_t d )
+{
+	int64_t		left = d.at - tgclock_now();
+
+	return( ( left > 0 ) ? left : 0 );
+}
+
+
+inline bool tgdeadline_passed( tgdeadline_t d )
+{
+	return( tgclock_now() >= d.at );
+}
+
+
+//	What's left in clock() units, rounded down.
+
+inline long tgdeadline_ticksleft( tgdeadline_t d )
+{
+	int64_t		t = tgdeadline_left( d ) / TGCLOCK_TICKNS;
+
+	return( ( t > LONG_MAX ) ? LONG_MAX : (long) t );
+}
+
+
+//	What's left in ms for Sleep(), poll() and the like, rounded up so they don't wake early.
+
+inline int tgdeadline_ms( tgdeadline_t d )
+{
+	int64_t		ms = ( tgdeadline_left( d ) + 999999 ) / 1000000;
+
+	return( ( ms > INT_MAX ) ? INT_MAX : (int) ms );
+}
+
+
+//	The sooner of two.
+
+inline tgdeadline_t tgdeadline_min( tgdeadline_t a, tgdeadline_t b )
+{
+	return( ( a.at < b.at ) ? a : b );
+}
@@ -0,0 +1,119 @@
+//	==========================================================================================
+//	TinyG command lines built without printf.  A line goes together in a fixed buffer on the
+//	caller's stack: constant parts are copied with their length known at compile time, numbers
+//	are converted with to_chars(), and the length is kept so nothing rescans the buffer and the
+//	line goes out with outcoms( line, len ).
+//
+//		tgcmd_t	c;
+//
+//		tgcmd_gcode( &c, json );									{"gc":"  or nothing
+//		tgcmd_put( &c, "g0" );
+//		tgcmd_axis( &c, 'x', 10.0 );								 x10.000
+//		tgcmd_end( &c, json );										"}\n  or \r
+//
+//	A line that doesn't fit is cut short and marked full, tgcmd_ok() says whether it's good.
+// ---------------------------------------------------------------------
+// Rev    Date      By     Description
+// -----  --------  -----  ---------------------------------------------
+//		  10/16/26	DV	   Original
+//	==========================================================================================
+
+#pragma once
+
+#include <stddef.h>
+#include <string.h>
+#include <charconv>
+
+#define	TGCMD_MAX		300														//	longest line, with its terminator
+
+typedef struct
+{
+	char		line[ TGCMD_MAX ];
+	int			len;
+	bool		full;															//	something didn't fit
+} tgcmd_t;
+
+
+inline void tgcmd_clear( tgcmd_t *c )
+{
+	c -> len = 0;
+	c -> full = false;
+	c -> line[ 0 ] = 0;
+}
+
+
+inline bool tgcmd_ok( const tgcmd_t *c )
+{
+	return( !c -> full );
+}
+
+
+//	n characters of s.
+
+inline void tgcmd_put( tgcmd_t *c, const char *s, size_t n )
+{
+	if ( c -> len + n >= sizeof( c -> line ) )
+	{
+		c -> full = true;
+		n = sizeof( c -> line ) - 1 - c -> len;
+	}
+	memcpy( c -> line + c -> len, s, n );
+	c -> len += (int) n;
+	c -> line[ c -> len ] = 0;
+}
+
+
+//	A string literal, its length is the array's.
+
+template <size_t N>
+inline void tgcmd_put( tgcmd_t *c, const char ( &s )[ N ] )
+{
+	tgcmd_put( c, s, N - 1 );
+}
+
+
+inline void tgcmd_char( tgcmd_t *c, char ch )
+{
+	tgcmd_put( c, &ch, 1 );
+}
+
+
+//	v with 3 decimals, as %.3f does.
+
+inline void tgcmd_num( tgcmd_t *c, double v )
+{
+	char					num[ 32 ];
+	std::to_chars_result	r = std::to_chars( num, num + sizeof( num ), v, std::chars_format::fixed, 3 );
+
+	tgcmd_put( c, num, ( r.ec == std::errc() ) ? r.ptr - num : 0 );
+}
+
+
+//	" x10.000", a motor and where it goes.
+
+inline void tgcmd_axis( tgcmd_t *c, char axis, double v )
+{
+	char	head[ 2 ] = { ' ', axis };
+
+	tgcmd_put( c, head, 2 );
+	tgcmd_num( c, v );
+}
+
+
+//	The start and end of a gcode line: {"gc":"..."}\n in JSON, ...\r in text.  tgcmd_gcode()
+//	clears c first.
+
+inline void tgcmd_gcode( tgcmd_t *c, bool json )
+{
+	tgcmd_clear( c );
+	if ( json ) tgcmd_put( c, "{\"gc\":\"" );
+}
+
+
+inline void tgcmd_end( tgcmd_t *c, bool json )
+{
+	if ( json )
+		tgcmd_put( c, "\"}\n" );
+	else
+		tgcmd_char( c, '\r' );
+}
@@ -0,0 +1,165 @@
+//	==========================================================================================
+//	Connecting to TinyG.  Finding and probing the port can take seconds (10 s if nothing
+//	answers), so it's no longer done while the DLL loads.  The caller either
+//
+//		tg_open_ports()				connects now, on its own thread
+//		tg_connect_async()			starts connecting on a thread of ours and returns, then
+//		tg_connect_wait( tosec )	waits for it (0 to just look)
+//
+//	or does neither, and the first call that talks to TinyG connects (tg_ready()).  Calls made
+//	while a connection is being made wait for it.  Once tg_close_ports() has closed the ports
+//	nothing connects again until tg_open_ports() or tg_connect_async() is called.
+// ---------------------------------------------------------------------
+// Rev    Date      By     Description
+// -----  --------  -----  ---------------------------------------------
+//		  10/16/26	DV	   tg_connect_stop( true ) at process termination doesn't wait
+//		  10/16/26	DV	   tg_connect_stop() waits STOP_WAIT for a connect at most, the process may be exiting
+//		  10/16/26	DV	   Original
+//	==========================================================================================
+
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "optel_tinyg_api.h"
+
+#define	STOP_WAIT		1														//	s tg_connect_stop() waits for a connection being made
+
+typedef enum
+{
+	IDLE,																		//	never tried, the first call connects
+	CONNECTING,
+	CONNECTED,
+	FAILED,
+	CLOSED																		//	tg_close_ports()
+} state_t;
+
+static std::atomic<int>			state( IDLE );
+static std::mutex				lock;											//	changes of state
+static std::condition_variable	changed;										//	a connection was made or failed
+static std::thread				connector;
+static bool						abandoned;										//	tg_connect_stop() gave up on the connection being made
+
+BOOL tg_connect( void );														//	Optel_tinyg_DLL.cpp
+void tg_disconnect( void );
+
+
+//	Connect on this thread.  Called locked, with the lock dropped while connecting.  If the ports
+//	were closed meanwhile and tg_connect_stop() gave up waiting, what was opened is closed again.
+
+static bool establish( std::unique_lock<std::mutex> &l )
+{
+	bool	ok;
+
+	state = CONNECTING;
+	l.unlock();
+	ok = tg_connect();
+	l.lock();
+
+	if ( abandoned )
+	{
+		if ( ok )
+		{
+			l.unlock();
+			tg_disconnect();
+			l.lock();
+		}
+		abandoned = false;
+		changed.notify_all();
+		return( false );
+	}
+
+	state = ( ok ) ? CONNECTED : FAILED;
+	changed.notify_all();
+	return( ok );
+}
+
+
+//	Wait for a connection being made to be done, or one that was abandoned to be closed.  Called
+//	locked.
+
+static void settle( std::unique_lock<std::mutex> &l )
+{
+	changed.wait( l, [] { return( state != CONNECTING && !abandoned ); } );
+}
+
+
+BOOL tg_open_ports( void )
+{
+	std::unique_lock<std::mutex>	l( lock );
+
+	settle( l );
+	if ( state == CONNECTED ) return( TRUE );
+	return( establish( l ) );
+}
+
+
+//	Start connecting on a thread of ours.  False if it's already connected (or connecting).
+
+bool tg_connect_async( void )
+{
+	std::unique_lock<std::mutex>	l( lock );
+
+	if ( state == CONNECTED || state == CONNECTING || abandoned ) return( false );
+
+	if ( connector.joinable() ) connector.join();								//	the last one, it's done
+	state = CONNECTING;
+	connector = std::thread( []
+	{
+		std::unique_lock<std::mutex>	l( lock );
+
+		establish( l );
+	} );
+	return( true );
+}
+
+
+//	Wait up to tosec (0 to just look) for a connection being made.  1 if TinyG is connected,
+//	0 if it isn't, TG_PENDING if it's still being connected.
+
+int tg_connect_wait( int tosec )
+{
+	std::unique_lock<std::mutex>	l( lock );
+
+	if ( !changed.wait_for( l, std::chrono::seconds( tosec ), [] { return( state != CONNECTING ); } ) ) return( TG_PENDING );
+	return( state == CONNECTED );
+}
+
+
+//	Make sure TinyG is connected before talking to it: wait for a connection being made, or
+//	make one if nothing has tried yet (and open says to).  True if it's connected.
+
+bool tg_ready( bool open )
+{
+	std::unique_lock<std::mutex>	l( lock, std::defer_lock );
+
+	if ( state == CONNECTED ) return( true );
+
+	l.lock();
+	settle( l );
+	if ( state == IDLE && open ) return( establish( l ) );
+	return( state == CONNECTED );
+}
+
+
+//	The ports are being closed (tg_close_ports()): nothing connects again till it's asked to.  A
+//	connection being made is waited for, but only STOP_WAIT: this also runs from DllMain(), and
+//	when the process exits the connecting thread is already gone and never finishes.  If it's
+//	still connecting when we give up, it closes the port itself when it's done (establish()).
+//	The thread is detached rather than joined, waiting for it would hold the loader lock it needs.
+//	exiting (process termination, see tg_async_stop()) doesn't wait at all.
+
+void tg_connect_stop( bool exiting )
+{
+	std::unique_lock<std::mutex>	l( lock );
+
+	if ( exiting && state == CONNECTING )
+		abandoned = true;
+	else
+		if ( !changed.wait_for( l, std::chrono::seconds( STOP_WAIT ), [] { return( state != CONNECTING ); } ) ) abandoned = true;
+	state = CLOSED;
+	if ( connector.joinable() ) connector.detach();
+}
@@ -0,0 +1,128 @@
+//	==========================================================================================
+//	TinyG reply dispatcher, see tgdispatch.h.
+// ---------------------------------------------------------------------
+// Rev    Date      By     Description
+// -----  --------  -----  ---------------------------------------------
+//		  10/16/26	DV	   Original
+//	==========================================================================================
+
+#include <string.h>
+
+#include "commmatch.h"
+#include "tgdispatch.h"
+
+
+//	The matcher for tgline_marks(), built the first time it's wanted.  Pattern ids are the
+//	TGMARK_ bit numbers.
+
+static const commmatch_t *tgline_matcher( void )
+{
+	static const commmatch_t	m = []
+	{
+		commmatch_t		m;
+
+		match_init( &m );
+		match_add( &m, "ok>", 3 );
+		match_add( &m, "err", 3 );
+		match_add( &m, "stat:3", 6 );
+		match_build( &m );
+		return( m );
+	}();
+
+	return( &m );
+}
+
+
+unsigned tgline_marks( const char *line )
+{
+	return( match_scan( tgline_matcher(), line, strlen( line ) ) );
+}
+
+
+//	What a line is.  Text lines are told apart the way TinyG starts them, after any leading
+//	blanks and the \r of a \r\n.
+
+tgline_kind_t tgline_classify( const char *line, tgjson_t *j )
+{
+	const char	*p, *q;
+	unsigned	marks;
+
+	for ( p = line; *p == ' ' || *p == '\t' || *p == '\r'; p ++ ) ;
+
+	if ( tgjson_parse( p, j ) )
+	{
+		switch ( j -> kind )
+		{
+			case TGJSON_R:		return( ( tgjson_ok( j ) ) ? TGLINE_RESPONSE : TGLINE_ERROR );
+			case TGJSON_SR:		return( TGLINE_SR );
+			case TGJSON_QR:		return( TGLINE_QR );
+			default:			return( TGLINE_OTHER );
+		}
+	}
+	j -> kind = TGJSON_NONE;
+
+	if ( !strncmp( p, "qr:", 3 ) ) return( TGLINE_QR );
+	if ( !strncmp( p, "pos", 3 ) || !strncmp( p, "vel:", 4 ) || !strncmp( p, "stat:", 5 ) ) return( TGLINE_SR );
+	if ( *p == '[' && ( q = strchr( p, ']' ) ) != NULL && q - p <= 5 ) return( TGLINE_ECHO );
+
+	marks = tgline_marks( p );
+	if ( marks & TGMARK_PROMPT ) return( TGLINE_PROMPT );
+	if ( marks & TGMARK_ERROR ) return( TGLINE_ERROR );
+	return( TGLINE_OTHER );
+}
+
+
+bool tgline_answer( tgline_kind_t kind )
+{
+	return( kind == TGLINE_PROMPT || kind == TGLINE_RESPONSE || kind == TGLINE_ERROR );
+}
+
+
+void tgdispatch_clear( tgdispatch_t *d )
+{
+	tgreq_t		r;
+
+	while ( d -> tail != d -> head )
+	{
+		r = d -> req[ d -> tail ++ % TGDISPATCH_DEPTH ];
+		if ( r.fn != NULL ) r.fn( r.ctx, TGLINE_NONE, "", NULL );
+	}
+}
+
+
+bool tgdispatch_push( tgdispatch_t *d, tgreq_fn fn, void *ctx, int64_t sent )
+{
+	if ( d -> head - d -> tail >= TGDISPATCH_DEPTH ) return( false );
+
+	d -> req[ d -> head ++ % TGDISPATCH_DEPTH ] = tgreq_t{ fn, ctx, sent };
+	return( true );
+}
+
+
+int tgdispatch_pending( const tgdispatch_t *d )
+{
+	return( (int) ( d -> head - d -> tail ) );
+}
+
+
+//	Hand a line to the oldest request, and take the request off if it's the answer.  Reports,
+//	and lines with nothing pending, go nowhere.
+
+bool tgdispatch_route( tgdispatch_t *d, tgline_kind_t kind, const char *line, const tgjson_t *j, tgreq_t *done )
+{
+	tgreq_t		*r;
+
+	if ( kind == TGLINE_SR || kind == TGLINE_QR || d -> tail == d -> head ) return( false );
+
+	r = &d -> req[ d -> tail % TGDISPATCH_DEPTH ];
+	if ( !tgline_answer( kind ) )
+	{
+		if ( r -> fn != NULL ) r -> fn( r -> ctx, kind, line, j );
+		return( false );
+	}
+
+	*done = *r;
+	d -> tail ++;																//	off before the callback, which may push another
+	if ( done -> fn != NULL ) done -> fn( done -> ctx, kind, line, j );
+	return( true );
+}
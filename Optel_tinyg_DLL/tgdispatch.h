@@ -0,0 +1,85 @@
+//	==========================================================================================
+//	TinyG reply dispatcher.  Every line TinyG sends is one of
+//
+//		tinyg [mm] ok>										prompt: a text command is done
+//		tinyg [mm] err: Unrecognized command: $xx			error: it's done, and refused
+//		{"r":{...},"f":[1,0,8,1234]}						JSON response, an error if its status isn't 0
+//		posx:10.000,vel:6000.000,stat:5   {"sr":{...}}		status report
+//		qr:27   {"qr":27}									queue report
+//		[xtn] x travel minimum            0.000 mm			parameter echo
+//
+//	or something else (the lines of the ? report, the banner, exception reports).
+//	tgline_classify() says which.  What it looks for anywhere in a text line (ok>, err, stat:3)
+//	is found in one pass by a matcher (commmatch.h), tgline_marks() says which turned up.
+//
+//	Commands are answered in the order they were sent, so the dispatcher keeps the requests
+//	that haven't been answered in a FIFO.  Each line goes to the oldest one, whose answer (a
+//	prompt, a response or an error) takes it off.  Several commands can then be sent before the
+//	first is answered.  Reports aren't anybody's answer: the receive tap keeps them, and
+//	tgdispatch_route() passes them by.  Neither does it route lines that come with nothing
+//	pending.
+//
+//		tgdispatch_push( &d, fn, &ctx, sent );					for each command sent
+//		...
+//		kind = tgline_classify( line, &j );						for each line read
+//		if ( tgdispatch_route( &d, kind, line, &j, &done ) )	done is the request just answered
+//
+//	Lines and replies are never linked by an id (TinyG doesn't send one), so after a reply is
+//	lost the requests are dropped (tgdispatch_clear()) rather than left to take the wrong ones.
+// ---------------------------------------------------------------------
+// Rev    Date      By     Description
+// -----  --------  -----  ---------------------------------------------
+//		  10/16/26	DV	   Text lines are scanned once for everything, tgline_marks()
+//		  10/16/26	DV	   Original
+//	==========================================================================================
+
+#pragma once
+
+#include <stdint.h>
+
+#include "tgjson.h"
+
+#define	TGDISPATCH_DEPTH	16													//	requests waiting for answers, a power of 2
+
+typedef enum
+{
+	TGLINE_NONE,																//	no line, the request was dropped unanswered
+	TGLINE_PROMPT,																//	ok>, the text command's done
+	TGLINE_RESPONSE,															//	{"r":...} with a good footer and status 0
+	TGLINE_ERROR,																//	err, or a response with a bad footer or status
+	TGLINE_SR,																	//	status report
+	TGLINE_QR,																	//	queue report
+	TGLINE_ECHO,																//	[name] description value, a parameter
+	TGLINE_OTHER
+} tgline_kind_t;
+
+//	A request's lines: each echo and other line while it's the oldest, then its answer (or
+//	TGLINE_NONE with line "" if it's dropped).  j is the line parsed, kind TGJSON_NONE for text.
+
+typedef void	( *tgreq_fn )( void *ctx, tgline_kind_t kind, const char *line, const tgjson_t *j );
+
+typedef struct
+{
+	tgreq_fn	fn;																//	NULL if nothing is wanted but the answer to come
+	void		*ctx;
+	int64_t		sent;															//	status_now() when it went out, 0 if it isn't timed
+} tgreq_t;
+
+typedef struct
+{
+	tgreq_t		req[ TGDISPATCH_DEPTH ];
+	unsigned	head, tail;														//	pushed, answered: req[ tail ] is the oldest
+} tgdispatch_t;
+
+#define	TGMARK_PROMPT		0x01												//	ok>
+#define	TGMARK_ERROR		0x02												//	err
+#define	TGMARK_STOP			0x04												//	stat:3, a text status report of a stop
+
+tgline_kind_t tgline_classify( const char *line, tgjson_t *j );				//	j gets JSON lines parsed
+unsigned tgline_marks( const char *line );										//	TGMARK_ bits
+bool tgline_answer( tgline_kind_t kind );										//	a prompt, a response or an error
+
+void tgdispatch_clear( tgdispatch_t *d );										//	drop what's pending, each gets TGLINE_NONE
+bool tgdispatch_push( tgdispatch_t *d, tgreq_fn fn, void *ctx, int64_t sent );	//	false if DEPTH are pending
+int tgdispatch_pending( const tgdispatch_t *d );
+bool tgdispatch_route( tgdispatch_t *d, tgline_kind_t kind, const char *line, const tgjson_t *j, tgreq_t *done );	//	true if line answered *done
@@ -0,0 +1,291 @@
+//	==========================================================================================
+//	TinyG JSON reply parser, see tgjson.h.
+//
+//	A recursive descent over the line that keeps the scalar members it finds.  Strings aren't
+//	unescaped (TinyG doesn't send escapes in anything we look at), arrays other than the footer
+//	are skipped.
+// ---------------------------------------------------------------------
+// Rev    Date      By     Description
+// -----  --------  -----  ---------------------------------------------
+//		  10/16/26	DV	   Original
+//	==========================================================================================
+
+#include <stdint.h>
+#include <string.h>
+#include <charconv>
+
+#include "tgjson.h"
+
+#define	MAXDEPTH		8														//	objects nested deeper than this are refused
+
+typedef struct
+{
+	std::string_view	s;
+	size_t				i;														//	next character
+	size_t				fcomma;													//	the footer's last comma, what the checksum covers
+} cursor_t;
+
+static bool member( cursor_t *c, tgjson_t *j, std::string_view group, std::string_view name, int depth );
+
+
+static void skip( cursor_t *c )
+{
+	while ( c -> i < c -> s.size() && strchr( " \t\r\n", c -> s[ c -> i ] ) != NULL ) c -> i ++;
+}
+
+
+//	Step over ch if it's next.
+
+static bool expect( cursor_t *c, char ch )
+{
+	skip( c );
+	if ( c -> i < c -> s.size() && c -> s[ c -> i ] == ch )
+	{
+		c -> i ++;
+		return( true );
+	}
+	return( false );
+}
+
+
+//	A string, *v gets what's between the quotes.
+
+static bool string( cursor_t *c, std::string_view *v )
+{
+	size_t	start;
+
+	if ( !expect( c, '"' ) ) return( false );
+
+	for ( start = c -> i; c -> i < c -> s.size() && c -> s[ c -> i ] != '"'; c -> i ++ )
+		if ( c -> s[ c -> i ] == '\\' ) c -> i ++;
+
+	if ( c -> i >= c -> s.size() ) return( false );
+
+	*v = c -> s.substr( start, c -> i ++ - start );
+	return( true );
+}
+
+
+//	A string, number, true, false or null (TinyG also takes n for null).
+
+static bool scalar( cursor_t *c, tgjson_pair_t *p )
+{
+	size_t	start;
+
+	p -> value = 0.0;
+	p -> number = false;
+
+	skip( c );
+	if ( c -> i < c -> s.size() && c -> s[ c -> i ] == '"' ) return( string( c, &p -> text ) );
+
+	for ( start = c -> i; c -> i < c -> s.size() && strchr( ",}] \t\r\n", c -> s[ c -> i ] ) == NULL; c -> i ++ ) ;
+	p -> text = c -> s.substr( start, c -> i - start );
+
+	if ( p -> text.empty() ) return( false );
+
+	auto	r = std::from_chars( p -> text.data(), p -> text.data() + p -> text.size(), p -> value );
+
+	if ( r.ec == std::errc() && r.ptr == p -> text.data() + p -> text.size() )
+		p -> number = true;
+	else
+		if ( p -> text == "true" )
+			p -> value = 1.0;
+		else
+			if ( p -> text != "false" && p -> text != "null" && p -> text != "n" ) return( false );
+
+	return( true );
+}
+
+
+//	Step over an array we don't keep.
+
+static bool skiparray( cursor_t *c, int depth )
+{
+	tgjson_pair_t	p;
+
+	if ( !expect( c, '[' ) ) return( false );
+	if ( expect( c, ']' ) ) return( true );
+
+	do
+	{
+		skip( c );
+		if ( c -> i >= c -> s.size() || depth >= MAXDEPTH ) return( false );
+
+		if ( c -> s[ c -> i ] == '[' )
+		{
+			if ( !skiparray( c, depth + 1 ) ) return( false );
+		}
+		else
+			if ( c -> s[ c -> i ] == '{' )
+			{
+				tgjson_t	scratch;										//	members of objects in arrays aren't kept
+
+				scratch.npairs = TGJSON_PAIRS;
+				scratch.nf = 0;
+				if ( !member( c, &scratch, std::string_view(), std::string_view(), depth + 1 ) ) return( false );
+			}
+			else
+				if ( !scalar( c, &p ) ) return( false );
+	}
+	while ( expect( c, ',' ) );
+
+	return( expect( c, ']' ) );
+}
+
+
+//	"f":[protocol,status,bytes,checksum]
+
+static bool footer( cursor_t *c, tgjson_t *j )
+{
+	tgjson_pair_t	p;
+
+	if ( !expect( c, '[' ) ) return( false );
+
+	j -> nf = 0;
+	do
+	{
+		if ( j -> nf ) c -> fcomma = c -> i - 1;
+		if ( !scalar( c, &p ) || !p.number ) return( false );
+		if ( j -> nf < 4 ) j -> f[ j -> nf ++ ] = (int) p.value;
+	}
+	while ( expect( c, ',' ) );
+
+	return( expect( c, ']' ) );
+}
+
+
+//	An object, its members go in group.
+
+static bool object( cursor_t *c, tgjson_t *j, std::string_view group, int depth )
+{
+	std::string_view	name;
+
+	if ( !expect( c, '{' ) ) return( false );
+	if ( expect( c, '}' ) ) return( true );
+
+	do
+	{
+		if ( !string( c, &name ) || !expect( c, ':' ) ) return( false );
+		if ( !member( c, j, group, name, depth ) ) return( false );
+	}
+	while ( expect( c, ',' ) );
+
+	return( expect( c, '}' ) );
+}
+
+
+//	The value of member name.  Objects in the body become the group of their members, objects at
+//	the top ("r", "sr"...) are the body.
+
+static bool member( cursor_t *c, tgjson_t *j, std::string_view group, std::string_view name, int depth )
+{
+	tgjson_pair_t	p;
+
+	skip( c );
+	if ( c -> i >= c -> s.size() ) return( false );
+
+	switch ( c -> s[ c -> i ] )
+	{
+	case '{':
+		if ( depth >= MAXDEPTH ) return( false );
+		return( object( c, j, ( depth ) ? name : std::string_view(), depth + 1 ) );
+
+	case '[':
+		if ( name == "f" ) return( footer( c, j ) );							//	g2core puts it inside "r"
+		return( skiparray( c, depth ) );
+
+	default:
+		if ( !scalar( c, &p ) ) return( false );
+
+		if ( j -> npairs < TGJSON_PAIRS )
+		{
+			p.group = group;
+			p.name = name;
+			j -> pair[ j -> npairs ++ ] = p;
+		}
+		return( true );
+	}
+}
+
+
+bool tgjson_parse( std::string_view line, tgjson_t *j )
+{
+	cursor_t			c = { line, 0, 0 };
+	std::string_view	name;
+
+	j -> kind = TGJSON_NONE;
+	j -> npairs = 0;
+	j -> nf = 0;
+	j -> checksum = false;
+
+	if ( !expect( &c, '{' ) ) return( false );
+
+	do
+	{
+		if ( !string( &c, &name ) || !expect( &c, ':' ) ) break;
+
+		if ( j -> kind == TGJSON_NONE )
+		{
+			//	The first member says what this is
+
+			if ( name == "r" )
+				j -> kind = TGJSON_R;
+			else
+				if ( name == "sr" )
+					j -> kind = TGJSON_SR;
+				else
+					if ( name == "qr" )
+						j -> kind = TGJSON_QR;
+					else
+						j -> kind = TGJSON_OTHER;
+		}
+
+		if ( !member( &c, j, std::string_view(), name, 0 ) ) break;
+	}
+	while ( expect( &c, ',' ) );
+
+	if ( !expect( &c, '}' ) )
+	{
+		j -> kind = TGJSON_NONE;
+		return( false );
+	}
+
+	j -> checksum = j -> nf < 4 || tgjson_checksum( line.data(), c.fcomma ) == (unsigned) j -> f[ 3 ];
+	return( true );
+}
+
+
+const tgjson_pair_t *tgjson_find( const tgjson_t *j, std::string_view name, std::string_view group )
+{
+	for ( int i = 0; i < j -> npairs; i ++ )
+		if ( j -> pair[ i ].name == name && j -> pair[ i ].group == group ) return( &j -> pair[ i ] );
+	return( NULL );
+}
+
+
+bool tgjson_number( const tgjson_t *j, std::string_view name, double *value, std::string_view group )
+{
+	const tgjson_pair_t	*p = tgjson_find( j, name, group );
+
+	if ( p == NULL || !p -> number ) return( false );
+	*value = p -> value;
+	return( true );
+}
+
+
+bool tgjson_ok( const tgjson_t *j )
+{
+	return( j -> kind == TGJSON_R && j -> nf >= 2 && j -> checksum && j -> f[ 1 ] == 0 );
+}
+
+
+//	The firmware's compute_checksum(): a Java style string hash, mod 9999, of the line up to the
+//	footer's last comma.
+
+unsigned tgjson_checksum( const char *p, size_t n )
+{
+	uint32_t	h = 0;
+
+	while ( n -- ) h = 31 * h + (unsigned char) *p ++;
+	return( h % 9999 );
+}
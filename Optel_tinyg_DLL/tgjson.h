@@ -0,0 +1,57 @@
+//	==========================================================================================
+//	TinyG JSON replies.  With JSON reporting on ($ej=1) TinyG answers each command with one line
+//
+//		{"r":{<body>},"f":[<protocol>,<status>,<bytes>,<checksum>]}			the response
+//
+//	and sends {"sr":{...}} status reports and {"qr":...} queue reports as they happen.
+//
+//	tgjson_parse() picks a line apart into name/value pairs without copying or allocating: the
+//	names and values are string_views into the caller's line, numbers are converted with
+//	from_chars().  Members of objects nested in the body keep the object's name as their group,
+//	{"r":{"pos":{"x":1.0}}} gives the pair pos/x.  The footer is checked against its checksum.
+// ---------------------------------------------------------------------
+// Rev    Date      By     Description
+// -----  --------  -----  ---------------------------------------------
+//		  10/16/26	DV	   Original
+//	==========================================================================================
+
+#pragma once
+
+#include <stddef.h>
+#include <string_view>
+
+#define	TGJSON_PAIRS		32													//	most name/value pairs kept from a line
+
+typedef enum
+{
+	TGJSON_NONE,																//	not a JSON object
+	TGJSON_R,																	//	{"r":...} command response
+	TGJSON_SR,																	//	{"sr":...} status report
+	TGJSON_QR,																	//	{"qr":...} queue report
+	TGJSON_OTHER																//	anything else ({"er":...} exception reports...)
+} tgjson_kind_t;
+
+typedef struct
+{
+	std::string_view	group;													//	name of the enclosing object in the body, "" for none
+	std::string_view	name;
+	std::string_view	text;													//	the value as sent, strings without their quotes
+	double				value;													//	numbers, true is 1, false and null are 0
+	bool				number;													//	text is a number
+} tgjson_pair_t;
+
+typedef struct
+{
+	tgjson_kind_t		kind;
+	int					npairs;
+	tgjson_pair_t		pair[ TGJSON_PAIRS ];
+	int					nf;														//	footer values, 0 if there's no footer
+	int					f[ 4 ];													//	protocol, status, bytes received, checksum
+	bool				checksum;												//	the footer checksum is right (or there isn't one)
+} tgjson_t;
+
+bool tgjson_parse( std::string_view line, tgjson_t *j );						//	false if line isn't a JSON object
+const tgjson_pair_t *tgjson_find( const tgjson_t *j, std::string_view name, std::string_view group = std::string_view() );	//	NULL if it's not there
+bool tgjson_number( const tgjson_t *j, std::string_view name, double *value, std::string_view group = std::string_view() );	//	false if not there or not a number
+bool tgjson_ok( const tgjson_t *j );											//	a response with a good footer and status 0
+unsigned tgjson_checksum( const char *p, size_t n );							//	TinyG's footer checksum of n bytes
@@ -0,0 +1,96 @@
+//	==========================================================================================
+//	TinyG status snapshot: where the motors are, as of the last status report, and when that
+//	report arrived.  One writer (the port's receive tap, on the reader thread) and any number
+//	of readers, behind a sequence lock so a read never waits and never sees half an update.
+//
+//	The writer makes the sequence odd, stores, and makes it even again.  A reader copies the
+//	values and retries if the sequence was odd or moved while it copied.  The values are
+//	relaxed atomics so the copy isn't a data race, the fences order them against the sequence.
+// ---------------------------------------------------------------------
+// Rev    Date      By     Description
+// -----  --------  -----  ---------------------------------------------
+//		  10/16/26	DV	   status_now() is tgclock_now(), so report times follow a virtual clock too
+//		  10/16/26	DV	   Original
+//	==========================================================================================
+
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+
+#include "tgaxes.h"
+#include "tgclock.h"
+
+typedef struct
+{
+	double		pos[ TG_AXES ];														//	x, y, z, a (, b, c)
+	double		vel;
+	int			stat;																//	machine state, 3 is stop
+	int64_t		ns;																	//	status_now() when the report arrived
+} tgstatus_t;
+
+typedef struct
+{
+	std::atomic<uint32_t>	seq;													//	odd while being written, 0 until the first write
+	std::atomic<double>		pos[ TG_AXES ];
+	std::atomic<double>		vel;
+	std::atomic<int>		stat;
+	std::atomic<int64_t>	ns;
+} tgsnapshot_t;
+
+
+//	Host time in ns, tgclock_now().
+
+inline int64_t status_now( void )
+{
+	return( tgclock_now() );
+}
+
+
+//	Writer: publish v.
+
+inline void status_publish( tgsnapshot_t *s, const tgstatus_t *v )
+{
+	uint32_t	seq = s -> seq.load( std::memory_order_relaxed );
+
+	s -> seq.store( seq + 1, std::memory_order_relaxed );
+	std::atomic_thread_fence( std::memory_order_release );
+
+	for ( int i = 0; i < TG_AXES; i ++ ) s -> pos[ i ].store( v -> pos[ i ], std::memory_order_relaxed );
+	s -> vel.store( v -> vel, std::memory_order_relaxed );
+	s -> stat.store( v -> stat, std::memory_order_relaxed );
+	s -> ns.store( v -> ns, std::memory_order_relaxed );
+
+	s -> seq.store( seq + 2, std::memory_order_release );
+}
+
+
+//	Writer: forget what's been published, reads fail till the next publish.
+
+inline void status_clear( tgsnapshot_t *s )
+{
+	s -> seq.store( 0, std::memory_order_release );
+}
+
+
+//	Reader: copy the last values published into v.  False if nothing has been.
+
+inline bool status_read( tgsnapshot_t *s, tgstatus_t *v )
+{
+	uint32_t	seq;
+
+	do
+	{
+		while ( ( seq = s -> seq.load( std::memory_order_acquire ) ) & 1 ) ;
+
+		for ( int i = 0; i < TG_AXES; i ++ ) v -> pos[ i ] = s -> pos[ i ].load( std::memory_order_relaxed );
+		v -> vel = s -> vel.load( std::memory_order_relaxed );
+		v -> stat = s -> stat.load( std::memory_order_relaxed );
+		v -> ns = s -> ns.load( std::memory_order_relaxed );
+
+		std::atomic_thread_fence( std::memory_order_acquire );
+	}
+	while ( s -> seq.load( std::memory_order_relaxed ) != seq );
+
+	return( seq != 0 );
+}
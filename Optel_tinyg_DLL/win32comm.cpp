@@ -9,6 +9,44 @@
 // --------------------------------------------------------------------------------------------------------------
 // Rev		Date		By		Description
 // -----	--------	------	---------------------------------------------------------------------------------
+//			10/16/2026	DV		readavail(): what's arrived a block at a time, with the errors of its block.
+//								getbyte() is built on it and readstr() on ring_take().  rxcounts() counts
+//								the reader's reads and their bytes.  A quiet port's read times out every
+//								5 s, not every 100 ms.  setrxgap() is accepted and ignored.
+// -----	--------	------	---------------------------------------------------------------------------------
+//			10/16/2026	DV		cmdio() with delimiters takes what's waiting up to one with ring_take(), which
+//								scans the ring 16 or 32 bytes at a time (commscan.h), instead of a getbyte()
+//								and a strchr() per byte.
+// -----	--------	------	---------------------------------------------------------------------------------
+//			10/16/2026	DV		waitfor() feeds a multi-pattern matcher (commmatch.h) each byte once, no
+//								window is shifted.  The block waitfor()s keep what came before the match,
+//								store only what fits and fail on a nak or a timeout, not on a full buffer.
+// -----	--------	------	---------------------------------------------------------------------------------
+//			10/16/2026	DV		Nothing polls any more: a reader with a full ring waits for getbyte() to make
+//								room instead of checking every ms, outcom() gives up on a dead port instead of
+//								spinning on it, charin() waits out a close on the port list's lock and
+//								sendbreak_timed() sleeps.
+// -----	--------	------	---------------------------------------------------------------------------------
+//			10/16/2026	DV		Waits run to a tgdeadline_t on the monotonic clock (tgclock.h) instead of
+//								abs( clock() - mark ), which is ms at best and CPU time on some platforms.
+// -----	--------	------	---------------------------------------------------------------------------------
+//			10/16/2026	DV		Several ports from several threads: selport is per thread, cmdio() holds the
+//								selected port's lock (critical.h) rather than one for all ports, opening and
+//								closing is serialized, and a closed port's slot is reused.  setrxtap() takes
+//								a context for the tap.
+// -----	--------	------	---------------------------------------------------------------------------------
+//			10/16/2026	DV		commenum() lists the serial ports with SetupDi in one pass.  findserialports() and
+//								getportinfo() use it instead of running mode and powershell into x.txt.
+// -----	--------	------	---------------------------------------------------------------------------------
+//			10/16/2026	DV		setrxtap(): a callback the reader hands each block to before it's queued.
+// -----	--------	------	---------------------------------------------------------------------------------
+//			10/16/2026	DV		Receive data is read by a thread per port, in blocks, into a lock-free ring
+//								(commring.h) that replaces readahead[].  charin() and getbyte() read the ring,
+//								and the receive loops sleep on an event the reader sets instead of spinning on
+//								charin().  The port is opened overlapped so the reader's pending ReadFile()
+//								doesn't hold up writes.  A disconnect fails the reader's ReadFile(), so charin()
+//								no longer polls Get/SetCommState() 5 times a second.
+// -----	--------	------	---------------------------------------------------------------------------------
 //			5/3/2022	SRG		When trying to connect with an Arduino Nano, the command:
 //								powershell -WindowStyle Normal -command get-wmiobject win32_serialport >x.txt
 //								doesn't list COM5 (connected to the NANO) as an option, it only lists COM1.
@@ -241,25 +279,33 @@
 #include <stdio.h>
 #include "time.h"
 #include <conio.h>
+#include <setupapi.h>
+#include <devguid.h>
+#pragma comment( lib, "setupapi.lib" )											//	commenum()
 
 #include "win32comm.h"
 #include "keys.h"
 #include "stristr.h"
 #include "Win32Trace.h"
 #include "critical.h"
+#include "commmatch.h"
+#include "commring.h"
+#include "tgclock.h"
+#include <mutex>
 
 
 
 //	As of 5/25/14 the indexes are now sequentially allocated from
 //	ports, portinit, readahead and outstates.  Port names are built
-//	as needed
+//	as needed.  10/16/2026 readahead is now rxring.
 
-		int					selport = -1;										// which port (index) is active -- default to none (for getport())
+thread_local	int			selport = -1;										// which port (index) this thread has active -- default to none (for getport())
 static	volatile int		openedports = 0;									// # of registered COM ports (the ports may not be open if they have been disconnected)
 static	int					closeportsflag = 0;									// to tell us we're registered closeports
 static	DWORD				error_mask = EV_BREAK | EV_ERR;						// the communication errors we handle
 static	DWORD				rx_error_mask = CE_BREAK | CE_FRAME | CE_OVERRUN | CE_RXOVER | CE_RXPARITY;
 static	volatile bool		closing = false;
+static	std::recursive_mutex	portlist;										// 10/16/2026 openport(), closeport() & closeports() change the tables
 
 
 DCB		defaultsettings =
@@ -319,12 +365,28 @@ char portnames[ NUMCOMPORT ][ 15 ] =											// names of the ports we can simu
 };
 
 volatile HANDLE portinit[ NUMCOMPORT ] = { NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL };	// COM port handles
-int readahead[ NUMCOMPORT ] = { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 };		// read ahead character (to implement charin)
 int portnumbers[ NUMCOMPORT ] = { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 };		// numbers of the opened ports
 DCB portprams[ NUMCOMPORT ];													//	parameters for each port
 bool pstate[ NUMCOMPORT ] = { false, false, false, false, false, false, false, false, false, false };	//	port disconnect states
 bool pinit[ NUMCOMPORT ] = { false, false, false, false, false, false, false, false, false, false };	//	port parameters have been changed
 
+//	10/16/2026 -- each port's reader thread fills its ring, see reader()
+
+#define	RXIDLE					5000											//	ms a reader's ReadFile() waits on a quiet port, it was 100
+
+static commring_t			rxring[ NUMCOMPORT ];								//	received data
+static HANDLE				rxthread[ NUMCOMPORT ];								//	reader threads
+static HANDLE				rxstop[ NUMCOMPORT ];								//	tells the reader to quit
+static HANDLE				rxdata[ NUMCOMPORT ];								//	the reader wakes a waiting consumer
+static HANDLE				txevent[ NUMCOMPORT ];								//	write completion
+static std::atomic<bool>	rxwaiting[ NUMCOMPORT ];							//	the consumer is waiting on rxdata
+static HANDLE				rxroom[ NUMCOMPORT ];								//	the consumer wakes a reader with a full ring
+static std::atomic<bool>	rxfull[ NUMCOMPORT ];								//	the reader is waiting on rxroom
+static std::atomic<bool>	rxdead[ NUMCOMPORT ];								//	the reader's ReadFile() failed, the port is gone
+static std::atomic<rxtap_t>	rxtap[ NUMCOMPORT ];								//	setrxtap() callbacks
+static std::atomic<void *>	rxtapctx[ NUMCOMPORT ];								//	and their contexts
+static std::atomic<unsigned long>	rxreads[ NUMCOMPORT ], rxbytes[ NUMCOMPORT ];	//	ReadFile()s that returned data, and the bytes, for rxcounts()
+
 #ifdef	BLOCKIO
 OVERLAPPED rolap[ NUMCOMPORT ];																			// these are used by charin and getbyte
 
@@ -374,6 +436,229 @@ clock_t			*rxtp[ NUMCOMPORT ] =
 #endif
 
 
+//	10/16/2026 -- wake port i's consumer if it's waiting for data.
+
+static void rxsignal( int i )
+{
+	std::atomic_thread_fence( std::memory_order_seq_cst );						//	ring head before rxwaiting, pairs with rxwait()
+	if ( rxwaiting[ i ].load() ) SetEvent( rxdata[ i ] );
+}
+
+
+//	10/16/2026 -- the consumer took data from port i's ring: wake the reader if it's waiting for room.
+
+static void rxtaken( int i )
+{
+	std::atomic_thread_fence( std::memory_order_seq_cst );						//	ring tail before rxfull, pairs with rxroomwait()
+	if ( rxfull[ i ].load() ) SetEvent( rxroom[ i ] );
+}
+
+
+//	10/16/2026 -- port i's ring is full: the reader waits for the consumer to take some (rxtaken())
+//	rather than polling for it, the rest stays in the driver meanwhile.  False if it was told to quit.
+
+static bool rxroomwait( int i )
+{
+	HANDLE	waits[ 2 ] = { rxroom[ i ], rxstop[ i ] };
+	bool	run = true;
+
+	rxfull[ i ].store( true );
+	std::atomic_thread_fence( std::memory_order_seq_cst );						//	rxfull before the ring tail, pairs with rxtaken()
+
+	if ( ring_space( &rxring[ i ] ) == 0 )
+		run = ( WaitForMultipleObjects( 2, waits, FALSE, INFINITE ) == WAIT_OBJECT_0 );
+
+	rxfull[ i ].store( false );
+	return( run );
+}
+
+
+//	10/16/2026 -- port i's reader thread.  Keeps a ReadFile() pending on the port and puts whatever
+//	it returns into the ring, tagged with the errors ClearCommError() reports for the block.  The
+//	read timeouts set in openport() complete a read as soon as anything has arrived.
+//	Quits when rxstop is set, or when a read fails (the port has been disconnected).
+
+static DWORD WINAPI reader( LPVOID arg )
+{
+	int				i = (int) (INT_PTR) arg;
+	HANDLE			port = portinit[ i ], waits[ 2 ];
+	unsigned char	buf[ 4096 ];
+	OVERLAPPED		olap;
+	DWORD			n, errors, space;
+	COMSTAT			cs;
+	rxtap_t			tap;
+
+	memset( &olap, 0, sizeof( olap ) );
+	if ( ( olap.hEvent = CreateEvent( NULL, TRUE, FALSE, NULL ) ) == NULL )
+	{
+		rxdead[ i ].store( true );
+		rxsignal( i );
+		return( 0 );
+	}
+
+	waits[ 0 ] = olap.hEvent;
+	waits[ 1 ] = rxstop[ i ];
+
+	while ( WaitForSingleObject( rxstop[ i ], 0 ) != WAIT_OBJECT_0 )
+	{
+		if ( ( space = ring_space( &rxring[ i ] ) ) == 0 )
+		{
+			if ( !rxroomwait( i ) ) break;										//	the consumer is behind, leave it in the driver
+			continue;
+		}
+
+		n = 0;
+		if ( !ReadFile( port, buf, ( space < sizeof( buf ) ) ? space : sizeof( buf ), &n, &olap ) )
+		{
+			if ( GetLastError() == ERROR_IO_PENDING )
+			{
+				if ( WaitForMultipleObjects( 2, waits, FALSE, INFINITE ) != WAIT_OBJECT_0 )
+				{
+					CancelIo( port );												//	told to quit
+					GetOverlappedResult( port, &olap, &n, TRUE );
+					break;
+				}
+				if ( GetOverlappedResult( port, &olap, &n, FALSE ) ) goto got;
+			}
+
+			//	fAbortOnError stops reads on a line error until it's cleared, the error is
+			//	passed on with the next byte.  Anything else means the port is gone.
+
+			if ( GetLastError() == ERROR_OPERATION_ABORTED && ClearCommError( port, &errors, &cs ) )
+			{
+				TRACE( (char *) "COMM ERR %0X\n", errors );
+				if ( ( errors &= rx_error_mask ) != 0 ) ring_put( &rxring[ i ], buf, 0, errors );
+				continue;
+			}
+
+			TRACE( (char *) "COM%d read failed %d\n", portnumbers[ i ], GetLastError() );
+			rxdead[ i ].store( true );
+			rxsignal( i );
+			break;
+		}
+got:
+		if ( n )
+		{
+#ifdef	RS232_DIAGS
+			*rxtp[ i ] = clock();
+			( rxtp[ i ] ) ++;
+#endif
+			errors = 0;
+			if ( ClearCommError( port, &errors, &cs ) && errors ) TRACE( (char *) "COMM ERR %0X\n", errors );
+			if ( ( tap = rxtap[ i ].load( std::memory_order_acquire ) ) != NULL ) tap( buf, (int) n, rxtapctx[ i ].load() );
+			ring_put( &rxring[ i ], buf, n, errors & rx_error_mask );
+			rxsignal( i );
+			rxreads[ i ].fetch_add( 1, std::memory_order_relaxed );
+			rxbytes[ i ].fetch_add( n, std::memory_order_relaxed );
+		}
+	}
+
+	CloseHandle( olap.hEvent );
+	return( 0 );
+}
+
+
+//	10/16/2026 -- start port i's reader.  Returns 0 or an error code.
+
+static DWORD startreader( int i )
+{
+	DWORD	err;
+
+	ring_init( &rxring[ i ] );
+	rxwaiting[ i ].store( false );
+	rxfull[ i ].store( false );
+	rxdead[ i ].store( false );
+	rxreads[ i ].store( 0 );
+	rxbytes[ i ].store( 0 );
+
+	rxstop[ i ] = CreateEvent( NULL, TRUE, FALSE, NULL );
+	rxdata[ i ] = CreateEvent( NULL, FALSE, FALSE, NULL );
+	rxroom[ i ] = CreateEvent( NULL, FALSE, FALSE, NULL );
+	txevent[ i ] = CreateEvent( NULL, TRUE, FALSE, NULL );
+
+	if ( rxstop[ i ] != NULL && rxdata[ i ] != NULL && rxroom[ i ] != NULL && txevent[ i ] != NULL
+			&& ( rxthread[ i ] = CreateThread( NULL, 0, reader, (LPVOID) (INT_PTR) i, 0, NULL ) ) != NULL )
+		return( 0 );
+
+	err = GetLastError();
+	if ( rxstop[ i ] != NULL ) CloseHandle( rxstop[ i ] );
+	if ( rxdata[ i ] != NULL ) CloseHandle( rxdata[ i ] );
+	if ( rxroom[ i ] != NULL ) CloseHandle( rxroom[ i ] );
+	if ( txevent[ i ] != NULL ) CloseHandle( txevent[ i ] );
+	rxstop[ i ] = rxdata[ i ] = rxroom[ i ] = txevent[ i ] = NULL;
+	return( err );
+}
+
+
+//	10/16/2026 -- stop port i's reader, before its handle is closed.
+
+static void stopreader( int i )
+{
+	if ( rxthread[ i ] != NULL )
+	{
+		SetEvent( rxstop[ i ] );
+		WaitForSingleObject( rxthread[ i ], INFINITE );
+		CloseHandle( rxthread[ i ] );
+		CloseHandle( rxstop[ i ] );
+		CloseHandle( rxdata[ i ] );
+		CloseHandle( rxroom[ i ] );
+		CloseHandle( txevent[ i ] );
+	}
+	rxthread[ i ] = rxstop[ i ] = rxdata[ i ] = rxroom[ i ] = txevent[ i ] = NULL;
+}
+
+
+//	10/16/2026 -- wait till deadline d for the selected port to have something for charin():
+//	receive data or a disconnect.  Returns > 0 if so, 0 on timeout.
+
+static int rxwait( tgdeadline_t d )
+{
+	DWORD	r;
+
+	if ( selport < 0 || ring_count( &rxring[ selport ] ) || rxdead[ selport ].load() ) return( 1 );
+	if ( tgdeadline_passed( d ) ) return( 0 );
+
+	if ( rxdata[ selport ] == NULL )
+	{
+		//	The port is closed, don't hammer on reopening it.
+
+		Sleep( ( tgdeadline_ms( d ) < 50 ) ? tgdeadline_ms( d ) : 50 );
+		return( 0 );
+	}
+
+	rxwaiting[ selport ].store( true );
+	std::atomic_thread_fence( std::memory_order_seq_cst );						//	rxwaiting before the ring head, pairs with rxsignal()
+
+	if ( ring_count( &rxring[ selport ] ) || rxdead[ selport ].load() )
+		r = WAIT_OBJECT_0;
+	else
+		r = WaitForSingleObject( rxdata[ selport ], (DWORD) tgdeadline_ms( d ) );
+
+	rxwaiting[ selport ].store( false );
+	return( r == WAIT_OBJECT_0 );
+}
+
+
+//	10/16/2026 -- write n bytes to the selected port and wait for the write to finish.
+//	The port is opened overlapped, so every write needs an OVERLAPPED.  Returns the count written.
+
+static DWORD txwrite( const void *p, DWORD n )
+{
+	OVERLAPPED	olap;
+	DWORD		l = 0;
+
+	memset( &olap, 0, sizeof( olap ) );
+	olap.hEvent = txevent[ selport ];
+
+	if ( !WriteFile( portinit[ selport ], p, n, &l, &olap ) )
+	{
+		if ( GetLastError() != ERROR_IO_PENDING || !GetOverlappedResult( portinit[ selport ], &olap, &l, TRUE ) )
+			return( 0 );
+	}
+	return( l );
+}
+
+
 // Close all open com ports.
 
 //	12/08/10 -- This function must be explicitly called if a windows control handler
@@ -385,6 +670,8 @@ clock_t			*rxtp[ NUMCOMPORT ] =
 
 void closeports( void )
 {
+	std::lock_guard<std::recursive_mutex>	l( portlist );
+
 	if ( closing ) return;
 	closing = true;
 
@@ -392,10 +679,9 @@ void closeports( void )
 	{
 		if ( portinit[ i ] != NULL )
 		{
-			// TODO: terminate any io operations
+			stopreader( i );													//	10/16/2026 terminate the reader's io
 			CloseHandle( portinit[ i ] );
 			portinit[ i ] = NULL;												// 7/9/13 signal the port is closed
-			readahead[ i ] = -1;
 			portnumbers[ i ] = -1;
 			pinit[ i ] = false;
 #ifdef BLOCKIO
@@ -406,6 +692,8 @@ void closeports( void )
 			colap[ i ].chunksreturned = 0;
 #endif
 		}
+		rxtap[ i ].store( NULL );												//	10/16/2026
+		rxtapctx[ i ].store( NULL );
 	}
 	openedports = 0;						// 7/21/14 no ports are opened!
 	closing = false;
@@ -414,6 +702,7 @@ void closeports( void )
 
 int closeport( int port )
 {
+	std::lock_guard<std::recursive_mutex>	l( portlist );
 	int		i;
 
 	if ( port < 0 || port > MAXCOMPORTNUMBER ) return( ERROR_BAD_PORT );
@@ -433,21 +722,19 @@ int closeport( int port )
 		{
 			//	Port I is open, close it
 
+			stopreader( i );
 			CloseHandle( portinit[ i ] );
 			portinit[ i ] = NULL;												// 7/9/13 signal the port is closed
-			readahead[ i ] = -1;
-			portnumbers[ i ] = -1;
-			pinit[ i ] = false;
 		}
+		portnumbers[ i ] = -1;													//	10/16/2026 unregistered even if it was dropped
+		pinit[ i ] = false;
+		rxtap[ i ].store( NULL );
+		rxtapctx[ i ].store( NULL );
 
-		//	Now we must update openedports
-
-		openedports = 0;
+		//	Now we must update openedports.  10/16/2026 the ports after this one keep their
+		//	indexes, so it's the last registered one's + 1, not a count.
 
-		for ( i = 0; i < NUMCOMPORT; i ++ )
-		{
-			if ( portinit[ i ] != NULL ) openedports ++;
-		}
+		for ( openedports = NUMCOMPORT; openedports > 0 && portnumbers[ openedports - 1 ] < 1; openedports -- ) ;
 
 		closing = false;
 		return( NOERROR );
@@ -479,6 +766,7 @@ int openport( int port )
 	DWORD			scfg = sizeof( cfg );
 	char			portname[ 15 ];
 	int				i;
+	std::lock_guard<std::recursive_mutex>	l( portlist );					//	10/16/2026
 
 	if ( port >= MAXCOMPORTNUMBER ) return( ERROR_BAD_PORT );
 
@@ -497,8 +785,6 @@ int openport( int port )
 
 	for ( i = 0; i < openedports && portnumbers[ i ] != port + 1; i ++ ) ;		//	8/8/16 compare #s instead of string
 
-	if ( i >= NUMCOMPORT ) return( ERROR_TOO_MANY );
-
 	if ( i < openedports )
 	{
 		//	We found the port in the list.  Is it open, or was it closed due to an error?
@@ -512,12 +798,15 @@ int openport( int port )
 
 		//	The requested port is in the list but was closed
 	}
+	else
+		for ( i = 0; i < openedports && portnumbers[ i ] >= 1; i ++ ) ;			//	10/16/2026 a closed port's slot, else a new one
+
+	if ( i >= NUMCOMPORT ) return( ERROR_TOO_MANY );
 
 	strcpy( portnames[ i ], portname );
 
 	// This port isn't yet open, do it now
 
-	readahead[ i ] = -1;
 //	outstates[ i ] = 0;															//	3/4/19 keep states
 
 #ifdef RS232_DIAGS																// 6/11/13 diags
@@ -529,7 +818,7 @@ int openport( int port )
 #else
 	wchar_t wPortName[20];
 	MultiByteToWideChar(CP_UTF8, 0, portname, -1, wPortName, 20);
-	portinit[i] = CreateFile(wPortName, GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING, 0, NULL);
+	portinit[i] = CreateFile(wPortName, GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING, FILE_FLAG_OVERLAPPED, NULL);	//	10/16/2026 overlapped for the reader thread
 #endif
 	if ( portinit[ i ] == INVALID_HANDLE_VALUE )
 	{
@@ -649,9 +938,13 @@ int openport( int port )
 	}
 
 #ifndef	BLOCKIO
+	//	10/16/2026 -- the reader's ReadFile() returns as soon as there's data, with all the driver
+	//	has, or after RXIDLE ms with none.  The reader waits on its stop event as well, so a quiet
+	//	port needn't time out often; an interval timeout would batch more per read but hold each
+	//	reply back by it.
 	timeouts.ReadIntervalTimeout = MAXDWORD;
-	timeouts.ReadTotalTimeoutConstant = 0;
-	timeouts.ReadTotalTimeoutMultiplier = 0;
+	timeouts.ReadTotalTimeoutConstant = RXIDLE;
+	timeouts.ReadTotalTimeoutMultiplier = MAXDWORD;
 	timeouts.WriteTotalTimeoutConstant = 10;		//	2/6/19 was 0
 	timeouts.WriteTotalTimeoutMultiplier = 10;		//	same here
 #else
@@ -689,7 +982,18 @@ int openport( int port )
 		return( err );
 	}
 */
-	FlushFileBuffers( portinit[ i ] );											//	clear any pending data
+	PurgeComm( portinit[ i ], PURGE_RXCLEAR | PURGE_TXCLEAR );					//	clear any pending data (10/16/2026 FlushFileBuffers only drains the transmitter)
+
+#ifndef	BLOCKIO
+	DWORD	err;
+
+	if ( ( err = startreader( i ) ) != 0 )
+	{
+		CloseHandle( portinit[ i ] );
+		portinit[ i ] = NULL;
+		return( err );
+	}
+#endif
 
 /*
 	//	7/6/21 -- will this fix the Arduino mega2560 r3 garbage character problem?
@@ -753,6 +1057,27 @@ int getport( void )
 }
 
 
+//	10/16/2026 -- tap the selected port's receive data, see win32comm.h
+
+void setrxtap( rxtap_t tap, void *ctx )
+{
+	if ( selport < 0 || selport >= NUMCOMPORT ) return;
+
+	rxtap[ selport ].store( NULL );
+	rxtapctx[ selport ].store( ctx );
+	rxtap[ selport ].store( tap, std::memory_order_release );
+}
+
+
+//	10/16/2026 -- the reader's gap is POSIX only, see win32comm.h.  Each ReadFile() here already
+//	gets what a USB packet brought.
+
+void setrxgap( int bytes )
+{
+	(void) bytes;
+}
+
+
 //	True if selected port remains open
 
 BOOL isconnected( void )
@@ -784,33 +1109,13 @@ BOOL isconnected( int port )
 
 // return # characters pending or -1 if the port has disappeared.
 
-// In the win32 environment, we can't know how many characters are in the
-// buffer, or even if there are any without trying to read them, so we set
-// the timeout value to zero, and try reading.  If the function returns
-// no data, then we assume there's none received.  If we get a character, we
-// save it in readahead[] since the caller is just asking if data is available,
-// not for the value.  Getbyte(), checks readahead for pre-read data before
-// calling the input function.
-
-//	1/29/2017 adapts to PC speed so port disconnect is checked about 1/sec
-
-//	3/26/2020 uses clock to pace port disconnect checking
-
-#pragma warning(disable:4390)													//	disable warning for empty statement
+//	10/16/2026 -- the reader thread has already read what's arrived into the ring, so this is
+//	just a look at the ring.  A disconnect fails the reader's ReadFile(), which replaces the
+//	Get/SetCommState() check we used to make 5 times/sec (1/29/2017, 3/26/2020).
 
 int charin( void )
 {
-	unsigned char		c;														// 3/16/10 -- this must be unsigned else readahead[]=c can evaluate negative
-	unsigned long		read;
-	DWORD				errors;
-	COMSTAT				cs;
-	int					i;
-	DCB					cfg;
-//	static int			dtimer = 0;
-//	static int			dtmax = 100000;											//	dtimer limit (initial value)
-//	static time_t		ltime = clock(), dt, st;								//	time when dtimer hit dtmax
-	static time_t		lastcheck = clock(), st;								//	timer for checking port disconnect & misc
-//	static bool			hitlimit = false;										//	time has hit dtmax
+	uint32_t		n;
 
 	if ( portinit[ selport ] == NULL && openport( portnumbers[ selport ] - 1 ) != 0 )
 		goto no_port;															//	Port isn't opened and trying to do so fails
@@ -828,277 +1133,136 @@ int charin( void )
 	}
 
 	if ( !portinit[ selport ] ) return( 0 );									//	this is a caller error!?!
-	if ( readahead[ selport ] >= 0 ) return( 1 );								// return the character previously read
 
-/*	use the system's time keeping ability, no timing loops!!
-	if ( ++ dtimer > dtmax )
-	{
-		if ( !hitlimit )
-		{
-			hitlimit = true;
-			ltime = clock();
-		}
-		else
-		{
-			//	We've hit the limit before so clock()-ltime is valid.  Adjust dtmax to make
-			//	the value 990 to 1100 ticks.
+	if ( ( n = ring_count( &rxring[ selport ] ) ) != 0 ) return( (int) n );
 
-			dt = clock() - ltime;												//	time since last dtmax
-			ltime = clock();
+	if ( !rxdead[ selport ].load() ) return( 0 );
+	if ( ( n = ring_count( &rxring[ selport ] ) ) != 0 ) return( (int) n );	//	what arrived before it went away
 
-			if ( dt < 990 )
-			{
-//				TRACE( "measured %d, ", dt );
-//				TRACE( "dtmax too short %ld\n", dtmax );
-				dtmax += 1000;
-			}
-			else
-			{
-				if ( dt > 1100 )
-				{
-//					TRACE( "measured %d, ", dt );
-//					TRACE( "dtmax too long %ld\n", dtmax );
-					dtmax -= 1000;
-				}
-				else
-				{
-					//	right on the money, leave dtmax alone
-//					TRACE( "measured %d, ", dt );
-//					TRACE( "Perfect %ld\n", dtmax );
-				}
-			}
-		}
+	//	1/19/17 ReadFile has failed.  Probably because the serial port is disconnected.
+	//	Close the port and signal it's closed.
 
-		dtimer = 0;
-*/
-	if ( clock() - lastcheck > 200 )											//	check 5 times/sec
+no_port:
+	TRACE( (char *) "no port\n" );
+	if ( pstate[ selport ] )
 	{
-		lastcheck = clock();
-		st = clock();
-		if ( !GetCommState( portinit[ selport ], &cfg ) || clock() - st > PDTIMEOUT )
-			goto no_port;
-		st = clock();
-		if ( !SetCommState( portinit[ selport ], &portprams[ selport ] ) || clock() - st > PDTIMEOUT )	//	put them back -- this generates an error if the port has been disconnected
-			goto no_port;
-	}
+		TRACE( (char *) "Port closed @ %d\n", clock() );
+		pstate[ selport ] = false;
 
-	// there is no character in the read ahead buffer, so we'll try
-	// reading one from the port.  If we read one, we'll put it there then
-	// signal the caller data is available.
+		std::lock_guard<std::recursive_mutex>	l( portlist );					//	10/16/2026 was while ( closing ) ; wait out a close, don't spin
 
-	if ( ( i = ReadFile( portinit[ selport ], &c, 1, &read, NULL ) ) != 0 )
-	{
-		if ( read )
+		if ( selport >= 0 && selport < openedports && portinit[ selport ] != NULL )
 		{
-#ifdef	RS232_DIAGS
-			*rxtp[ selport ] = clock();
-			( rxtp[ selport ] ) ++;
-#endif
-			if ( readahead[ selport ] < 0 )
-			{
-				readahead[ selport ] = c;
-//				if ( c > 127 )
-//					TRACE( "[%02X]", c );
-//				else
-//					TRACE( "%c", c );
-			}
-			else
-			{
-				TRACE( (char *) "readahead lost (COM-%d)\n", portnumbers[ selport ] );
-				readahead[ selport ] = c;
-			}
-
-			DWORD	ms;
-
-			if ( GetCommModemStatus( portinit[ selport ], &ms ) )
-				if ( ms )
-					;
-			//TRACE( (char *) "State: %02X\n", ms & 0xFF );
-
-			if ( ClearCommError( portinit[ selport ], &errors, &cs ) )
-			{
-				if ( errors ) TRACE( (char *) "COMM ERR %0X\n", errors );
-				errors &= rx_error_mask;
-				readahead[ selport ] |= errors << 8;
-			}
-			else
-				TRACE( (char *) "Clear comm error failed\n" );
-
-			return( 1 );
+			stopreader( selport );
+			CloseHandle( portinit[ selport ] );
+			portinit[ selport ] = NULL;
 		}
 	}
-	else
-	{
-		//	1/19/17 ReadFile has failed.  Probably because the serial port is disconnected.
-		//	Close the port and signal it's closed.
+	return( -1 );
+}
 
-no_port:
-		TRACE( (char *) "no port\n" );
-		if ( pstate[ selport ] )
-		{
-			if ( ClearCommError( portinit[ selport ], &errors, &cs ) && errors & CE_FRAME )
-			{
-				TRACE( (char *) "frame\n" );
-				readahead[ selport ] = CE_FRAME << 8;
-				return( 0 );
-			}
-			else
-				TRACE( (char *) "Clearcommerror failed\n" );
 
-			TRACE( (char *) "Port closed @ %d\n", clock() );
-			pstate[ selport ] = false;
-			while ( closing ) ;
-			if ( selport >= 0 && selport < openedports && portinit[ selport ] != NULL )
-			{
-				CloseHandle( portinit[ selport ] );
-				portinit[ selport ] = NULL;
-			}
-		}
-		return( -1 );
-	}
-	return( 0 );
-}
+// return # characters pending on port (an index, like selport) or -1 if it has disappeared.
+//	10/16/2026 -- selects the port around charin() so both check the same port.
 
-#pragma warning(default:4390)
+int charin( int port )
+{
+	int		i, oldport = selport;
 
+	if ( port < 0 || port >= openedports ) return( 0 );
 
-// return # characters pending
+	selport = port;
+	i = charin();
+	selport = oldport;
+	return( i );
+}
 
-// In the win32 environment, we can't know how many characters are in the
-// buffer, or even if there are any without trying to read them, so we set
-// the timeout value to zero, and try reading.  If the function returns
-// no data, then we assume there's none received.  If we get a character, we
-// save it in readahead[] since the caller is just asking if data is available,
-// not for the value.  Getbyte(), checks readahead for pre-read data before
-// calling the input function.
 
-//	Use timekeeping facilities to pace port disconnect checking.
+// Get next character.  If called when no character is available, we wait for one (e.g. the function blocks).
+// Communication error information is returned as a super-set of my original PC communication routines.
+//	See: CE_BREAK, CE_FRAME, CE_OVERRUN, CE_RXOVER, CE_RXPARITY.  These bit values are in the *upper-byte*
+//	of the returned value.
 
-int charin( int port )
+unsigned getbyte( void )
 {
-	unsigned char		c;														// 3/16/10 -- this must be unsigned else readahead[]=c can evaluate negative
-	int					i, oldport = selport;									//	save the currently selected port
-	unsigned long		read;
-	DWORD				errors;	//, status;
-	DCB					cfg;
-//	static int			dtimer = 0;
-	static time_t		lastcheck = clock();
+	tgdeadline_t	d;
+	unsigned char	c;
+	unsigned		errors;
+	int				i = 0;
 
-	if ( portinit[ port ] == NULL && portinit[ selport ] && openport( port ) != 0 )	//	the specified port isn't open and we can't open it
-	{
-		if ( pstate[ port ] )
-		{
-			pstate[ port ] = false;
-			TRACE( (char *) "Port closed @ %d\n", clock() );
-		}
-		selport = oldport;														//	select the original port
-		return( 0 );															//	the port wasn't opened, and our attempt to do so failed!
-	}
-	else
-	{
-		if ( !pstate[ port ] )
-		{
-			pstate[ port ] = true;
-			TRACE( (char *) "Reconnect @ %d (%d BAUD)\n", clock(), portprams[ selport ].BaudRate );
-		}
-	}
+	if ( portinit[ selport ] == NULL && openport( portnumbers[ selport ] - 1 ) != 0 ) return( 0xFF00 );		//	if the port hasn't been opened, and our attempt to do so fails
 
 	if ( !portinit[ selport ] ) return( 0 );									//	this is a caller error!?!
 
-	if ( readahead[ selport ] >= 0 )
+	if ( !ring_count( &rxring[ selport ] ) )
 	{
-		selport = oldport;
-		return( 1 );															// return the character previously read
-	}
+		TRACE( (char *) "no char available\n" );
 
-//	if ( ++ dtimer > 0 )
-	if ( clock() - lastcheck > 200 )											//	check for disconnect 5 times/sec
-	{
-		lastcheck = clock();
-//		dtimer = 0;
+		// there is no character in the ring, wait for one
+
+		d = tgdeadline_ticks( CLOCKS_PER_SEC / 2 );
+		while ( ( i = charin() ) == 0 && !tgdeadline_passed( d ) )
+			rxwait( d );
 
-		if ( !GetCommState( portinit[ selport ], &cfg ) )						//	status was not used!
-			goto no_port;
+		//	6/11/13 Correction for calls when no data is yet received returning the wrong value
 
-		if ( !SetCommState( portinit[ selport ], &portprams[ selport ] ) )		//	put them back -- this generates an error if the port has been disconnected
-			goto no_port;
+		if ( i <= 0 ) return( 0xFF00 );											// return port init error
 	}
 
-	// there is no character in the read ahead buffer, so we'll try
-	// reading one from the port.  If we read one, we'll put it there then
-	// signal the caller data is available.
+	if ( readavail( &c, 1, &errors ) <= 0 ) return( 0xFF00 );					//	10/16/2026 a block of one
+	return( c | errors << 8 );
+}
 
-	if ( ( i = ReadFile( portinit[ selport ], &c, 1, &read, NULL ) ) != 0 )
- 	{
-		if ( read )
-		{
-#ifdef	RS232_DIAGS
-			*rxtp[ selport ] = clock();
-			( rxtp[ selport ] ) ++;
-#endif
-			readahead[ port ] = c;
-			if ( ClearCommError( portinit[ port ], &errors, NULL ) && ( errors &= rx_error_mask ) )
-			{
-				readahead[ port ] |= errors << 8;
-			}
-			return( 1 );
-		}
-	}
-	else
-	{
-		//	1/19/17 ReadFile has failed.  Probably because the serial port is disconnected.
-		//	Close the port and signal it's closed.
 
-no_port:
-		pstate[ selport ] = false;
+//	10/16/2026 -- take what's arrived without waiting: up to size bytes into buf, and the receive errors
+//	(CE_ bits) of the block they came in into *errors (if it isn't NULL).  A read stops short of the next
+//	block with errors, so the errors are always those of the bytes read.
+//	Returns the bytes read, 0 if there's nothing or -1 if the port has disappeared.
 
-		if ( portinit[ selport ] != NULL )
-		{
-			CloseHandle( portinit[ selport ] );
-			TRACE( (char *) "Closed COM%d\n", portnumbers[ selport ] );
-			portinit[ selport ] = NULL;
-		}
-		selport = oldport;
-		return( -1 );
+int readavail( unsigned char *buf, int size, unsigned *errors )
+{
+	unsigned	e = 0;
+	int			n;
+
+	if ( ( n = charin() ) > 0 && size > 0 )
+	{
+		n = (int) ring_read( &rxring[ selport ], buf, (uint32_t) size, &e );
+		rxtaken( selport );
 	}
-	return( 0 );
+	else
+		if ( n > 0 ) n = 0;
+
+	if ( errors != NULL ) *errors = e;
+	return( n );
 }
 
 
-// Get next character.  If called when no character is available, we wait for one (e.g. the function blocks).
-// Communication error information is returned as a super-set of my original PC communication routines.
-//	See: CE_BREAK, CE_FRAME, CE_OVERRUN, CE_RXOVER, CE_RXPARITY.  These bit values are in the *upper-byte*
-//	of the returned value.
+//	10/16/2026 -- same as readavail() for port index port, the selected port doesn't change.
 
-unsigned getbyte( void )
+int readavail( int port, unsigned char *buf, int size, unsigned *errors )
 {
-	unsigned		c;
-	clock_t			now;
-
-	if ( portinit[ selport ] == NULL && openport( portnumbers[ selport ] - 1 ) != 0 ) return( 0xFF00 );		//	if the port hasn't been opened, and our attempt to do so fails
+	int		n, oldport = selport;
 
-	if ( !portinit[ selport ] ) return( 0 );									//	this is a caller error!?!
+	if ( errors != NULL ) *errors = 0;
+	if ( port < 0 || port >= openedports ) return( 0 );
 
-	if ( ( c = readahead[ selport ] ) >= 0 )
-	{
-getahead:
-		readahead[ selport ] = -1;
-		return( c );
-	}
-	else
-		TRACE( (char *) "no char available\n" );
+	selport = port;
+	n = readavail( buf, size, errors );
+	selport = oldport;
+	return( n );
+}
 
-	// there is no character in the read ahead buffer, wait for one
 
-	now = clock( );
-	while ( clock() < now + CLOCKS_PER_SEC / 2 && ( c = charin() ) == 0 ) ;		// wait for char or error
+//	10/16/2026 -- the ReadFile()s port index port's reader has made that returned data, and the bytes
+//	they returned, since it was opened.  False if it isn't a port.
 
-	//	6/11/13 Correction for calls when no data is yet received returning the wrong value
-	//	Don't think this is an issue, since I never have written code that does this,
-	//	but who knows...
+BOOL rxcounts( int port, unsigned long *reads, unsigned long *bytes )
+{
+	if ( port < 0 || port >= openedports ) return( FALSE );
 
-	if ( c < 0 ) return( 0xFF00 );			// return port init error
-	goto getahead;							// else return the read ahead character
+	if ( reads != NULL ) *reads = rxreads[ port ].load();
+	if ( bytes != NULL ) *bytes = rxbytes[ port ].load();
+	return( TRUE );
 }
 
 
@@ -1114,7 +1278,17 @@ getahead:
 
 int readstr( long timeout, char *s, int maxlen )
 {
-	clock_t		start;
+	static const scanset_t	cr = []
+	{
+		scanset_t	s;
+
+		scan_set( &s, "\r\x8D", 2 );												//	a CR with or without its parity bit
+		return( s );
+	}();
+	tgdeadline_t	d;
+	uint32_t		n, j, k;
+	unsigned		errors;
+	int				i, c;
 
 	if ( portinit[ selport ] == NULL && openport( portnumbers[ selport ] - 1 ) != 0 )
 	{
@@ -1124,29 +1298,30 @@ int readstr( long timeout, char *s, int maxlen )
 
 	if ( !portinit[ selport ] ) return( 0 );									//	this is a caller error!?!
 
-	start = clock();
+	d = tgdeadline_ticks( timeout );
 	*s = 0;
 
-	while ( maxlen > 0 && abs( clock() - start ) < timeout )
+	while ( maxlen > 1 && !tgdeadline_passed( d ) )
     {
-		if ( charin() )
+		if ( ( i = charin() ) > 0 )
         {
-			*s = (char) ( getbyte() & 0x7F );
-			if ( *s == 0xD )
-            {
-				*s = 0;
-				return( 1 );
-            }
-			
-			if ( *s != 0xA )
-            {
-				if ( -- maxlen ) s ++;
-            }
+			//	10/16/2026 what's come up to the CR at once (ring_take()), then parity bits off and LFs out
 
+			n = ring_take( &rxring[ selport ], (unsigned char *) s, (uint32_t) ( maxlen - 1 ), &cr, &c, &errors );
+			rxtaken( selport );
+
+			for ( j = k = 0; j < n; j ++ )
+				if ( ( s[ k ] = (char) ( s[ j ] & 0x7F ) ) != 0xA ) k ++;
+			s += k;
 			*s = 0;
+			maxlen -= (int) k;
 
-			start = clock();
+			if ( c >= 0 ) return( 1 );
+			d = tgdeadline_ticks( timeout );
         }
+		else
+			if ( i < 0 ) return( 0 );
+			else rxwait( d );											//	10/16/2026 sleep till data instead of spinning
     }
 	return( 0 );
 }
@@ -1158,22 +1333,26 @@ int readstr( long timeout, char *s, int maxlen )
 
 BOOL getnt( long timeout, char *s, int maxlen )
 {
-	clock_t marktm;
+	tgdeadline_t d;
+	int		i;
 	
 	if ( portinit[ selport ] == NULL && openport( portnumbers[ selport ] - 1 ) != 0 ) return( 0 );
 
 	if ( !portinit[ selport ] ) return( 0 );									//	this is a caller error!?!
 
-	marktm = clock();
+	d = tgdeadline_ticks( timeout );
 	
-	while ( maxlen && abs( clock() - marktm ) < timeout )
+	while ( maxlen && !tgdeadline_passed( d ) )
     {
-		if ( charin() )
+		if ( ( i = charin() ) > 0 )
         {
 			*s++ = (char) ( getbyte() & 0x7F );
-			marktm = clock();
+			d = tgdeadline_ticks( timeout );
 			maxlen --;
         }
+		else
+			if ( i < 0 ) break;
+			else rxwait( d );
     }
 	*s = 0;
 	return( maxlen == 0 );
@@ -1186,22 +1365,26 @@ BOOL getnt( long timeout, char *s, int maxlen )
 
 BOOL getntx( long timeout, unsigned char *s, int maxlen )
 {
-	clock_t marktm;
+	tgdeadline_t d;
+	int		i;
 	
 	if ( portinit[ selport ] == NULL && openport( portnumbers[ selport ] - 1 ) != 0 ) return( 0 );
 
 	if ( !portinit[ selport ] ) return( 0 );									//	this is a caller error!?!
 
-	marktm = clock();
+	d = tgdeadline_ticks( timeout );
 	
-	while ( maxlen && abs( clock() - marktm ) < timeout )
+	while ( maxlen && !tgdeadline_passed( d ) )
     {
-		if ( charin() )
+		if ( ( i = charin() ) > 0 )
         {
 			*s++ = (unsigned char) ( getbyte() & 0xFF );
-			marktm = clock();
+			d = tgdeadline_ticks( timeout );
 			maxlen --;
         }
+		else
+			if ( i < 0 ) break;
+			else rxwait( d );
     }
 	*s = 0;
 	return( maxlen == 0 );
@@ -1220,7 +1403,7 @@ char	lastcommand[ 1000 ] = "";
 
 BOOL cmdio( char *cmd, long timeout, char *recvbuf, int maxlen )
 {
-	clock_t			marktm;
+	tgdeadline_t		d;
 	unsigned char	c;
 	int				i;
 
@@ -1263,13 +1446,12 @@ BOOL cmdio( char *cmd, long timeout, char *recvbuf, int maxlen )
 				TRACE( (char *) "[%02X]", cmd[ i ] );
 #endif
 
-	marktm = clock();
+	d = tgdeadline_ticks( timeout );
 	c = 0;
-	clock_t	t;
 
 	*recvbuf = 0;
 	
-	while ( maxlen > 1 && ( t = abs( clock() - marktm ) ) < timeout )
+	while ( maxlen > 1 && !tgdeadline_passed( d ) )
     {
 		if ( ( i = charin( ) ) > 0 )
 		{
@@ -1298,7 +1480,7 @@ BOOL cmdio( char *cmd, long timeout, char *recvbuf, int maxlen )
 				*recvbuf = 0;
 				maxlen --;
 			}
-			marktm = clock( );
+			d = tgdeadline_ticks( timeout );
 		}
 		else
 		{
@@ -1307,6 +1489,7 @@ BOOL cmdio( char *cmd, long timeout, char *recvbuf, int maxlen )
 				TRACE( (char *) "Port disconnect\n" );
 				return( FALSE );
 			}
+			rxwait( d );													//	10/16/2026 sleep till data instead of spinning
 		}
     }
 	if ( maxlen )
@@ -1322,7 +1505,7 @@ BOOL cmdio( char *cmd, long timeout, char *recvbuf, int maxlen )
 
 BOOL cmdio( char *cmd, long timeout, char *recvbuf, int maxlen, void (*callback)( void ) )
 {
-	clock_t			marktm;
+	tgdeadline_t		d;
 	unsigned char	c;
 	int				i;
 
@@ -1332,12 +1515,12 @@ BOOL cmdio( char *cmd, long timeout, char *recvbuf, int maxlen, void (*callback)
 
 	outcoms( cmd );			// send the command
 
-	marktm = clock();
+	d = tgdeadline_ticks( timeout );
 	c = 0;
 
 	*recvbuf = 0;
 	
-	while ( maxlen > 1 && abs( clock() - marktm ) < timeout )
+	while ( maxlen > 1 && !tgdeadline_passed( d ) )
     {
 		if ( ( i = charin() ) > 0 )
         {
@@ -1353,7 +1536,7 @@ BOOL cmdio( char *cmd, long timeout, char *recvbuf, int maxlen, void (*callback)
 				*recvbuf = 0;
 				maxlen --;
 			}
-			marktm = clock();
+			d = tgdeadline_ticks( timeout );
         }
 		else
 		{
@@ -1362,7 +1545,13 @@ BOOL cmdio( char *cmd, long timeout, char *recvbuf, int maxlen, void (*callback)
 				TRACE( ( char * ) "Port disconnect\n" );
 				return( FALSE );
 			}
-			if ( callback != NULL ) callback( );
+			if ( callback != NULL )
+			{
+				callback( );
+				rxwait( tgdeadline_min( d, tgdeadline_ticks( CLOCKS_PER_SEC / 100 ) ) );				//	keep calling back
+			}
+			else
+				rxwait( d );
 		}
     }
 	TRACE( (char *) "cmdio timeout to %s\n", cmd );
@@ -1371,23 +1560,55 @@ BOOL cmdio( char *cmd, long timeout, char *recvbuf, int maxlen, void (*callback)
 }
 
 
+//	10/16/2026 -- take what the selected port's ring has up to a byte in s into *recvbuf, at most
+//	*maxlen - 1 bytes, the way cmdio() took it a getbyte() at a time.  Returns the delimiter,
+//	which isn't stored, or -1 if it hasn't come yet.
+
+static int takeupto( char **recvbuf, int *maxlen, const scanset_t *s )
+{
+	uint32_t	n;
+	unsigned	errors;
+	int			c;
+
+	n = ring_take( &rxring[ selport ], (unsigned char *) *recvbuf, (uint32_t) ( *maxlen - 1 ), s, &c, &errors );
+	rxtaken( selport );
+
+#ifdef COMDEBUG
+	for ( uint32_t k = 0; k < n; k ++ )
+		if ( (*recvbuf)[ k ] >= ' ' && (*recvbuf)[ k ] <= '~' )
+			TRACE( (char *) "%c", (*recvbuf)[ k ] );
+		else
+			TRACE( (char *) "[%02X]", (unsigned char) (*recvbuf)[ k ] );
+	if ( c >= 0 ) TRACE( (char *) " %02X\n", c );
+#endif
+
+	*recvbuf += n;
+	**recvbuf = 0;
+	*maxlen -= (int) n;
+	return( c );
+}
+
+
 //	Same as cmdio with a list of input string delimiters
 //	2/1/17 corrected
 
 BOOL cmdio( char *cmd, long timeout, char *recvbuf, int maxlen, char *delims )
 {
-	EnterCriticalSection(&cmdio_critical_section);
-	clock_t			marktm;
+	if ( selport < 0 || selport >= NUMCOMPORT ) return( FALSE );				//	10/16/2026 the selected port's lock
+	CRITICAL_SECTION *cs = &cmdio_critical_section[ selport ];
+	EnterCriticalSection( cs );
+	tgdeadline_t		d;
 	unsigned char	c;	//, retry = 2;
 	int				i;
+	scanset_t		s;
 
 	if (portinit[selport] == NULL && portinit[selport] && openport(portnumbers[selport] - 1) != 0) { 
-		LeaveCriticalSection(&cmdio_critical_section);
+		LeaveCriticalSection( cs );
 		return(FALSE);
 	}
 
 	if (!portinit[selport]) { 
-		LeaveCriticalSection(&cmdio_critical_section);
+		LeaveCriticalSection( cs );
 		return(0);
 	}									//	this is a caller error!?!
 
@@ -1427,53 +1648,35 @@ BOOL cmdio( char *cmd, long timeout, char *recvbuf, int maxlen, char *delims )
 #endif
 
 
-	marktm = clock();
+	d = tgdeadline_ticks( timeout );
 	c = 0;
+	scan_set( &s, delims, (int) strlen( delims ) + 1 );						//	10/16/2026 with its NUL, strchr() found that too
 
 	*recvbuf = 0;
 	
-	while ( maxlen > 1 && abs( clock() - marktm ) < timeout )
+	while ( maxlen > 1 && !tgdeadline_passed( d ) )
     {
 		if ( ( i = charin( ) ) > 0 )
 		{
-			c = (unsigned char) ( getbyte( ) & 0xFF );
-
-#ifdef COMDEBUG
-			if ( c >= ' ' && c <= '~' )
-				TRACE( (char *) "%c", c );
-			else
-				if ( c == '\n' )
-					TRACE( (char *) "\n" );
-				else
-					TRACE( (char *) "[%02X]", c );
-#endif
-			if ( strchr( delims, c ) != NULL )
+			if ( takeupto( &recvbuf, &maxlen, &s ) >= 0 )						//	10/16/2026 all that's come, up to the delimiter
 			{
-				*recvbuf = 0;
-#ifdef COMDEBUG
-				TRACE( (char *) " %02X\n", c );
-#endif
-				LeaveCriticalSection(&cmdio_critical_section);
+				LeaveCriticalSection( cs );
 				return( TRUE );
 			}
-			else
-			{
-				*recvbuf ++ = c;
-				*recvbuf = 0;
-				maxlen --;
-			}
-			marktm = clock( );
+			d = tgdeadline_ticks( timeout );
 		}
 		else
 			if ( i < 0 )
 			{
 				TRACE( ( char * ) "Port disconnect\n" );
-				LeaveCriticalSection(&cmdio_critical_section);
+				LeaveCriticalSection( cs );
 				return( FALSE );
 			}
+			else
+				rxwait( d );
     }
 	TRACE( (char *) "cmdio timeout to %s\n", cmd );
-	LeaveCriticalSection(&cmdio_critical_section);
+	LeaveCriticalSection( cs );
 	return( FALSE );
 }
 
@@ -1483,20 +1686,23 @@ BOOL cmdio( char *cmd, long timeout, char *recvbuf, int maxlen, char *delims )
 
 bool cmdio( char *cmd, long timeout, char *recvbuf, int maxlen, char *delims, bool clearbuf )
 {
-	EnterCriticalSection(&cmdio_critical_section);
-	clock_t			marktm;
+	if ( selport < 0 || selport >= NUMCOMPORT ) return( FALSE );				//	10/16/2026 the selected port's lock
+	CRITICAL_SECTION *cs = &cmdio_critical_section[ selport ];
+	EnterCriticalSection( cs );
+	tgdeadline_t		d;
 	unsigned char	c;	//, retry = 2;
 	int				i;
+	scanset_t		s;
 
 	if (portinit[selport] == NULL && portinit[selport] && openport(portnumbers[selport] - 1) != 0)
 	{
-		LeaveCriticalSection(&cmdio_critical_section);
+		LeaveCriticalSection( cs );
 		return(FALSE);
 	}
 
 	if ( !portinit[ selport ] )									//	this is a caller error!?!
 	{
-		LeaveCriticalSection(&cmdio_critical_section);
+		LeaveCriticalSection( cs );
 		return(0);
 	}
 
@@ -1536,61 +1742,42 @@ bool cmdio( char *cmd, long timeout, char *recvbuf, int maxlen, char *delims, bo
 #endif
 
 
-	marktm = clock( );
+	d = tgdeadline_ticks( timeout );
 	c = 0;
+	scan_set( &s, delims, (int) strlen( delims ) + 1 );						//	10/16/2026 with its NUL, strchr() found that too
 
 	*recvbuf = 0;
 
-	while ( maxlen > 1 && abs( clock( ) - marktm ) < timeout )
+	while ( maxlen > 1 && !tgdeadline_passed( d ) )
 	{
 		if ( ( i = charin( ) ) > 0 )
 		{
-			c = (unsigned char) ( getbyte( ) & 0xFF );
-
-#ifdef COMDEBUG
-			if ( c >= ' ' && c <= '~' )
-				TRACE( (char *) "%c", c );
-			else
-				if ( c == '\n' )
-					TRACE( (char *) "\n" );
-				else
-					TRACE( (char *) "[%02X]", c );
-#endif
-			if ( strchr( delims, c ) != NULL )
+			if ( takeupto( &recvbuf, &maxlen, &s ) >= 0 )						//	10/16/2026 all that's come, up to the delimiter
 			{
-				*recvbuf = 0;
-#ifdef COMDEBUG
-//				TRACE( (char *) " %02X\n", c );
-#endif
-				LeaveCriticalSection(&cmdio_critical_section);
-
+				LeaveCriticalSection( cs );
 				return( TRUE );
 			}
-			else
-			{
-				*recvbuf ++ = c;
-				*recvbuf = 0;
-				maxlen --;
-			}
-			marktm = clock( );
+			d = tgdeadline_ticks( timeout );
 		}
 		else
 			if ( i < 0 )
 			{
 				TRACE( (char *) "Port disconnect\n" );
-				LeaveCriticalSection(&cmdio_critical_section);
+				LeaveCriticalSection( cs );
 				return( FALSE );
 			}
+			else
+				rxwait( d );
 	}
 	TRACE( (char *) "cmdio timeout to %s\n", cmd );
-	LeaveCriticalSection(&cmdio_critical_section);
+	LeaveCriticalSection( cs );
 	return( FALSE );
 }
 
 
 BOOL cmdio( char *cmd, long timeout, char *recvbuf, int maxlen, int pacing )
 {
-	clock_t			marktm;
+	tgdeadline_t		d;
 	unsigned char	c;
 	int				i;
 
@@ -1621,12 +1808,12 @@ BOOL cmdio( char *cmd, long timeout, char *recvbuf, int maxlen, int pacing )
 		Sleep( pacing );
 	}
 
-	marktm = clock();
+	d = tgdeadline_ticks( timeout );
 	c = 0;
 
 	*recvbuf = 0;
 	
-	while ( maxlen > 1 && abs( clock() - marktm ) < timeout )
+	while ( maxlen > 1 && !tgdeadline_passed( d ) )
     {
 		if ( ( i = charin( ) ) > 0 )
 		{
@@ -1644,7 +1831,7 @@ BOOL cmdio( char *cmd, long timeout, char *recvbuf, int maxlen, int pacing )
 				*recvbuf = 0;
 				maxlen --;
 			}
-			marktm = clock( );
+			d = tgdeadline_ticks( timeout );
 		}
 		else
 			if ( i < 0 )
@@ -1652,6 +1839,8 @@ BOOL cmdio( char *cmd, long timeout, char *recvbuf, int maxlen, int pacing )
 				TRACE( ( char * ) "Port disconnect\n" );
 				return( FALSE );
 			}
+			else
+				rxwait( d );
     }
 	TRACE( (char *) "cmdio timeout to %s\n", cmd );
 
@@ -1662,7 +1851,7 @@ BOOL cmdio( char *cmd, long timeout, char *recvbuf, int maxlen, int pacing )
 
 BOOL cmdio( char *cmd, long timeout, char *recvbuf, int maxlen, bool echo )
 {
-	clock_t			marktm;
+	tgdeadline_t		d;
 	unsigned char	c;
 	int				i;
 
@@ -1702,13 +1891,12 @@ BOOL cmdio( char *cmd, long timeout, char *recvbuf, int maxlen, bool echo )
 			TRACE( (char *) "[%02X]", cmd[ i ] );
 #endif
 
-	marktm = clock( );
+	d = tgdeadline_ticks( timeout );
 	c = 0;
-	clock_t	t;
 
 	*recvbuf = 0;
 
-	while ( maxlen > 1 && ( t = abs( clock( ) - marktm ) ) < timeout )
+	while ( maxlen > 1 && !tgdeadline_passed( d ) )
 	{
 		if ( ( i = charin( ) ) > 0 )
 		{
@@ -1732,7 +1920,7 @@ BOOL cmdio( char *cmd, long timeout, char *recvbuf, int maxlen, bool echo )
 				maxlen --;
 				if ( echo ) printf( "%c", c );
 			}
-			marktm = clock( );
+			d = tgdeadline_ticks( timeout );
 		}
 		else
 		{
@@ -1741,6 +1929,7 @@ BOOL cmdio( char *cmd, long timeout, char *recvbuf, int maxlen, bool echo )
 				TRACE( (char *) "Port disconnect\n" );
 				return( FALSE );
 			}
+			rxwait( d );
 		}
 	}
 	if ( maxlen )
@@ -1755,9 +1944,9 @@ BOOL cmdio( char *cmd, long timeout, char *recvbuf, int maxlen, bool echo )
 
 BOOL cmdiof( char *cmd, long timeout, char *recvbuf, int maxlen )
 {
-	clock_t			marktm;
+	tgdeadline_t		d;
 	unsigned char	c;
-	int				i;
+	int				i, j;
 
 	if ( portinit[ selport ] == NULL && openport( portnumbers[ selport ] - 1 ) != 0 ) return( FALSE );
 
@@ -1774,32 +1963,34 @@ BOOL cmdiof( char *cmd, long timeout, char *recvbuf, int maxlen )
 	for ( i = 0; i < (int) strlen( cmd ); i ++ )
 	{
 		outcom( cmd[ i ] );
-		marktm = clock();
+		d = tgdeadline_ticks( CLOCKS_PER_SEC / 2 );
 		c = cmd[ i ] + 1;
-		while ( clock() < marktm + 500 )
+		while ( !tgdeadline_passed( d ) )
 		{
-			if ( ( i = charin( ) ) > 0 )
+			if ( ( j = charin( ) ) > 0 )										//	10/16/2026 was i, the index into cmd
 			{
 				c = (byte) ( getbyte( ) & 0xFF );
 				if ( c == cmd[ i ] ) break;
 			}
 			else
-				if ( i < 0 )
+				if ( j < 0 )
 				{
 					TRACE( ( char * ) "Port disconnect\n" );
 					return( FALSE );
 				}
+				else
+					rxwait( d );
 		}
 		if ( c != cmd[ i ] )
 			return( FALSE );
 	}
 
-	marktm = clock();
+	d = tgdeadline_ticks( timeout );
 	c = 0;
 
 	*recvbuf = 0;
 
-	while ( maxlen > 1 && abs( clock() - marktm ) < timeout )
+	while ( maxlen > 1 && !tgdeadline_passed( d ) )
     {
 		if ( ( i = charin( ) ) > 0 )
 		{
@@ -1816,7 +2007,7 @@ BOOL cmdiof( char *cmd, long timeout, char *recvbuf, int maxlen )
 				*recvbuf = 0;
 				maxlen --;
 			}
-			marktm = clock( );
+			d = tgdeadline_ticks( timeout );
 		}
 		else
 			if ( i < 0 )
@@ -1824,6 +2015,8 @@ BOOL cmdiof( char *cmd, long timeout, char *recvbuf, int maxlen )
 				TRACE( ( char * ) "Port disconnect\n" );
 				return( FALSE );
 			}
+			else
+				rxwait( d );
     }
 	TRACE( (char *) "cmdiof timeout\n" );
 	return( FALSE );
@@ -1837,8 +2030,9 @@ BOOL cmdiof( char *cmd, long timeout, char *recvbuf, int maxlen )
 
 bool getline( char *cmd, time_t timeout, char *buf, int maxlen )
 {
-	clock_t			marktm;
+	tgdeadline_t		d;
 	char			c;
+	int				i;
 
 	if ( !maxlen ) return( false );
 
@@ -1848,13 +2042,13 @@ bool getline( char *cmd, time_t timeout, char *buf, int maxlen )
 
 	if ( cmd != NULL && *cmd ) outcoms( cmd );									// send the optional command
 
-	marktm = clock();															//	mark start time
+	d = tgdeadline_ticks( (long) timeout );										//	mark start time
 	c = 0;
 	*buf = 0;																	//	delimit the output line
 
-	while ( maxlen > 1 && abs( clock() - marktm ) < timeout )
+	while ( maxlen > 1 && !tgdeadline_passed( d ) )
 	{
-		if ( charin() )
+		if ( ( i = charin() ) > 0 )
 		{
 			c = (char) ( getbyte() & 0xFF );									//	get the received character
 
@@ -1871,8 +2065,11 @@ bool getline( char *cmd, time_t timeout, char *buf, int maxlen )
 				*buf = 0;
 				maxlen --;
 			}
-			marktm = clock();
+			d = tgdeadline_ticks( (long) timeout );
 		}
+		else
+			if ( i < 0 ) return( false );
+			else rxwait( d );
 	}
 	return( false );
 }
@@ -1882,58 +2079,53 @@ bool getline( char *cmd, time_t timeout, char *buf, int maxlen )
 
 // wait for a character string or timeout.
 
-// Although the method may seem awkward, its one of very few ways
-// to insure a string like : xxyz is detected in an input string like xxxyz.
-// (A normal character compare would compare the first two x's, then compare
-// the third input x to y, detect a mismatch and start over, entire missing
-// the input substring xxyz).
+// 10/16/2026 -- the input goes through a matcher (commmatch.h) that looks at each character
+// once.  It finds a string like xxyz in an input like xxxyz, which the sliding window
+// compare it replaces was there for.
 
 // Returns true if time out/error
 
 BOOL waitfor( long timeout, char *str )
 {
-	char	*bufr;
-	size_t	len;
-	clock_t	mt;
+	commmatch_t		m;
+	tgdeadline_t	d;
+	int				i, state = 0;
 	
 	if ( portinit[ selport ] == NULL && portinit[ selport ] 
 		&& openport( portnumbers[ selport ] - 1 ) != 0 ) return( 1 );
 	
 	if ( !portinit[ selport ] ) return( 0 );									//	this is a caller error!?!
+	if ( !*str ) return( 0 );
 
-	len = strlen( str );														// get input data length
-	if ( ( bufr = (char *) malloc( len ) ) == NULL ) return( 1 );
-	memset( bufr, 0, len );
-	mt = clock();
+	match_init( &m );
+	if ( match_add( &m, str, (int) strlen( str ) ) < 0 ) return( 1 );		//	too long
+	match_build( &m );
+	d = tgdeadline_ticks( timeout );
 
-	while ( abs( clock() - mt ) < timeout )
+	while ( !tgdeadline_passed( d ) )
     {
-		if ( charin() )
+		if ( ( i = charin() ) > 0 )
         {
-			memmove( bufr, &bufr[ 1 ], len - 1 );								// ripple received data through
-			bufr[ len - 1 ] = (char) ( getbyte() & 0xFF );						// recv char goes in last array pos
-			if ( !memcmp( bufr, str, len ) )									// compare last 'len' received chars
-            {
-				free( bufr );													// if match
-				return( 0 );
-            }
-			mt = clock();
+			if ( match_step( &m, &state, (unsigned char) ( getbyte() & 0xFF ) ) ) return( 0 );
+			d = tgdeadline_ticks( timeout );
         }
+		else
+			if ( i < 0 ) break;
+			else rxwait( d );
     }
-	free( bufr );
 	return( 1 );
 }
 
 
-// 2/1/17 -- wait for a block of len or timeout.
-
-//	Returns true if time out/error
-//	Inputs data into caller's buffer
+//	10/16/2026 -- receive into bufr (what fits of it) till ack, or nak if it isn't NULL, turns
+//	up or timeout.  The match is cut off the end of bufr.  Returns false on the ack.
 
-BOOL waitfor( char *bufr, int bufsiz, long timeout, char *block, int len )
+static BOOL waitmatch( char *bufr, int bufsiz, long timeout, const char *ack, int acklen, const char *nak, int naklen )
 {
-	char	*iptr = bufr, *optr = bufr;
-	clock_t	mt;
+	commmatch_t		m;
+	tgdeadline_t	d;
+	uint32_t		hits;
+	int				i, n = 0, state = 0, a;
 	
 	if ( portinit[ selport ] == NULL && portinit[ selport ]
 		&& openport( portnumbers[ selport ] - 1 ) != 0 ) return( TRUE );
@@ -1941,91 +2133,54 @@ BOOL waitfor( char *bufr, int bufsiz, long timeout, char *block, int len )
 	if ( !portinit[ selport ] ) return( 0 );									//	this is a caller error!?!
 
 	memset( bufr, 0, bufsiz );													//	null out the receive buffer
-	mt = clock();																//	mark start time
 
-	while ( abs( clock() - mt ) < timeout )
+	match_init( &m );
+	if ( ( a = match_add( &m, ack, acklen ) ) < 0 || ( nak != NULL && match_add( &m, nak, naklen ) < 0 ) ) return( TRUE );
+	match_build( &m );
+	d = tgdeadline_ticks( timeout );											//	mark start time
+
+	while ( !tgdeadline_passed( d ) )
     {
-		if ( charin() )
+		if ( ( i = charin() ) > 0 )
         {
-			*iptr ++ = getbyte() & 0xFF;
-			if ( (unsigned long long) ( iptr - optr ) >= (unsigned long long) bufsiz - (unsigned long long) len - 2 )
-			{
-				printf( "waitfor: buffer overflow!\n" );
-				return( FALSE );
-			}
+			i = getbyte() & 0xFF;
+			if ( n < bufsiz - 1 ) bufr[ n ++ ] = (char) i;						//	past that it's only matched
 
-			if ( iptr - optr >= len && !memcmp( block, optr, len ) )
+			if ( ( hits = match_step( &m, &state, (unsigned char) i ) ) != 0 )
 			{
-				//	match
-
-				*optr = 0;														//	remove the match
-				return( FALSE );
+				i = ( hits & ( 1u << a ) ) ? acklen : naklen;
+				if ( n >= i ) bufr[ n - i ] = 0;								//	remove the match
+				return( ( hits & ( 1u << a ) ) ? FALSE : TRUE );
 			}
-			mt = clock();														//	reset mark time
+			d = tgdeadline_ticks( timeout );									//	reset mark time
 		}
+		else
+			if ( i < 0 ) break;
+			else rxwait( d );
     }
 	return( TRUE );																//	never got the string
 }
 
 
 // 2/1/17 -- wait for a block of len or timeout.
-//	This one accepts both the ACKnowledge and NAK strings to reduce the wait time.
+
 //	Returns true if time out/error
 //	Inputs data into caller's buffer
 
-BOOL waitfor( char *bufr, int bufsiz, long timeout, char *ack, int acklen, char *nak, int naklen )
+BOOL waitfor( char *bufr, int bufsiz, long timeout, char *block, int len )
 {
-	char	*iptr = bufr, *optr = bufr;
-	clock_t	mt;
-	
-	if ( portinit[ selport ] == NULL && portinit[ selport ] 
-		&& openport( portnumbers[ selport ] - 1 ) != 0 ) return( TRUE );
-	
-	if ( !portinit[ selport ] ) return( 0 );									//	this is a caller error!?!
-
-	memset( bufr, 0, bufsiz );													//	null out the receive buffer
-	mt = clock();																//	mark start time
-
-	while ( abs( clock() - mt ) < timeout )
-    {
-		if ( charin() > 0 )
-        {
-			*iptr ++ = getbyte() & 0xFF;
-
-			if ( (unsigned long long) ( iptr - optr ) >= (unsigned long long) bufsiz - max( acklen, naklen ) - 2 )
-			{
-				printf( "waitfor: buffer overflow!\n" );
-				return( FALSE );
-			}
-
-			if ( iptr - optr >= acklen )
-			{
-				//	match
-
-				if ( !memcmp( ack, optr, acklen ) )
-				{
-					*optr = 0;													//	remove the match
-					return( FALSE );
-				}
-			}
+	return( waitmatch( bufr, bufsiz, timeout, block, len, NULL, 0 ) );
+}
 
-			if ( iptr - optr >= naklen )
-			{
-				//	match
 
-				if ( !memcmp( nak, optr, naklen ) )
-				{
-					*optr = 0;													//	remove the match
-					return( TRUE );												//	failed
-				}
-				else
-					optr ++;
-			}
+// 2/1/17 -- wait for a block of len or timeout.
+//	This one accepts both the ACKnowledge and NAK strings to reduce the wait time.
+//	Returns true if time out/error
+//	Inputs data into caller's buffer
 
-			mt = clock();														//	reset mark time
-		}
-    }
-	return( TRUE );																//	never got the string
+BOOL waitfor( char *bufr, int bufsiz, long timeout, char *ack, int acklen, char *nak, int naklen )
+{
+	return( waitmatch( bufr, bufsiz, timeout, ack, acklen, nak, naklen ) );
 }
 
 
@@ -2035,14 +2190,17 @@ BOOL waitfor( char *bufr, int bufsiz, long timeout, char *ack, int acklen, char
 
 void outcom( char c )
 {
-	unsigned long	l = 0;
-	
+	tgdeadline_t	d;
+
 	if ( portinit[ selport ] == NULL && portinit[ selport ] && openport( portnumbers[ selport ] - 1 ) != 0 ) return;
 
 	if ( !portinit[ selport ] ) return;
 
 	//	3/25/2020
-	while ( !WriteFile( portinit[ selport ], &c, 1, &l, NULL ) || !l ) ;
+	//	10/16/2026 retry for up to a second, a port that's gone used to spin here for good
+	d = tgdeadline_ticks( CLOCKS_PER_SEC );
+	while ( txwrite( &c, 1 ) != 1 && !tgdeadline_passed( d ) )
+		Sleep( 1 );
 }
 
 
@@ -2051,27 +2209,25 @@ void outcom( char c )
 void outcome( char c )
 {
 	int				q;
-	unsigned long	l;
-	clock_t			t;
+	tgdeadline_t	d;
 
 	if ( portinit[ selport ] == NULL && portinit[ selport ] && openport( portnumbers[ selport ] - 1 ) != 0 ) return;
 
 	if ( !portinit[ selport ] ) return;
 
-	do
-	{
-		l = 0;
-	}
-	while ( ( q = WriteFile( portinit[ selport ], &c, 1, &l, 0 ) ) != 0 && l < 1 );
+	if ( txwrite( &c, 1 ) != 1 ) return;
 
-	t = clock();
-	while ( t < clock() + 100 )
+	d = tgdeadline_ticks( CLOCKS_PER_SEC / 10 );
+	while ( !tgdeadline_passed( d ) )											//	10/16/2026 was t < clock() + 100, which never times out
 	{
-		if ( charin() )
+		if ( ( q = charin() ) > 0 )
 		{
-			q = getbyte();
-			if ( q == c ) break;
+			q = getbyte() & 0xFF;
+			if ( q == (unsigned char) c ) break;
 		}
+		else
+			if ( q < 0 ) break;
+			else rxwait( d );
 	}
 }
 
@@ -2079,14 +2235,14 @@ void outcome( char c )
 
 void outcoms( char *str )
 {
-	unsigned long	l;
+	DWORD			l;
 	char			*p = str;
 
 	
 	if ( portinit[ selport ] == NULL && portinit[ selport ] && openport( portnumbers[ selport ] - 1 ) != 0 ) return;
 	if ( !portinit[ selport ] ) return;
 
-	while ( WriteFile( portinit[ selport ], p, (DWORD) strlen( p ), &l, 0 ) != 0 && l < strlen( p ) )
+	while ( *p && ( l = txwrite( p, (DWORD) strlen( p ) ) ) != 0 )
 		p += l;
 }
 
@@ -2096,8 +2252,8 @@ void outcoms( char *str )
 void outcomsf( char *str )
 {
 	char			*p = str;
-	char			c;
-	time_t			t;
+	int				c;
+	tgdeadline_t	d;
 
 	
 	if ( portinit[ selport ] == NULL && portinit[ selport ] && openport( portnumbers[ selport ] - 1 ) != 0 ) return;
@@ -2106,14 +2262,17 @@ void outcomsf( char *str )
 	while ( *p )
 	{
 		outcom( *p );
-		t = clock();
-		while ( clock() < t + 100 )
+		d = tgdeadline_ticks( CLOCKS_PER_SEC / 10 );
+		while ( !tgdeadline_passed( d ) )
 		{
-			if ( charin() )
+			if ( ( c = charin() ) > 0 )
 			{
-				c = (byte) ( getbyte() & 0xFF );
+				c = (char) ( getbyte() & 0xFF );
 				if ( c == *p ) break;
 			}
+			else
+				if ( c < 0 ) return;
+				else rxwait( d );
 		}
 		p ++;
 	}
@@ -2122,13 +2281,11 @@ void outcomsf( char *str )
 
 unsigned long outcoms( char *str, unsigned long n )
 {
-	unsigned long	l;
-	
 	if ( portinit[ selport ] == NULL && portinit[ selport ] && openport( portnumbers[ selport ] - 1 ) != 0 ) return( 0 );
 
 	if ( !portinit[ selport ] ) return( 0 );									//	this is a caller error!?!
 
-	return( ( WriteFile( portinit[ selport ], str, (DWORD) n, &l, 0 ) != 0 ) ? l : 0 );
+	return( txwrite( str, (DWORD) n ) );
 }
 
 
@@ -2145,28 +2302,22 @@ void outcoms( char *str, int pacing )
 
 void outcomblock( unsigned char *block, int blocksize )
 {
-	DWORD	bw;
-
 	if ( portinit[ selport ] == NULL && portinit[ selport ] && openport( portnumbers[ selport ] - 1 ) != 0 ) return;
 
 	if ( !portinit[ selport ] ) return;											//	this is a caller error!?!
 
-	WriteFile( portinit[ selport ], block, (DWORD) blocksize, &bw, NULL );
+	txwrite( block, (DWORD) blocksize );
 }
 
 // wait till transmitter is ready
 
 void waitxmitrdy( void )
 {
-	DWORD events = EV_TXEMPTY;
-
-	
 	if ( portinit[ selport ] == NULL && portinit[ selport ] && openport( portnumbers[ selport ] - 1 ) != 0 ) return;
 
 	if ( !portinit[ selport ] ) return;											//	this is a caller error!?!
 
-	SetCommMask( portinit[ selport ], events );
-	WaitCommEvent( portinit[ selport ], &events, NULL );
+	FlushFileBuffers( portinit[ selport ] );									//	10/16/2026 WaitCommEvent() needs an OVERLAPPED on an overlapped handle
 }
 
 
@@ -2184,6 +2335,8 @@ DWORD rstcom( void )
 
 	if ( !ClearCommError( portinit[ selport ], &x, NULL ) ) return( GetLastError() );
 	if ( !PurgeComm( portinit[ selport ], PURGE_TXCLEAR | PURGE_RXCLEAR ) ) return( GetLastError() );
+	ring_discard( &rxring[ selport ] );											//	and what the reader already has
+	rxtaken( selport );
 	return( 0 );
 }
 
@@ -2309,6 +2462,8 @@ void simplecomma( unsigned termcode, bool halfduplex, char *msg, bool autolf )
 
 	while ( c != termcode )
 	{
+		if ( !_kbhit() ) rxwait( tgdeadline_ticks( CLOCKS_PER_SEC / 50 ) );		//	10/16/2026 nap till data, keys are checked every 20 ms
+
 		if ( _kbhit() )
 		{
 			if ( ( c = (unsigned char) _getch() ) )
@@ -2430,7 +2585,7 @@ int getcomsig( int port )
 
 int setcomsig( int newstat )
 {
-	time_t	st = clock();
+	tgdeadline_t	d = tgdeadline_ticks( PDTIMEOUT );
 
 	if ( portinit[ selport ] == NULL && openport( portnumbers[ selport ] - 1 ) != 0 )
 		return( GetLastError() );
@@ -2445,7 +2600,7 @@ int setcomsig( int newstat )
 	else
 		portprams[ selport ].fDtrControl = DTR_CONTROL_DISABLE;
 
-	if ( !SetCommState( portinit[ selport ], &portprams[ selport ] ) || clock() - st > PDTIMEOUT )	//	put them back -- this generates an error if the port has been disconnected
+	if ( !SetCommState( portinit[ selport ], &portprams[ selport ] ) || tgdeadline_passed( d ) )	//	put them back -- this generates an error if the port has been disconnected
 		return( GetLastError() );
 
 	return( 0 );
@@ -2491,15 +2646,15 @@ BOOL sendbreak( int breakon )
 
 BOOL sendbreak_timed( int howlong )
 {
-	clock_t	timer;
+	tgdeadline_t	d;
 	
 	if ( portinit[ selport ] == NULL && openport( portnumbers[ selport ] - 1 ) != 0 ) return( GetLastError() );
 
 	if ( !SetCommBreak( portinit[ selport ] ) ) return( GetLastError() );
 
-	timer = clock();
+	d = tgdeadline_ticks( howlong );
 
-	while ( abs( clock() - timer ) < howlong ) ;
+	Sleep( (DWORD) tgdeadline_ms( d ) );										//	10/16/2026 was a busy loop
 
 	if ( !ClearCommBreak( portinit[ selport ] ) ) return( GetLastError() );
 
@@ -3540,164 +3695,133 @@ HKEY GetDeviceKey( LPTSTR portName )
 
 */
 
-//	Return the number of serial ports, and their COM port numbers.
+//	10/16/2026 -- the hex number after key ("VID_") in a device instance id, 0 if it's not there.
 
-int findserialports( int ports[] )
+static unsigned usbid( const char *id, const char *key )
 {
-	FILE	*z = NULL;
-	char	buf[ 200 ], *p;
-	int		port = 0, numports = 0;
+	const char	*p = stristr( (char *) id, (char *) key );
 
-	system( "mode >x.txt" );
-	if ( ( z = fopen( "x.txt", "rt" ) ) != NULL )
-	{
-		while ( fgets( buf, sizeof( buf ), z ) != NULL )
-		{
-			if ( ( p = strstr( buf, "device COM" ) ) != NULL )
-			{
-				port = atoi( p + 10 );
-				ports[ numports ++ ] = port;
-			}
-		}
-		fclose( z );
-		_unlink( "x.txt" );
-	}
-	return( numports );
+	return( ( p != NULL ) ? strtoul( p + strlen( key ), NULL, 16 ) : 0 );
 }
 
 
-//	10/28/2022-- this function returns one of the fields associated with a serial port:
-//	field can be any of the first headings, letter case doesn't matter:
-//	The file consists of groups of these sections, one for each discovered device.
-
-//	__GENUS: 2
-//	__CLASS : Win32_PnPEntity
-//	__SUPERCLASS : CIM_LogicalDevice
-//	__DYNASTY : CIM_ManagedSystemElement
-//	__RELPATH : Win32_PnPEntity.DeviceID = "FTDIBUS\\VID_0403+PID_6015+D30AOLGYA\\0000"
-//	__PROPERTY_COUNT : 26
-//	__DERIVATION : {CIM_LogicalDevice, CIM_LogicalElement, CIM_ManagedSystemElement}
-//	__SERVER: SCOTT - PC
-//	__NAMESPACE : root\cimv2
-//	__PATH : \\SCOTT - PC\root\cimv2:Win32_PnPEntity.DeviceID = "FTDIBUS\\VID_0403+PID_6015+D30AOLGYA\\0000"
-//	Availability :
-//	Caption : USB Serial Port( COM5 )
-//	ClassGuid : {4d36e978 - e325 - 11ce - bfc1 - 08002be10318}
-//	CompatibleID:
-//	ConfigManagerErrorCode: 0
-//	ConfigManagerUserConfig : False
-//	CreationClassName : Win32_PnPEntity
-//	Description : USB Serial Port
-//	DeviceID : FTDIBUS\VID_0403 + PID_6015 + D30AOLGYA\0000
-//	ErrorCleared                :
-//	ErrorDescription:
-//	HardwareID: { FTDIBUS\COMPORT &VID_0403 &PID_6015 }
-//	InstallDate:
-//	LastErrorCode:
-//	Manufacturer: FTDI
-//	Name : USB Serial Port( COM5 )
-//	PNPClass : Ports
-//	PNPDeviceID : FTDIBUS\VID_0403 + PID_6015 + D30AOLGYA\0000
-//	PowerManagementCapabilities :
-//	PowerManagementSupported:
-//	Present: True
-//	Service : FTSER2K
-//	Status : OK
-//	StatusInfo :
-//	SystemCreationClassName: Win32_ComputerSystem
-//	SystemName : SCOTT - PC
-//	PSComputerName : SCOTT - PC
-
-//	field is the text of the field you're interested in.  Any of the headings above, "classguid" for example.
-//	comport is the port number of the field to return.  5 = COM5 for example.
-//	The function then returns a pointer to this specified field's value.
-//	This function overwrites/erases x.txt!
+//	10/16/2026 -- list up to maxports serial ports that match filter into ports, from the Ports
+//	device class with SetupDi: the COM name is the device key's PortName, the USB ids and serial
+//	number come from its instance id:
+//
+//		FTDIBUS\VID_0403+PID_6015+D30AOLGYA\0000			FTDI driver
+//		USB\VID_2341&PID_0043\75833353035351E01161			CDC-ACM
+//
+//	Replaces running mode and powershell into x.txt, which took seconds.  Returns the number listed.
 
-const char *getportinfo( const char *field, int comport )
+int commenum( commport_t *ports, int maxports, const char *filter )
 {
-	FILE *f;
-	char		buf[ 500 ];
-	static char	rbuf[ 500 ] = "";
-	char *p;
-	bool		inrec = false;
-	int			port = 0, i = 0;
+	HDEVINFO		devs;
+	SP_DEVINFO_DATA	dev;
+	HKEY			key;
+	DWORD			size;
+	commport_t		port;
+	char			name[ 32 ], *p, *q;
+	int				count = 0;
 
-	system( "powershell -WindowStyle Normal -command get-wmiobject win32_pnpentity >x.txt" );
+	if ( ( devs = SetupDiGetClassDevsA( &GUID_DEVCLASS_PORTS, NULL, NULL, DIGCF_PRESENT ) ) == INVALID_HANDLE_VALUE )
+	{
+		TRACE( (char *) "SetupDiGetClassDevs failed\n" );
+		return( 0 );
+	}
 
-	if ( ( f = fopen( "x.txt", "rt" ) ) != NULL && !setvbuf( f, NULL, _IOFBF, 30000 ) )
+	dev.cbSize = sizeof( dev );
+	for ( DWORD i = 0; count < maxports && SetupDiEnumDeviceInfo( devs, i, &dev ); i ++ )
 	{
-		while ( fgets( buf, sizeof( buf ), f ) != NULL )
+		memset( name, 0, sizeof( name ) );
+		if ( ( key = SetupDiOpenDevRegKey( devs, &dev, DICS_FLAG_GLOBAL, 0, DIREG_DEV, KEY_READ ) ) != INVALID_HANDLE_VALUE )
+		{
+			size = sizeof( name ) - 1;
+			if ( RegQueryValueExA( key, "PortName", NULL, NULL, (LPBYTE) name, &size ) != ERROR_SUCCESS ) *name = 0;
+			RegCloseKey( key );
+		}
+		if ( _strnicmp( name, "COM", 3 ) || atoi( name + 3 ) < 1 ) continue;		//	LPT ports are in the class too
+
+		memset( &port, 0, sizeof( port ) );
+		port.comport = atoi( name + 3 );
+		strcpy( port.path, name );
+
+		if ( SetupDiGetDeviceInstanceIdA( devs, &dev, port.id, sizeof( port.id ), NULL ) )
 		{
-			++ i;
-			if ( ( p = strchr( buf, '\n' ) ) != 0 ) *p = 0;						//	delimit lines
+			port.vid = usbid( port.id, "VID_" );
+			port.pid = usbid( port.id, "PID_" );
 
-			if ( *buf )
+			if ( port.pid && ( p = stristr( port.id, (char *) "PID_" ) ) != NULL && ( p[ 8 ] == '+' || p[ 8 ] == '\\' ) )
 			{
-				//	Not a blank line
+				for ( q = port.serial, p += 9; *p && *p != '\\' && *p != '+' && q < port.serial + sizeof( port.serial ) - 1; ) *q ++ = *p ++;
+				*q = 0;
+			}
+		}
 
-				if ( strstr( buf, "Caption" ) == buf )
-				{
-					//	The caption line shows the COM port number
+		SetupDiGetDeviceRegistryPropertyA( devs, &dev, SPDRP_MFG, NULL, (PBYTE) port.manufacturer, sizeof( port.manufacturer ) - 1, NULL );
+		SetupDiGetDeviceRegistryPropertyA( devs, &dev, SPDRP_DEVICEDESC, NULL, (PBYTE) port.product, sizeof( port.product ) - 1, NULL );
 
-					if ( ( p = strstr( buf, "COM" ) ) != NULL && sscanf( p + 3, "%d", &port ) == 1 && port > 0 && port < 256 )
-					{
-						//	This is a valid caption line
+		if ( commenum_match( &port, filter ) ) ports[ count ++ ] = port;
+	}
 
-						if ( port == comport )
-						{
-							//	This record belongs to the port we've been asked to process
-
-							inrec = true;
-
-							if ( *rbuf )
-							{
-								//	If the specified search field preceeds the Caption line,
-								//	rbuf is already set to its value, close the file and return
-								//	the requested info.  Otherwise continue reading with inrec
-								//	true until we find the requested heading.
-found:
-								fclose( f );
-								_unlink( "x.txt" );
-								return( rbuf );
-							}
-						}
-					}
-				}
+	SetupDiDestroyDeviceInfoList( devs );
+	return( count );
+}
 
-				if ( stristr( buf, (char *) field ) == buf )
-				{
-					//	Save the sought field
 
-					if ( ( p = strchr( buf, ':' ) ) != NULL )
-					{
-						strcpy( rbuf, p + 2 );									//	copy the string value
+//	Return the number of serial ports, and their COM port numbers.
 
-						//	If this line contains the requested heading, and we're in the
-						//	record for the requested COM port, then the heading appears
-						//	after the 'Caption' line, and we're done otherwise wait for the
-						//	caption line to know this value applies to the correct port.
+int findserialports( int ports[] )
+{
+	commport_t	list[ MAXCOMMENUM ];
+	int			numports = commenum( list, MAXCOMMENUM, NULL );
 
-						if ( inrec ) goto found;
-					}
-				}
-			}
-			else
-			{
-				//	A blank line signals a new record.
+	for ( int i = 0; ports != NULL && i < numports; i ++ ) ports[ i ] = list[ i ].comport;
+	return( numports );
+}
 
-				inrec = false;													//	we're now in a different record
-				*rbuf = 0;														//	clear any saved value
-				port = 0;														//	and the active COM port
-			}
-		}	//	while fgets()
 
-		fclose( f );
-		_unlink( "x.txt" );
-		return( NULL );															//	didn't find the key for comport
-	}	//	output file found
+//	10/28/2022-- this function returns one of the fields associated with a serial port, as
+//	win32_pnpentity names them, letter case doesn't matter:
+//
+//	Manufacturer: FTDI
+//	Description : USB Serial Port
+//	Caption : USB Serial Port (COM5)									also Name
+//	DeviceID : FTDIBUS\VID_0403+PID_6015+D30AOLGYA\0000					also PNPDeviceID
+//
+//	and SerialNumber, VID and PID.  comport is the port number of the field to return.  5 = COM5
+//	for example.  The function then returns a pointer to this specified field's value, or NULL.
+//	10/16/2026 -- from commenum() rather than a powershell dump into x.txt.
+
+const char *getportinfo( const char *field, int comport )
+{
+	static char	rbuf[ 500 ] = "";
+	commport_t	list[ MAXCOMMENUM ], *port = NULL;
+	int			n = commenum( list, MAXCOMMENUM, NULL );
+
+	for ( int i = 0; i < n && port == NULL; i ++ )
+		if ( list[ i ].comport == comport ) port = &list[ i ];
+
+	if ( port == NULL ) return( NULL );
+
+	if ( !_stricmp( field, "manufacturer" ) )
+		strcpy( rbuf, port -> manufacturer );
+	else if ( !_stricmp( field, "description" ) || !_stricmp( field, "product" ) )
+		strcpy( rbuf, port -> product );
+	else if ( !_stricmp( field, "caption" ) || !_stricmp( field, "name" ) )
+		sprintf( rbuf, "%s (%s)", port -> product, port -> path );
+	else if ( !_stricmp( field, "deviceid" ) || !_stricmp( field, "pnpdeviceid" ) )
+		strcpy( rbuf, port -> id );
+	else if ( !_stricmp( field, "serialnumber" ) )
+		strcpy( rbuf, port -> serial );
+	else if ( !_stricmp( field, "vid" ) && port -> vid )
+		sprintf( rbuf, "%04X", port -> vid );
+	else if ( !_stricmp( field, "pid" ) && port -> pid )
+		sprintf( rbuf, "%04X", port -> pid );
+	else
+		return( NULL );
 
-	printf( "Cannot run powershell\n" );
-	return( NULL );
+	return( ( *rbuf ) ? rbuf : NULL );
 }
 
 
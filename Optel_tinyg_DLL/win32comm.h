@@ -1,4 +1,5 @@
-//#include <windows.h>
+#include "portcompat.h"									//	windows.h, or its POSIX stand-ins
+#include "commenum.h"									//	commport_t
 
 #undef BLOCKIO
 #undef RS232_DIAGS
@@ -34,7 +35,7 @@
 #define	RS232SIGS ( RS232INSIGS | RS232OUTSIGS )			//	all the signals
 
 //extern char		*portsignames[];							//	names of RS-232 port signals in status bit order starting w/0.
-//extern int		selport;									//	selected port index
+//extern int		selport;									//	selected port index (10/16/2026 each thread's own)
 
 int openport( int port );									//	open a manually closed port
 void closeports( void );									// close all open com ports
@@ -75,6 +76,32 @@ BOOL sendbreak_timed( int howlong );						// here's a new easier to use function
 BOOL isconnected( void );									//	true if the current port remains open
 BOOL isconnected( int port );								//	true if port remains open
 
+//	10/16/2026 -- a receive tap sees every block the selected port's reader thread receives, on
+//	that thread and before getbyte() can have any of it, with the ctx it was set with.  It must be
+//	quick and must not call back into this API.  NULL removes it, closing the port removes it.
+
+typedef void (*rxtap_t)( const unsigned char *block, int n, void *ctx );
+void setrxtap( rxtap_t tap, void *ctx );					//	tap the selected port's receive data
+
+//	10/16/2026 -- receive data a block at a time.  readavail() takes what has arrived without
+//	waiting, up to size bytes, with the receive errors (CE_ bits) of the block it came in; it
+//	stops short of the next block with errors.  It returns the bytes, 0 for none or -1 if the
+//	port is gone.  The port forms take a port index, like charin( port ).  rxcounts() says how
+//	many reads the port's reader has made that returned data, and how many bytes they brought.
+
+int readavail( unsigned char *buf, int size, unsigned *errors );				//	from the selected port
+int readavail( int port, unsigned char *buf, int size, unsigned *errors );		//	from a different port
+BOOL rxcounts( int port, unsigned long *reads, unsigned long *bytes );			//	since the port was opened
+
+//	10/16/2026 -- setrxgap(): when the reader gets fewer than bytes bytes and the last doesn't end a
+//	message (CR, LF, ACK or NAK), it waits out the rest of bytes byte times (10 bits at the port's
+//	baud rate) before it reads again, so a reply sent a byte at a time comes in a few reads, not
+//	one per byte.  A message's end is never held back.  0, the default again when the port is
+//	closed, reads each byte as it comes.  On POSIX only: Windows drivers hand ReadFile() what a USB
+//	packet brings, and Sleep() is too coarse to wait out a few byte times.
+
+void setrxgap( int bytes );													//	for the selected port
+
 
 //	Send a command to the port, then input a response into recvbuf (up to maxlen characters incl/null terminator).
 //	The response ends with an ACK (0x06) or NAK (0x15).
@@ -128,8 +155,23 @@ void printproperties( void );
 int getcomports( int *comportlist );
 int findserialports( int ports[] );
 const char *getportinfo( const char *field, int comport );						//	return info about field for comport
+
+//	10/16/2026 -- list up to maxports serial ports matching filter (see commenum.h, NULL for all)
+//	into ports, with their USB ids, serial number, manufacturer and description, in one pass.
+//	Returns the number listed.
+
+int commenum( commport_t *ports, int maxports, const char *filter );
 bool isaserialport( int comnumber );											//	true if comnumber is a serial port
 
+#ifndef	_WIN32
+//	POSIX only (posixcomm.cpp): COM numbers are assigned to device paths as findserialports()
+//	discovers them.  mapport() binds a COM number to any other tty, a pty for example.
+//	Returns 0 or an error value.
+
+int mapport( int comport, const char *path );									//	COM<comport> -> path
+const char *portpath( int comport );											//	device path of COM<comport> or NULL
+#endif
+
 
 //	#define BLOCKIO
 
@@ -26,11 +26,25 @@ private:
 TinyG::TinyG()
 {
     m_Mutex = gcnew System::Threading::Mutex();
+    m_Dev = NULL;
+    printf("TinyG Constructor\n");
+}
+
+// Each instance opened this way has its own board and mutex, so calls on
+// different boards run at the same time.
+TinyG::TinyG(System::String^ id)
+{
+    m_Mutex = gcnew System::Threading::Mutex();
+    marshal_context context;
+    m_Dev = tg_open(context.marshal_as<const char*>(id));
+    if (m_Dev == NULL)
+        throw gcnew System::InvalidOperationException("Can't open TinyG " + id);
     printf("TinyG Constructor\n");
 }
 
 TinyG::~TinyG()
 {
+    tg_close(m_Dev);
     delete m_Mutex;
     printf("TinyG Destructor\n");
 }
@@ -43,12 +57,34 @@ double TinyG::Version()
     return version;
 }
 
+// Motors per board the DLL was built for (4 or 6), the length of the arrays below.
+int TinyG::Axes()
+{
+    return tg_axes();
+}
+
 array<double>^ TinyG::GetPositions()
 {
     scoped_lock lock(m_Mutex);
     printf("GetPositions()\n");
     double positions[MM];
-    tg_getpos(positions);
+    tg_dev_getpos(m_Dev, positions);
+    array<double>^ managedPositions = gcnew array<double>(MM);
+    for (int i = 0; i < MM; i++)
+    {
+        managedPositions[i] = positions[i];
+    }
+
+    return managedPositions;
+}
+
+array<double>^ TinyG::GetPositions(double% ageMs)
+{
+    scoped_lock lock(m_Mutex);
+    double positions[MM];
+    double age = 0.0;
+    tg_dev_getpos_ex(m_Dev, positions, &age);
+    ageMs = age;
     array<double>^ managedPositions = gcnew array<double>(MM);
     for (int i = 0; i < MM; i++)
     {
@@ -67,7 +103,7 @@ bool TinyG::Home(array<bool>^ motors, int timeoutSeconds)
     {
         home[i] = motors[i];
     }
-    bool result = tg_home(home, timeoutSeconds);
+    bool result = tg_dev_home(m_Dev, home, timeoutSeconds);
 
     return result;
 }
@@ -83,17 +119,60 @@ bool TinyG::Move(array<bool>^ motors, array<double>^ positions, int timeoutSecon
         move[i] = motors[i];
         pos[i] = positions[i];
     }
-    bool result = tg_move(move, pos, timeoutSeconds);
+    bool result = tg_dev_move(m_Dev, move, pos, timeoutSeconds);
 
     return result;
 }
 
+// One move over the motors of several boards, see tg_group_move().  Holds every board's
+// mutex while it runs.
+bool TinyG::GroupMove(array<TinyG^>^ boards, array<array<bool>^>^ motors, array<array<double>^>^ positions, int timeoutSeconds)
+{
+    int n = boards->Length;
+    if (n > TG_GROUPMAX)
+        return false;
+
+    printf("GroupMove()\n");
+    tg_target_t targets[TG_GROUPMAX];
+    for (int b = 0; b < n; b++)
+    {
+        // A board named twice would have its mutex taken twice and two waiters on its port
+        for (int c = 0; c < b; c++)
+        {
+            if (boards[c]->m_Dev == boards[b]->m_Dev)
+            {
+                printf("GroupMove: board %d is board %d again\n", b, c);
+                return false;
+            }
+        }
+        targets[b].dev = boards[b]->m_Dev;
+        for (int i = 0; i < MM; i++)
+        {
+            targets[b].move[i] = motors[b][i];
+            targets[b].pos[i] = positions[b][i];
+        }
+    }
+
+    int locked = 0;
+    try
+    {
+        for (; locked < n; locked++)
+            boards[locked]->m_Mutex->WaitOne();
+        return tg_group_move(targets, n, timeoutSeconds, NULL);
+    }
+    finally
+    {
+        while (locked > 0)
+            boards[--locked]->m_Mutex->ReleaseMutex();
+    }
+}
+
 array<TgRange>^ TinyG::GetRanges()
 {
     scoped_lock lock(m_Mutex);
     printf("GetRanges()\n");
     tg_range_t mrange[MM];
-    tg_getranges(mrange);
+    tg_dev_getranges(m_Dev, mrange);
     array<TgRange>^ managedRanges = gcnew array<TgRange>(MM);
     for (int i = 0; i < MM; i++)
     {
@@ -127,4 +206,103 @@ void TinyG::ClosePorts()
     scoped_lock lock(m_Mutex);
     printf("ClosePorts()\n");
     tg_close_ports();
-}
\ No newline at end of file
+}
+
+bool TinyG::ConnectAsync()
+{
+    scoped_lock lock(m_Mutex);
+    printf("ConnectAsync()\n");
+    return tg_connect_async();
+}
+
+// Not under m_Mutex, like Wait().
+int TinyG::ConnectWait(int timeoutSeconds)
+{
+    return tg_connect_wait(timeoutSeconds);
+}
+
+void TinyG::MoveTolerance(double tolerance)
+{
+    scoped_lock lock(m_Mutex);
+    printf("MoveTolerance()\n");
+    tg_move_tolerance(tolerance);
+}
+
+// The round trip timed so far in ms, 0 if there's none yet; waitMs gets the reply wait it gives.
+double TinyG::RoundTrip(double% waitMs)
+{
+    scoped_lock lock(m_Mutex);
+    double rttms = 0.0, waitms = 0.0;
+    printf("RoundTrip()\n");
+    tg_rtt(m_Dev, &rttms, &waitms);
+    waitMs = waitms;
+    return rttms;
+}
+
+void TinyG::HomeCombined(bool on)
+{
+    scoped_lock lock(m_Mutex);
+    printf("HomeCombined()\n");
+    tg_home_combined(on);
+}
+
+bool TinyG::Json(bool on)
+{
+    scoped_lock lock(m_Mutex);
+    printf("Json()\n");
+    return tg_dev_json(m_Dev, on);
+}
+
+bool TinyG::StreamOpen()
+{
+    scoped_lock lock(m_Mutex);
+    printf("StreamOpen()\n");
+    return tg_dev_stream_open(m_Dev);
+}
+
+bool TinyG::StreamPush(System::String^ gcode, int timeoutSeconds)
+{
+    scoped_lock lock(m_Mutex);
+    marshal_context context;
+    const char* nativeGcode = context.marshal_as<const char*>(gcode);
+    return tg_dev_stream_push(m_Dev, nativeGcode, timeoutSeconds);
+}
+
+bool TinyG::StreamDrain(int timeoutSeconds)
+{
+    scoped_lock lock(m_Mutex);
+    printf("StreamDrain()\n");
+    return tg_dev_stream_drain(m_Dev, timeoutSeconds);
+}
+
+int TinyG::MoveAsync(array<bool>^ motors, array<double>^ positions, int timeoutSeconds)
+{
+    scoped_lock lock(m_Mutex);
+    printf("MoveAsync()\n");
+    bool move[MM];
+    double pos[MM];
+    for (int i = 0; i < MM; i++)
+    {
+        move[i] = motors[i];
+        pos[i] = positions[i];
+    }
+    return tg_dev_move_async(m_Dev, move, pos, timeoutSeconds, NULL, NULL);
+}
+
+int TinyG::HomeAsync(array<bool>^ motors, int timeoutSeconds)
+{
+    scoped_lock lock(m_Mutex);
+    printf("HomeAsync()\n");
+    bool home[MM];
+    for (int i = 0; i < MM; i++)
+    {
+        home[i] = motors[i];
+    }
+    return tg_dev_home_async(m_Dev, home, timeoutSeconds, NULL, NULL);
+}
+
+// Not under m_Mutex, so other calls (GetPositions) can be made while one thread waits.
+int TinyG::Wait(int request, int timeoutSeconds)
+{
+    return tg_wait(request, timeoutSeconds);
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include <msclr/marshal.h>
+#include "optel_tinyg_dll.h"
 
 namespace TinyGLib {
 
@@ -13,17 +14,34 @@ namespace TinyGLib {
     {
     public:
         TinyG(); // Constructor
+        TinyG(System::String^ id); // Another board, see tg_open()
         ~TinyG(); // Destructor
         double Version();
+        int Axes();
         array<double>^ GetPositions();
+        array<double>^ GetPositions(double% ageMs);
         bool Home(array<bool>^ motors, int timeoutSeconds);
+        void HomeCombined(bool on);
         bool Move(array<bool>^ motors, array<double>^ positions, int timeoutSeconds);
+        void MoveTolerance(double tolerance);
+        double RoundTrip(double% waitMs);
+        static bool GroupMove(array<TinyG^>^ boards, array<array<bool>^>^ motors, array<array<double>^>^ positions, int timeoutSeconds);
         array<TgRange>^ GetRanges();
         void Comm(System::String^ message);
         bool OpenPorts();
         void ClosePorts();
+        bool ConnectAsync();
+        int ConnectWait(int timeoutSeconds);
+        bool Json(bool on);
+        bool StreamOpen();
+        bool StreamPush(System::String^ gcode, int timeoutSeconds);
+        bool StreamDrain(int timeoutSeconds);
+        int MoveAsync(array<bool>^ motors, array<double>^ positions, int timeoutSeconds);
+        int HomeAsync(array<bool>^ motors, int timeoutSeconds);
+        int Wait(int request, int timeoutSeconds);
 
     private:
         System::Threading::Mutex^ m_Mutex; // Mutex member
+        tg_device* m_Dev; // NULL for the default device
     };
 }
\ No newline at end of file
@@ -0,0 +1,612 @@
+//	==========================================================================================
+//	tgbench: time the TinyG DLL calls end to end against the simulator (tgsim.h) or a real
+//	controller.  Reports wall time per call and the CPU time the calls burned, which shows
+//	how much of a wait is spent spinning.
+//
+//		tgbench [-n count] [-b baud] [-v mm/min] [-H sec/axis] [-s sr sec] [-d latency] [-x n] [-j] [-J] [-c file]
+//
+//	-x has the simulator lose every nth command line, to see what a lost command costs.
+//	-j starts the simulator in JSON mode, -J has the DLL use the JSON protocol (TINYG_JSON=1).
+//	The traffic the simulator sent is kept, and at the end the receive side's line framing
+//	and stristr() are timed on it, the byte loops they replaced against commscan.h.  -c times
+//	them on a capture from elsewhere instead (tgsim -c, or what a real TinyG sent).
+//	The simulator runs in a child process so the CPU times are the DLL's alone.
+//	With TINYG_PORT already set the simulator isn't started and that port is used.
+//	The DLL's own chatter goes to stdout, results to stderr:  tgbench >/dev/null
+// ---------------------------------------------------------------------
+// Rev    Date      By     Description
+// -----  --------  -----  ---------------------------------------------
+//		  10/16/26	DV	   dev_async, futures on the second board (tg_dev_move_future())
+//		  10/16/26	DV	   rx, the bytes the first port's reader gets per read
+//		  10/16/26	DV	   frame and stristr, the old byte loops and commscan.h on captured traffic
+//		  10/16/26	DV	   timeout, how long a 0.5 ms receive timeout really takes
+//		  10/16/26	DV	   -x to lose command lines, the round trip and reply wait the DLL worked out
+//		  10/16/26	DV	   format, the cost of building a move line (tgcmd.h) against its time on the wire
+//		  10/16/26	DV	   group_move, the two boards' moves as one tg_group_move()
+//		  10/16/26	DV	   move_2seq and move_2dev, a second simulator opened with tg_open()
+//		  10/16/26	DV	   connect_async and connect_wait, reconnecting in the background
+//		  10/16/26	DV	   home_all, tg_home() with combined homing
+//		  10/16/26	DV	   coroutines, the move sequence as tasks on one thread
+//		  10/16/26	DV	   async moves, with getpos_ex polled while they run
+//		  10/16/26	DV	   stream, the move sequence through tg_stream_push()
+//		  10/16/26	DV	   getpos_ex
+//		  10/16/26	DV	   -J for the DLL's JSON protocol
+//		  10/16/26	DV	   Original
+//	==========================================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <thread>
+
+#include "../Optel_tinyg_DLL/optel_tinyg_api.h"
+#include "../Optel_tinyg_DLL/win32comm.h"
+#include "../Optel_tinyg_DLL/tgcmd.h"
+#include "../Optel_tinyg_DLL/tg_future.h"
+#include "../Optel_tinyg_DLL/tg_co.h"
+#include "../Optel_tinyg_DLL/commscan.h"
+#include "../Optel_tinyg_DLL/stristr.h"
+#include "tgsim.h"
+
+#define	MAXRUNS		1000
+
+typedef struct
+{
+	const char	*name;
+	int			n, fails;
+	double		wall[ MAXRUNS ];
+	double		cpu;
+} bench_t;
+
+
+static double wallclock( void )
+{
+	struct timespec	ts;
+
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return( ts.tv_sec + ts.tv_nsec * 1e-9 );
+}
+
+
+static double cpuclock( void )
+{
+	struct rusage	ru;
+
+	getrusage( RUSAGE_SELF, &ru );
+	return( ru.ru_utime.tv_sec + ru.ru_stime.tv_sec + ( ru.ru_utime.tv_usec + ru.ru_stime.tv_usec ) * 1e-6 );
+}
+
+
+static int compare( const void *a, const void *b )
+{
+	double	d = *(const double *) a - *(const double *) b;
+
+	return( ( d > 0.0 ) - ( d < 0.0 ) );
+}
+
+
+static void report( bench_t *b )
+{
+	double	sum = 0.0;
+
+	if ( !b -> n ) return;
+
+	qsort( b -> wall, b -> n, sizeof( b -> wall[ 0 ] ), compare );
+	for ( int i = 0; i < b -> n; i ++ ) sum += b -> wall[ i ];
+
+	fprintf( stderr, "%-12s %5d %5d %10.3f %10.3f %10.3f %10.3f %10.3f\n", b -> name, b -> n, b -> fails,
+		b -> wall[ 0 ] * 1e3, b -> wall[ b -> n / 2 ] * 1e3, sum / b -> n * 1e3, b -> wall[ b -> n - 1 ] * 1e3, b -> cpu / b -> n * 1e3 );
+}
+
+
+//	Time one call of fn into b.
+
+#define	TIMEIT( b, call )																\
+	do																					\
+	{																					\
+		double	c0 = cpuclock(), t0 = wallclock();										\
+		if ( !( call ) ) ( b ).fails ++;												\
+		if ( ( b ).n < MAXRUNS ) ( b ).wall[ ( b ).n ++ ] = wallclock() - t0;			\
+		( b ).cpu += cpuclock() - c0;													\
+	}																					\
+	while ( 0 )
+
+
+//	The moves the move benchmark makes, streamed.
+
+static bool streammoves( int runs )
+{
+	char	gcode[ 100 ];
+
+	if ( !tg_stream_open() ) return( false );
+
+	for ( int i = 0; i < runs; i ++ )
+	{
+		sprintf( gcode, "g0 x%.3f y%.3f", ( i & 1 ) ? 10.0 : 20.0, ( i & 1 ) ? 5.0 : 15.0 );
+		if ( !tg_stream_push( gcode, 10 ) ) break;
+	}
+	return( tg_stream_drain( 30 ) );
+}
+
+
+//	A receive timeout of 0.5 ms on the idle port (the one the last call selected): how close
+//	the wait comes to its deadline.  True if it timed out, as it should.
+
+static bool halfms( void )
+{
+	char	buf[ 100 ];
+
+	return( !cmdio( (char *) "", CLOCKS_PER_SEC / 2000, buf, sizeof( buf ), (char *) "\xA", false ) );
+}
+
+
+//	Build n move lines the way tg_move() does.  The length goes to a volatile so none of it is
+//	optimized away.
+
+#define	FORMATS		100000
+
+static bool formatlines( int n )
+{
+	static volatile int	sink;
+	tgcmd_t				c;
+
+	for ( int i = 0; i < n; i ++ )
+	{
+		tgcmd_gcode( &c, false );
+		tgcmd_put( &c, "g0" );
+		tgcmd_axis( &c, 'x', ( i & 1 ) ? 10.0 : 20.0 + i * 0.001 );
+		tgcmd_axis( &c, 'y', ( i & 1 ) ? 5.0 : 15.0 - i * 0.001 );
+		tgcmd_end( &c, false );
+		sink = c.len;
+	}
+	return( tgcmd_ok( &c ) && sink > 0 );
+}
+
+
+//	The receive side's line framing on captured traffic: n bytes of p cut into LF-ended lines,
+//	reps times, the way cmdio() did it (a strchr() of its delimiters per byte) or with
+//	scan_find().  Returns the lines, so the two can be checked against each other.
+
+static long framelines( const unsigned char *p, size_t n, bool scan, int reps )
+{
+	static const char		delims[] = "\n";
+	static volatile size_t	sink;
+	scanset_t				s;
+	char					line[ 512 ];
+	size_t					len, k, m, kept = 0;
+	long					lines = 0;
+
+	scan_set( &s, delims, sizeof( delims ) );									//	LF and NUL, what strchr() matched
+
+	for ( int r = 0; r < reps; r ++ )
+	{
+		len = 0;
+		if ( !scan )
+		{
+			for ( size_t i = 0; i < n; i ++ )
+				if ( strchr( delims, p[ i ] ) != NULL )
+				{
+					kept += len + line[ 0 ];
+					lines ++;
+					len = 0;
+				}
+				else
+					if ( len < sizeof( line ) - 1 ) line[ len ++ ] = (char) p[ i ];
+		}
+		else
+			for ( size_t i = 0; i < n; i = k + 1 )
+			{
+				k = i + scan_find( &s, p + i, n - i );
+				m = ( k - i < sizeof( line ) - 1 - len ) ? k - i : sizeof( line ) - 1 - len;
+				memcpy( line + len, p + i, m );
+				len += m;
+				if ( k < n )
+				{
+					kept += len + line[ 0 ];
+					lines ++;
+					len = 0;
+				}
+			}
+	}
+	sink = kept;																//	so the copies aren't optimized away
+	return( ( sink == kept ) ? lines : -1 );
+}
+
+
+//	The stristr() the DLL had, which backed up over src after each partial match.
+
+static char *stristr_loop( char *src, char *dst )
+{
+	char	*p1, *p2, *p;
+
+	if ( src == NULL || dst == NULL ) return( NULL );
+	if ( !*src ) return( ( *src == *dst ) ? src : NULL );
+	if ( !*dst ) return( src );
+
+	p = p1 = src;
+	p2 = dst;
+	do
+	{
+		if ( toupper( *p1 ) == toupper( *p2 ) )
+		{
+			p1 ++;
+			p2 ++;
+			if ( !*p2 ) return( p );
+			if ( !*p1 ) return( NULL );
+		}
+		else
+		{
+			p1 -= ( p2 - dst );
+			p1 ++;
+			p2 = dst;
+			p = p1;
+		}
+	}
+	while ( *p );
+	return( NULL );
+}
+
+
+//	Look for word in each of the lines (NUL separated in n bytes of p), reps times, with the old
+//	loop or stristr().  Returns the lines it's in.
+
+static long searchlines( char *p, size_t n, const char *word, bool loop, int reps )
+{
+	long	found = 0;
+	char	*q;
+
+	for ( int r = 0; r < reps; r ++ )
+		for ( q = p; q < p + n; q += strlen( q ) + 1 )
+			if ( *q && ( ( loop ) ? stristr_loop( q, (char *) word ) : stristr( q, (char *) word ) ) != NULL ) found ++;
+	return( found );
+}
+
+
+//	Time both on a capture.  Each runs over about 32 MB so the clock's resolution doesn't matter.
+
+#define	SCANBYTES	( 32 << 20 )
+
+static void scancapture( const char *name )
+{
+	FILE			*f;
+	unsigned char	*p;
+	char			*text;
+	long			n, lines[ 2 ], found[ 2 ], count = 0;
+	double			t[ 4 ];
+	int				reps;
+
+	if ( ( f = fopen( name, "rb" ) ) == NULL || fseek( f, 0, SEEK_END ) || ( n = ftell( f ) ) <= 0 || fseek( f, 0, SEEK_SET )
+			|| ( p = (unsigned char *) malloc( n ) ) == NULL )
+	{
+		if ( f != NULL ) fclose( f );
+		fprintf( stderr, "No traffic in %s\n", name );
+		return;
+	}
+	n = (long) fread( p, 1, n, f );
+	fclose( f );
+
+	reps = ( n < SCANBYTES ) ? SCANBYTES / n : 1;
+
+	t[ 0 ] = wallclock();
+	lines[ 0 ] = framelines( p, n, false, reps );
+	t[ 1 ] = wallclock();
+	lines[ 1 ] = framelines( p, n, true, reps );
+	t[ 2 ] = wallclock();
+
+	fprintf( stderr, "%-12s %.0f MB/s a strchr() per byte, %.0f MB/s scan_find() (%s), %ld lines in %ld bytes%s\n", "frame",
+		(double) n * reps / ( t[ 1 ] - t[ 0 ] ) / 1e6, (double) n * reps / ( t[ 2 ] - t[ 1 ] ) / 1e6,
+#if	defined( SCAN_AVX2 )
+		"avx2",
+#elif	defined( SCAN_SSE2 )
+		"sse2",
+#else
+		"bytes",
+#endif
+		lines[ 0 ] / reps, n, ( lines[ 0 ] != lines[ 1 ] ) ? ", NOT THE SAME" : "" );
+
+	//	The lines as strings, for stristr()
+
+	if ( ( text = (char *) malloc( n + 1 ) ) != NULL )
+	{
+		for ( long i = 0; i < n; i ++ )
+		{
+			text[ i ] = ( p[ i ] == '\r' || p[ i ] == '\n' ) ? 0 : (char) p[ i ];
+			if ( text[ i ] && ( i == 0 || !text[ i - 1 ] ) ) count ++;
+		}
+		text[ n ] = 0;
+
+		t[ 0 ] = wallclock();
+		found[ 0 ] = searchlines( text, n, "POSX", true, reps );
+		t[ 1 ] = wallclock();
+		found[ 1 ] = searchlines( text, n, "POSX", false, reps );
+		t[ 2 ] = wallclock();
+
+		if ( count )
+			fprintf( stderr, "%-12s %.0f ns per line the old loop, %.0f ns stristr(), POSX in %ld of %ld lines%s\n", "stristr",
+				( t[ 1 ] - t[ 0 ] ) * 1e9 / ( (double) count * reps ), ( t[ 2 ] - t[ 1 ] ) * 1e9 / ( (double) count * reps ),
+				found[ 0 ] / reps, count, ( found[ 0 ] != found[ 1 ] ) ? ", NOT THE SAME" : "" );
+		free( text );
+	}
+	free( p );
+}
+
+
+//	The moves the move benchmark makes, one task per move, all resumed by one loop on this thread.
+//	Each task reads the snapshot after its move.
+
+static int	cofails;
+
+static tg::task comove( int i )
+{
+	bool	move[ MM ] = { true, true, false, false };
+	double	pos[ MM ] = { ( i & 1 ) ? 10.0 : 20.0, ( i & 1 ) ? 5.0 : 15.0, 0.0, 0.0 };
+
+	if ( !co_await tg::move( move, pos, 10 ) || !( co_await tg::position() ).ok ) cofails ++;
+}
+
+
+static bool comoves( int runs )
+{
+	tg::loop	l;
+
+	cofails = 0;
+	for ( int i = 0; i < runs; i ++ ) l.spawn( comove( i ) );
+	l.run();
+	return( cofails == 0 );
+}
+
+
+//	Move the default device and dev, one after the other or both at once (on two threads).
+
+static bool twomoves( tg_device *dev, int i, bool together )
+{
+	bool	move[ MM ] = { true, true, false, false }, ok0 = false, ok1;
+	double	pos[ MM ] = { ( i & 1 ) ? 10.0 : 20.0, ( i & 1 ) ? 5.0 : 15.0, 0.0, 0.0 };
+
+	if ( !together ) return( tg_move( move, pos, 10 ) && tg_dev_move( dev, move, pos, 10 ) );
+
+	std::thread	t( [ & ] { ok0 = tg_move( move, pos, 10 ); } );
+	ok1 = tg_dev_move( dev, move, pos, 10 );
+	t.join();
+	return( ok0 && ok1 );
+}
+
+
+//	The same moves as one group move.  The worst release skew goes in *skewms.
+
+static bool groupmove( tg_device *dev, int i, double *skewms )
+{
+	tg_target_t	t[ 2 ] = { { NULL, { true, true, false, false } }, { dev, { true, true, false, false } } };
+	double		skew = 0.0;
+	bool		ok;
+
+	for ( int k = 0; k < 2; k ++ )
+	{
+		t[ k ].pos[ 0 ] = ( i & 1 ) ? 10.0 : 20.0;
+		t[ k ].pos[ 1 ] = ( i & 1 ) ? 5.0 : 15.0;
+	}
+	ok = tg_group_move( t, 2, 10, &skew );
+	if ( skew > *skewms ) *skewms = skew;
+	return( ok );
+}
+
+
+//	Start the simulator in a child process.  Returns its pid (path gets the pty) or -1.
+
+static pid_t simulator( tgsim_config_t *cfg, char *path, size_t pathsize )
+{
+	int		fds[ 2 ];
+	pid_t	pid;
+	ssize_t	n;
+
+	if ( pipe( fds ) ) return( -1 );
+
+	if ( ( pid = fork() ) == 0 )
+	{
+		tgsim_t	*sim;
+
+		close( fds[ 0 ] );
+		if ( ( sim = tgsim_start( cfg, path, pathsize ) ) == NULL ) _exit( 1 );
+		if ( write( fds[ 1 ], path, strlen( path ) + 1 ) < 0 ) _exit( 1 );
+		close( fds[ 1 ] );
+		pause();																//	till we're killed
+		tgsim_stop( sim );
+		_exit( 0 );
+	}
+
+	close( fds[ 1 ] );
+	n = ( pid > 0 ) ? read( fds[ 0 ], path, pathsize - 1 ) : 0;
+	close( fds[ 0 ] );
+
+	if ( n <= 0 )
+	{
+		if ( pid > 0 ) waitpid( pid, NULL, 0 );
+		return( -1 );
+	}
+	path[ n ] = 0;
+	return( pid );
+}
+
+
+int main( int argc, char *argv[] )
+{
+	tgsim_config_t	cfg;
+	pid_t			sim = -1, sim2 = -1;
+	char			path[ 100 ], path2[ 100 ], capture[ 64 ] = "";
+	const char		*traffic = NULL;
+	tg_device		*dev;
+	int				c, runs = 20, id;
+	long			polls = 0;
+	unsigned long	reads, bytes;
+	double			pos[ MM ], age, skewms = 0.0, rttms, waitms;
+	tg_range_t		ranges[ MM ];
+	bool			move[ MM ] = { true, true, false, false }, home[ MM ] = { true, true, true, true };
+	static bench_t	open = { "open" }, getpos = { "getpos" }, getposex = { "getpos_ex" }, getranges = { "getranges" }, moves = { "move" }, streamed = { "stream" }, asyncs = { "move_async" }, futures = { "move_future" }, coroutines = { "coroutines" }, twoseq = { "move_2seq" }, twodev = { "move_2dev" }, groups = { "group_move" }, devasyncs = { "dev_async" }, formats = { "format" }, timeouts = { "timeout" }, homes = { "home" }, homealls = { "home_all" }, connects = { "connect_async" }, connwaits = { "connect_wait" };
+
+	tgsim_defaults( &cfg );
+
+	while ( ( c = getopt( argc, argv, "n:b:v:H:s:d:x:jJc:h" ) ) != -1 )
+	{
+		switch ( c )
+		{
+		case 'n':	runs = atoi( optarg );				break;
+		case 'b':	cfg.baud = atol( optarg );			break;
+		case 'v':	cfg.velocity = atof( optarg );		break;
+		case 'H':	cfg.hometime = atof( optarg );		break;
+		case 's':	cfg.srinterval = atof( optarg );	break;
+		case 'd':	cfg.latency = atof( optarg );		break;
+		case 'x':	cfg.drop = atoi( optarg );			break;
+		case 'j':	cfg.json = true;					break;
+		case 'J':	setenv( "TINYG_JSON", "1", 1 );		break;
+		case 'c':	traffic = optarg;					break;
+		default:
+			fprintf( stderr, "usage: tgbench [-n count] [-b baud] [-v mm/min] [-H sec/axis] [-s sr sec] [-d latency sec] [-x n] [-j] [-J] [-c file]\n" );
+			return( c != 'h' );
+		}
+	}
+
+	if ( runs < 1 || runs > MAXRUNS ) runs = MAXRUNS;
+
+	if ( getenv( "TINYG_PORT" ) == NULL )
+	{
+		//	Keep what it sends for the framing times at the end
+
+		if ( traffic == NULL )
+		{
+			int		fd;
+
+			snprintf( capture, sizeof( capture ), "/tmp/tgbench.XXXXXX" );
+			if ( ( fd = mkstemp( capture ) ) >= 0 )
+			{
+				close( fd );
+				cfg.capture = traffic = capture;
+			}
+		}
+
+		if ( ( sim = simulator( &cfg, path, sizeof( path ) ) ) < 0 )
+		{
+			if ( *capture ) unlink( capture );
+			return( 1 );
+		}
+		cfg.capture = NULL;
+		setenv( "TINYG_PORT", path, 1 );
+		fprintf( stderr, "simulator on %s, %ld baud, %.0f mm/min\n", path, cfg.baud, cfg.velocity );
+	}
+
+	TIMEIT( open, tg_open_ports() );
+	if ( open.fails )
+	{
+		fprintf( stderr, "Can't open %s\n", getenv( "TINYG_PORT" ) );
+		if ( sim > 0 ) kill( sim, SIGTERM );
+		if ( *capture ) unlink( capture );
+		return( 1 );
+	}
+
+	for ( int i = 0; i < runs; i ++ ) TIMEIT( getpos, tg_getpos( pos ) );
+	for ( int i = 0; i < runs; i ++ ) TIMEIT( getposex, tg_getpos_ex( pos, &age ) );
+	for ( int i = 0; i < runs; i ++ ) TIMEIT( getranges, tg_getranges( ranges ) );
+	for ( int i = 0; i < runs; i ++ ) TIMEIT( timeouts, halfms() );
+
+	for ( int i = 0; i < runs; i ++ )
+	{
+		pos[ 0 ] = ( i & 1 ) ? 10.0 : 20.0;
+		pos[ 1 ] = ( i & 1 ) ? 5.0 : 15.0;
+		TIMEIT( moves, tg_move( move, pos, 10 ) );
+	}
+
+	TIMEIT( homes, tg_home( home, 30 ) );
+	tg_home_combined( true );
+	TIMEIT( homealls, tg_home( home, 30 ) );
+	tg_home_combined( false );
+	TIMEIT( streamed, streammoves( runs ) );
+
+	//	The caller's thread is free while an async move runs
+
+	for ( int i = 0; i < runs; i ++ )
+	{
+		pos[ 0 ] = ( i & 1 ) ? 10.0 : 20.0;
+		pos[ 1 ] = ( i & 1 ) ? 5.0 : 15.0;
+		TIMEIT( asyncs, ( id = tg_move_async( move, pos, 10, NULL, NULL ) ) != 0 );
+		while ( tg_wait( id, 0 ) == TG_PENDING ) polls += tg_getpos_ex( pos, NULL );
+	}
+	pos[ 0 ] = pos[ 1 ] = 0.0;
+	TIMEIT( futures, tg_move_future( move, pos, 10 ).get() );
+	TIMEIT( coroutines, comoves( runs ) );
+
+	//	A second board: the same moves on both, one after the other and at once
+
+	if ( sim > 0 && ( sim2 = simulator( &cfg, path2, sizeof( path2 ) ) ) > 0 )
+	{
+		if ( ( dev = tg_open( path2 ) ) != NULL )
+		{
+			for ( int i = 0; i < runs; i ++ ) TIMEIT( twoseq, twomoves( dev, i, false ) );
+			for ( int i = 0; i < runs; i ++ ) TIMEIT( twodev, twomoves( dev, i, true ) );
+			for ( int i = 0; i < runs; i ++ ) TIMEIT( groups, groupmove( dev, i, &skewms ) );
+			for ( int i = 0; i < runs; i ++ )
+			{
+				pos[ 0 ] = ( i & 1 ) ? 10.0 : 20.0;
+				pos[ 1 ] = ( i & 1 ) ? 5.0 : 15.0;
+				TIMEIT( devasyncs, tg_dev_move_future( dev, move, pos, 10 ).get() );
+			}
+			tg_close( dev );
+		}
+		else
+			fprintf( stderr, "Can't open the second simulator %s\n", path2 );
+	}
+
+	fprintf( stderr, "\n%-12s %5s %5s %10s %10s %10s %10s %10s\n", "call", "runs", "fails", "min ms", "median ms", "mean ms", "max ms", "cpu ms" );
+	report( &open );
+	report( &getpos );
+	report( &getposex );
+	report( &getranges );
+	report( &timeouts );
+	report( &moves );
+	report( &homes );
+	report( &homealls );
+	report( &streamed );
+	report( &asyncs );
+	report( &futures );
+	report( &coroutines );
+	report( &twoseq );
+	report( &twodev );
+	report( &groups );
+	report( &devasyncs );
+	TIMEIT( formats, formatlines( FORMATS ) );
+	fprintf( stderr, "%-12s %.0f ns per move line, %.0f ns on the wire\n", "format", formats.wall[ 0 ] * 1e9 / FORMATS, ( cfg.baud > 0 ) ? 19 * 10 * 1e9 / cfg.baud : 0.0 );
+	if ( streamed.n ) fprintf( stderr, "%-12s %.3f ms per move\n", "stream", streamed.wall[ 0 ] * 1e3 / runs );
+	if ( coroutines.n ) fprintf( stderr, "%-12s %.3f ms per move\n", "coroutines", coroutines.wall[ 0 ] * 1e3 / runs );
+	if ( groups.n ) fprintf( stderr, "%-12s %.3f ms worst release skew\n", "group_move", skewms );
+	if ( tg_rtt( NULL, &rttms, &waitms ) ) fprintf( stderr, "%-12s %.3f ms round trip, %.3f ms reply wait\n", "rtt", rttms, waitms );
+	if ( asyncs.n ) fprintf( stderr, "%-12s %ld getpos_ex calls during %d moves\n", "move_async", polls, asyncs.n );
+	if ( rxcounts( 0, &reads, &bytes ) && reads ) fprintf( stderr, "%-12s %lu bytes in %lu reads, %.1f bytes a read\n", "rx", bytes, reads, (double) bytes / reads );
+
+	//	Reconnect in the background: how long the caller is held, and how long till it's connected
+
+	tg_close_ports();
+	TIMEIT( connects, tg_connect_async() );
+	TIMEIT( connwaits, tg_connect_wait( 30 ) == 1 );
+	report( &connects );
+	report( &connwaits );
+
+	tg_close_ports();
+	if ( sim2 > 0 )
+	{
+		kill( sim2, SIGTERM );
+		waitpid( sim2, NULL, 0 );
+	}
+	if ( sim > 0 )
+	{
+		kill( sim, SIGTERM );
+		waitpid( sim, NULL, 0 );
+	}
+
+	if ( traffic != NULL ) scancapture( traffic );
+	if ( *capture ) unlink( capture );
+	return( 0 );
+}
@@ -0,0 +1,910 @@
+//	==========================================================================================
+//	TinyG firmware simulator, see tgsim.h.
+//
+//	One thread per simulator runs an event loop on the pty master: command lines are queued
+//	with a due time (latency plus the time the line spent on the wire), moves go through a
+//	planner queue like the firmware's, and replies and status reports are queued and then
+//	written a byte time apart.
+//
+//	In JSON mode each command gets one {"r":{...},"f":[1,status,bytes,checksum]} line.  JSON
+//	commands are single name/value objects: {"gc":"g0 x10"}, {"pos":null}, {"xtn":null}, {"ej":0}...
+// ---------------------------------------------------------------------
+// Rev    Date      By     Description
+// -----  --------  -----  ---------------------------------------------
+//		  10/16/26	DV	   cfg.capture keeps a copy of the traffic sent
+//		  10/16/26	DV	   cfg.drop loses every nth command line
+//		  10/16/26	DV	   Six axes with TG_AXES=6 (b and c in reports, moves and the ? report)
+//		  10/16/26	DV	   $fb firmware build
+//		  10/16/26	DV	   $qv queue reports, $qr
+//		  10/16/26	DV	   $sv and $si status report settings
+//		  10/16/26	DV	   JSON commands, responses with a checksummed footer
+//		  10/16/26	DV	   Original
+//	==========================================================================================
+
+#ifndef	_GNU_SOURCE
+#define	_GNU_SOURCE																//	ppoll()
+#endif
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <poll.h>
+#include <pthread.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "tgsim.h"
+
+#define	PLANNER			28														//	planner buffers, like the firmware
+#define	PENDING			32														//	command lines waiting for their due time
+#define	OUTSIZE			65536													//	transmit queue
+
+#define	BUILD			440.20													//	firmware build reported by $fb
+
+#define	STAT_STOP		3
+#define	STAT_RUN		5
+#define	STAT_HOMING		9
+
+static const char	axisname[ TGSIM_AXES ] = { 'x', 'y', 'z', 'a',
+#if	TGSIM_AXES > 4
+	'b', 'c'
+#endif
+};
+
+typedef struct
+{
+	bool	home;																//	g28.2 rather than a move
+	bool	axes[ TGSIM_AXES ];													//	axes named in the command
+	double	target[ TGSIM_AXES ];
+	double	rate;																//	mm/min
+} tgsim_block_t;
+
+struct tgsim
+{
+	tgsim_config_t	cfg;
+	int				master;
+	int				slave;														//	held open so the master doesn't see a hang up when the DLL closes the port
+	int				wake[ 2 ];													//	tgsim_stop() writes here
+	int				capture;													//	cfg.capture, -1 if there isn't one
+	pthread_t		thread;
+
+	//	Receive
+
+	char			line[ 256 ];
+	int				linelen;
+	bool			lastcr;														//	eat the LF of a CR/LF
+	long			lines;														//	command lines received, for cfg.drop
+	struct
+	{
+		char		text[ 256 ];
+		double		due;
+	}				pending[ PENDING ];
+	int				phead, pcount;
+
+	//	Transmit
+
+	char			out[ OUTSIZE ];
+	size_t			outhead, outtail;
+	double			txnext;														//	when the next byte may go out
+	double			bytetime;
+
+	//	Machine
+
+	bool			json;
+	int				sv;															//	status reports, 0 off, 1 filtered, 2 verbose
+	int				qv;															//	queue reports, 0 off
+	int				cmdlen;														//	bytes in the command being answered, for the footer
+	char			echo[ 300 ];												//	JSON response body for the ok reply, {"gc":...} echoes the gcode
+	double			feed;														//	last F word
+	double			pos[ TGSIM_AXES ];
+	double			travel[ TGSIM_AXES ][ 2 ];
+	int				stat;
+	double			vel;
+
+	tgsim_block_t	planner[ PLANNER ];
+	int				bhead, bcount;
+	bool			running;													//	planner[ bhead ] is being executed
+	double			bstart[ TGSIM_AXES ];										//	where it started
+	double			bt0, bduration;												//	when it started, how long it takes
+	double			nextsr;
+
+	double			reported[ TGSIM_AXES ];										//	last reported values, for filtered reports
+	double			repvel;
+	int				repstat;
+};
+
+
+static double now( void )
+{
+	struct timespec	ts;
+
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return( ts.tv_sec + ts.tv_nsec * 1e-9 );
+}
+
+
+void tgsim_defaults( tgsim_config_t *cfg )
+{
+	memset( cfg, 0, sizeof( *cfg ) );
+	cfg -> baud = 115200;
+	cfg -> velocity = 6000.0;
+	cfg -> hometime = 1.0;
+	cfg -> srinterval = 0.25;
+	cfg -> latency = 0.002;
+
+	for ( int i = 0; i < TGSIM_AXES; i ++ )
+	{
+		cfg -> travelmin[ i ] = 0.0;
+		cfg -> travelmax[ i ] = ( i >= 3 ) ? 360.0 : 200.0;
+	}
+}
+
+
+//	Queue output.
+
+static void emit( tgsim_t *sim, const char *fmt, ... )
+{
+	char	buf[ 1024 ];
+	va_list	args;
+	int		n;
+
+	va_start( args, fmt );
+	n = vsnprintf( buf, sizeof( buf ), fmt, args );
+	va_end( args );
+
+	if ( n <= 0 ) return;
+	if ( n >= (int) sizeof( buf ) ) n = sizeof( buf ) - 1;
+
+	if ( sim -> outhead == sim -> outtail )
+	{
+		sim -> outhead = sim -> outtail = 0;
+		if ( sim -> txnext < now() ) sim -> txnext = now();						//	the line was idle
+	}
+
+	if ( sim -> outtail + n > OUTSIZE )
+	{
+		memmove( sim -> out, sim -> out + sim -> outhead, sim -> outtail - sim -> outhead );
+		sim -> outtail -= sim -> outhead;
+		sim -> outhead = 0;
+	}
+
+	if ( sim -> outtail + n > OUTSIZE )
+	{
+		fprintf( stderr, "tgsim: transmit queue full\n" );
+		return;
+	}
+
+	memcpy( sim -> out + sim -> outtail, buf, n );
+	sim -> outtail += n;
+
+	if ( sim -> cfg.trace ) fprintf( stderr, "<- %.*s", n, buf );
+}
+
+
+//	JSON response to the current command, the footer's checksum is the firmware's compute_checksum()
+//	of everything before its last comma.
+
+static void respond( tgsim_t *sim, int status, const char *fmt, ... )
+{
+	char		buf[ 900 ];
+	va_list		args;
+	uint32_t	h = 0;
+	int			n;
+
+	n = sprintf( buf, "{\"r\":{" );
+	va_start( args, fmt );
+	n += vsnprintf( buf + n, sizeof( buf ) - 100 - n, fmt, args );
+	va_end( args );
+	n += sprintf( buf + n, "},\"f\":[1,%d,%d", status, sim -> cmdlen );
+
+	for ( int i = 0; i < n; i ++ ) h = 31 * h + (unsigned char) buf[ i ];
+	emit( sim, "%s,%u]}\n", buf, (unsigned) ( h % 9999 ) );
+}
+
+
+static void prompt( tgsim_t *sim )
+{
+	if ( sim -> json )
+		respond( sim, 0, "%s", sim -> echo );
+	else
+		emit( sim, "tinyg [mm] ok> \n" );
+}
+
+
+static void error( tgsim_t *sim, int code, const char *msg, const char *cmd )
+{
+	if ( sim -> json )
+		respond( sim, code, "\"msg\":\"%s\"", msg );
+	else
+		emit( sim, "tinyg [mm] err: %s: %s\n", msg, cmd );
+}
+
+
+//	Status report values, what changed since the last report unless all.  stat is always included.
+
+static void srvalues( tgsim_t *sim, char *buf, bool all )
+{
+	char	*p = buf;
+
+	*p = 0;
+
+	for ( int i = 0; i < TGSIM_AXES; i ++ )
+	{
+		if ( all || fabs( sim -> pos[ i ] - sim -> reported[ i ] ) >= 0.0005 )
+		{
+			p += sprintf( p, ( sim -> json ) ? "\"pos%c\":%.3f," : "pos%c:%.3f,", axisname[ i ], sim -> pos[ i ] );
+			sim -> reported[ i ] = sim -> pos[ i ];
+		}
+	}
+
+	if ( all || fabs( sim -> vel - sim -> repvel ) >= 0.0005 )
+	{
+		p += sprintf( p, ( sim -> json ) ? "\"vel\":%.3f," : "vel:%.3f,", sim -> vel );
+		sim -> repvel = sim -> vel;
+	}
+
+	sprintf( p, ( sim -> json ) ? "\"stat\":%d" : "stat:%d", sim -> stat );
+	sim -> repstat = sim -> stat;
+}
+
+
+static void statusreport( tgsim_t *sim )
+{
+	char	buf[ 300 ];
+
+	if ( !sim -> sv ) return;
+	srvalues( sim, buf, sim -> sv > 1 );
+
+	if ( sim -> json )
+		emit( sim, "{\"sr\":{%s}}\n", buf );
+	else
+		emit( sim, "%s\n", buf );
+}
+
+
+//	Queue report: planner buffers free, sent whenever that changes while $qv is on.
+
+static void queuereport( tgsim_t *sim )
+{
+	if ( !sim -> qv ) return;
+
+	if ( sim -> json )
+		emit( sim, "{\"qr\":%d}\n", PLANNER - sim -> bcount );
+	else
+		emit( sim, "qr:%d\n", PLANNER - sim -> bcount );
+}
+
+
+//	Advance the planner to time t.
+
+static void motion( tgsim_t *sim, double t )
+{
+	tgsim_block_t	*b;
+	double			start = t, f, d;
+
+	while ( sim -> running || sim -> bcount )
+	{
+		b = &sim -> planner[ sim -> bhead ];
+
+		if ( !sim -> running )
+		{
+			//	Start the next block where the last one ended
+
+			memcpy( sim -> bstart, sim -> pos, sizeof( sim -> pos ) );
+			sim -> bt0 = start;
+			d = 0.0;
+
+			if ( b -> home )
+			{
+				for ( int i = 0; i < TGSIM_AXES; i ++ ) if ( b -> axes[ i ] ) d += sim -> cfg.hometime;
+				sim -> bduration = d;
+				sim -> stat = STAT_HOMING;
+				sim -> vel = 0.0;
+			}
+			else
+			{
+				for ( int i = 0; i < TGSIM_AXES; i ++ )
+					if ( b -> axes[ i ] ) d += ( b -> target[ i ] - sim -> pos[ i ] ) * ( b -> target[ i ] - sim -> pos[ i ] );
+				sim -> bduration = sqrt( d ) / b -> rate * 60.0;
+				sim -> stat = STAT_RUN;
+				sim -> vel = b -> rate;
+			}
+
+			if ( sim -> repstat == STAT_STOP ) sim -> nextsr = start + sim -> cfg.srinterval;
+			sim -> running = true;
+		}
+
+		if ( t - sim -> bt0 >= sim -> bduration )
+		{
+			//	Block done
+
+			for ( int i = 0; i < TGSIM_AXES; i ++ ) if ( b -> axes[ i ] ) sim -> pos[ i ] = b -> target[ i ];
+			start = sim -> bt0 + sim -> bduration;
+			sim -> running = false;
+			sim -> bhead = ( sim -> bhead + 1 ) % PLANNER;
+			sim -> bcount --;
+			queuereport( sim );
+			continue;
+		}
+
+		f = ( t - sim -> bt0 ) / sim -> bduration;
+		for ( int i = 0; i < TGSIM_AXES; i ++ )
+			if ( b -> axes[ i ] ) sim -> pos[ i ] = sim -> bstart[ i ] + ( b -> target[ i ] - sim -> bstart[ i ] ) * f;
+		break;
+	}
+
+	if ( !sim -> running && sim -> stat != STAT_STOP )
+	{
+		sim -> stat = STAT_STOP;
+		sim -> vel = 0.0;
+		statusreport( sim );
+	}
+	else
+		if ( sim -> running && t >= sim -> nextsr )
+		{
+			statusreport( sim );
+			while ( sim -> nextsr <= t ) sim -> nextsr += sim -> cfg.srinterval;
+		}
+}
+
+
+//	Queue a move or homing block.  Returns false if the planner is full.
+
+static bool plan( tgsim_t *sim, tgsim_block_t *b )
+{
+	if ( sim -> bcount >= PLANNER ) return( false );
+
+	sim -> planner[ ( sim -> bhead + sim -> bcount ) % PLANNER ] = *b;
+	sim -> bcount ++;
+	queuereport( sim );
+	return( true );
+}
+
+
+//	The ? report.
+
+static void positionreport( tgsim_t *sim )
+{
+	static const char	*state[ 10 ] = { "Initializing", "Ready", "Alarm", "Stop", "End", "Run", "Hold", "Probe", "Cycle", "Homing" };
+	char				buf[ 300 ];
+
+	if ( sim -> json )
+	{
+		//	The firmware answers ? with a full status report in JSON mode
+
+		srvalues( sim, buf, true );
+		emit( sim, "{\"sr\":{%s}}\n", buf );
+		return;
+	}
+
+	for ( int i = 0; i < TGSIM_AXES; i ++ )
+		emit( sim, "%c position:%15.3f %s\n", toupper( axisname[ i ] ), sim -> pos[ i ], ( i < 3 ) ? "mm" : "deg" );
+	emit( sim, "Feed rate:%16.3f mm/min\n", sim -> feed );
+	emit( sim, "Velocity:%17.3f mm/min\n", sim -> vel );
+	emit( sim, "Units:           G21 - millimeter mode\n" );
+	emit( sim, "Coordinate system:  G54 - coordinate system 1\n" );
+	emit( sim, "Distance mode:      G90 - absolute distance mode\n" );
+	emit( sim, "Feed rate mode:     G94 - units-per-minute mode (i.e. feedrate mode)\n" );
+	emit( sim, "Machine state:      %s\n", state[ sim -> stat ] );
+	prompt( sim );
+}
+
+
+//	$ commands: $xtn, $xtm.. (travel), $ej, $sv, $si, $qv, $qr, $fb and anything else as a stored number.
+
+static void setting( tgsim_t *sim, char *cmd )
+{
+	static const char	*limit[ 2 ] = { "minimum", "maximum" };
+	char				*v = strchr( cmd, '=' ), name[ 16 ];
+	const char			*axis;
+	double				x;
+
+	if ( v != NULL ) *v ++ = 0;
+	snprintf( name, sizeof( name ), "%s", cmd + 1 );
+
+	if ( strlen( name ) == 3 && name[ 1 ] == 't' && ( name[ 2 ] == 'n' || name[ 2 ] == 'm' )
+			&& ( axis = (const char *) memchr( axisname, name[ 0 ], TGSIM_AXES ) ) != NULL )
+	{
+		int	a = (int) ( axis - axisname ), m = ( name[ 2 ] == 'm' );
+
+		if ( v != NULL )
+		{
+			if ( sscanf( v, "%lf", &x ) != 1 )
+			{
+				error( sim, 103, "Bad number format", v );
+				return;
+			}
+			sim -> travel[ a ][ m ] = x;
+		}
+
+		if ( sim -> json )
+			respond( sim, 0, "\"%s\":%.3f", name, sim -> travel[ a ][ m ] );
+		else
+		{
+			emit( sim, "[%s] %c travel %s%16.3f mm\n", name, name[ 0 ], limit[ m ], sim -> travel[ a ][ m ] );
+			prompt( sim );
+		}
+		return;
+	}
+
+	if ( !strcmp( name, "ej" ) )
+	{
+		if ( v != NULL ) sim -> json = atoi( v ) != 0;
+		if ( sim -> json )
+			respond( sim, 0, "\"ej\":1" );
+		else
+		{
+			emit( sim, "[ej]  enable json mode%14d [0=text,1=JSON]\n", 0 );
+			prompt( sim );
+		}
+		return;
+	}
+
+	if ( !strcmp( name, "sv" ) || !strcmp( name, "si" ) )
+	{
+		bool	sv = ( name[ 1 ] == 'v' );
+
+		if ( v != NULL )
+		{
+			if ( sv )
+				sim -> sv = atoi( v );
+			else
+				if ( atoi( v ) >= 50 ) sim -> cfg.srinterval = atoi( v ) / 1000.0;
+		}
+
+		x = ( sv ) ? sim -> sv : sim -> cfg.srinterval * 1000.0;
+		if ( sim -> json )
+			respond( sim, 0, "\"%s\":%d", name, (int) x );
+		else
+		{
+			if ( sv )
+				emit( sim, "[sv]  status report verbosity%6d [0=off,1=filtered,2=verbose]\n", (int) x );
+			else
+				emit( sim, "[si]  status interval%14d ms\n", (int) x );
+			prompt( sim );
+		}
+		return;
+	}
+
+	if ( !strcmp( name, "qv" ) )
+	{
+		if ( v != NULL ) sim -> qv = atoi( v );
+		if ( sim -> json )
+			respond( sim, 0, "\"qv\":%d", sim -> qv );
+		else
+		{
+			emit( sim, "[qv]  queue report verbosity%7d [0=off,1=single,2=triple]\n", sim -> qv );
+			prompt( sim );
+		}
+		return;
+	}
+
+	if ( !strcmp( name, "fb" ) )
+	{
+		if ( sim -> json )
+			respond( sim, 0, "\"fb\":%.2f", BUILD );
+		else
+		{
+			emit( sim, "[fb]  firmware build%18.2f\n", BUILD );
+			prompt( sim );
+		}
+		return;
+	}
+
+	if ( !strcmp( name, "qr" ) )
+	{
+		//	Text mode answers like a queue report
+
+		if ( sim -> json )
+			respond( sim, 0, "\"qr\":%d", PLANNER - sim -> bcount );
+		else
+		{
+			emit( sim, "qr:%d\n", PLANNER - sim -> bcount );
+			prompt( sim );
+		}
+		return;
+	}
+
+	//	Settings we don't model are accepted and echoed
+
+	x = ( v != NULL ) ? atof( v ) : 0.0;
+	if ( sim -> json )
+		respond( sim, 0, "\"%s\":%.3f", name, x );
+	else
+	{
+		emit( sim, "[%s] %.3f\n", name, x );
+		prompt( sim );
+	}
+}
+
+
+//	g0, g1 and g28.2 lines, other G and M codes are accepted and ignored.
+
+static void gcode( tgsim_t *sim, char *cmd )
+{
+	tgsim_block_t	b;
+	char			*p = cmd, *e;
+	double			g = -1.0, x;
+	const char		*a;
+
+	memset( &b, 0, sizeof( b ) );
+
+	while ( *p )
+	{
+		while ( *p == ' ' ) p ++;
+		if ( !*p ) break;
+
+		x = strtod( p + 1, &e );
+		if ( e == p + 1 )
+		{
+			error( sim, 103, "Bad number format", cmd );
+			return;
+		}
+
+		if ( *p == 'g' && g < 0.0 )
+			g = x;
+		else
+			if ( *p == 'f' )
+				sim -> feed = x;
+			else
+				if ( ( a = (const char *) memchr( axisname, *p, TGSIM_AXES ) ) != NULL )
+				{
+					b.axes[ a - axisname ] = true;
+					b.target[ a - axisname ] = x;
+				}
+		p = e;
+	}
+
+	if ( fabs( g ) < 0.01 || fabs( g - 1.0 ) < 0.01 )
+	{
+		//	Targets are absolute (G90), axes that aren't named stay put
+
+		b.rate = ( fabs( g ) < 0.01 || sim -> feed <= 0.0 ) ? sim -> cfg.velocity : sim -> feed;
+
+		if ( !plan( sim, &b ) )
+		{
+			error( sim, 150, "Planner buffer full", cmd );
+			return;
+		}
+	}
+	else
+		if ( fabs( g - 28.2 ) < 0.01 )
+		{
+			b.home = true;
+			for ( int i = 0; i < TGSIM_AXES; i ++ ) b.target[ i ] = 0.0;
+
+			if ( !plan( sim, &b ) )
+			{
+				error( sim, 150, "Planner buffer full", cmd );
+				return;
+			}
+		}
+
+	prompt( sim );
+}
+
+
+//	{"name":value} commands.  Settings are answered like their $ forms, "gc" runs its gcode.
+
+static void jsoncommand( tgsim_t *sim, char *cmd )
+{
+	char	*name, *v, *e, buf[ 300 ];
+
+	if ( ( name = strchr( cmd, '"' ) ) == NULL || ( e = strchr( ++ name, '"' ) ) == NULL || ( v = strchr( e, ':' ) ) == NULL )
+	{
+		error( sim, 108, "JSON syntax error", cmd );
+		return;
+	}
+	*e = 0;
+
+	//	The value, unquoted and without the closing brace
+
+	for ( v ++; *v == ' '; v ++ ) ;
+	if ( *v == '"' )
+	{
+		if ( ( e = strchr( ++ v, '"' ) ) != NULL ) *e = 0;
+	}
+	else
+	{
+		for ( e = v; *e && *e != '}' && *e != ',' && *e != ' '; e ++ ) ;
+		*e = 0;
+	}
+
+	if ( !strcmp( name, "gc" ) )
+	{
+		snprintf( sim -> echo, sizeof( sim -> echo ), "\"gc\":\"%s\"", v );
+		gcode( sim, v );
+		return;
+	}
+
+	if ( !strcmp( name, "pos" ) )
+	{
+		respond( sim, 0, "\"pos\":{\"x\":%.3f,\"y\":%.3f,\"z\":%.3f,\"a\":%.3f}", sim -> pos[ 0 ], sim -> pos[ 1 ], sim -> pos[ 2 ], sim -> pos[ 3 ] );
+		return;
+	}
+
+	if ( !strcmp( name, "sr" ) )
+	{
+		srvalues( sim, buf, true );
+		respond( sim, 0, "\"sr\":{%s}", buf );
+		return;
+	}
+
+	if ( !strcmp( name, "qr" ) )
+	{
+		respond( sim, 0, "\"qr\":%d", PLANNER - sim -> bcount );
+		return;
+	}
+
+	if ( !*v || !strcmp( v, "null" ) || !strcmp( v, "n" ) )
+		snprintf( buf, sizeof( buf ), "$%s", name );
+	else
+		snprintf( buf, sizeof( buf ), "$%s=%s", name, v );
+	setting( sim, buf );
+}
+
+
+//	Execute one command line.
+
+static void command( tgsim_t *sim, char *cmd )
+{
+	char	*p, *q;
+
+	if ( sim -> cfg.trace ) fprintf( stderr, "-> %s\n", cmd );
+
+	sim -> cmdlen = (int) strlen( cmd ) + 1;
+	*sim -> echo = 0;
+
+	//	Lower case without spaces at either end, like the firmware's normalization
+
+	for ( p = cmd; *p; p ++ ) *p = (char) tolower( (unsigned char) *p );
+	for ( p = cmd; *p == ' ' || *p == '\t'; p ++ ) ;
+	for ( q = p + strlen( p ); q > p && ( q[ -1 ] == ' ' || q[ -1 ] == '\t' ); ) *-- q = 0;
+
+	if ( !*p )
+	{
+		prompt( sim );
+		return;
+	}
+
+	if ( !strcmp( p, "?" ) )
+	{
+		positionreport( sim );
+		return;
+	}
+
+	switch ( *p )
+	{
+	case '{':
+		jsoncommand( sim, p );
+		return;
+
+	case '$':
+		setting( sim, p );
+		return;
+
+	case 'g':
+	case 'm':
+	case 'n':
+		gcode( sim, ( *p == 'n' ) ? p + strcspn( p, " " ) : p );
+		return;
+
+	default:
+		error( sim, 100, "Unrecognized command", p );
+	}
+}
+
+
+//	Received bytes -> command lines.
+
+static void receive( tgsim_t *sim, const char *buf, int n, double t )
+{
+	for ( int i = 0; i < n; i ++ )
+	{
+		char	c = buf[ i ];
+
+		if ( c == '\n' && sim -> lastcr )
+		{
+			sim -> lastcr = false;
+			continue;
+		}
+		sim -> lastcr = ( c == '\r' );
+
+		if ( c == '\r' || c == '\n' )
+		{
+			sim -> line[ sim -> linelen ] = 0;
+
+			if ( sim -> cfg.drop > 0 && ++ sim -> lines % sim -> cfg.drop == 0 )
+			{
+				if ( sim -> cfg.trace ) fprintf( stderr, "tgsim: lost %s\n", sim -> line );
+			}
+			else if ( sim -> pcount < PENDING )
+			{
+				int	k = ( sim -> phead + sim -> pcount ++ ) % PENDING;
+
+				strcpy( sim -> pending[ k ].text, sim -> line );
+				sim -> pending[ k ].due = t + sim -> cfg.latency + ( sim -> linelen + 1 ) * sim -> bytetime;
+			}
+			else
+				fprintf( stderr, "tgsim: receive queue full, dropped %s\n", sim -> line );
+
+			sim -> linelen = 0;
+		}
+		else
+			if ( sim -> linelen < (int) sizeof( sim -> line ) - 1 )
+				sim -> line[ sim -> linelen ++ ] = c;
+	}
+}
+
+
+//	Write the bytes that are due.
+
+static void transmit( tgsim_t *sim, double t )
+{
+	size_t	n = sim -> outtail - sim -> outhead;
+	ssize_t	l;
+
+	if ( !n ) return;
+
+	if ( sim -> bytetime > 0.0 )
+	{
+		if ( t < sim -> txnext ) return;
+		if ( (size_t) ( ( t - sim -> txnext ) / sim -> bytetime ) + 1 < n ) n = (size_t) ( ( t - sim -> txnext ) / sim -> bytetime ) + 1;
+	}
+
+	if ( ( l = write( sim -> master, sim -> out + sim -> outhead, n ) ) > 0 )
+	{
+		if ( sim -> capture >= 0 && write( sim -> capture, sim -> out + sim -> outhead, l ) != l )
+		{
+			perror( "tgsim: capture" );
+			close( sim -> capture );
+			sim -> capture = -1;
+		}
+		sim -> outhead += l;
+		sim -> txnext += l * sim -> bytetime;
+	}
+}
+
+
+static void *simulate( void *arg )
+{
+	tgsim_t			*sim = (tgsim_t *) arg;
+	struct pollfd	pfd[ 2 ];
+	struct timespec	ts;
+	char			buf[ 512 ];
+	double			t, next;
+	ssize_t			n;
+
+	while ( true )
+	{
+		t = now();
+
+		while ( sim -> pcount && sim -> pending[ sim -> phead ].due <= t )
+		{
+			command( sim, sim -> pending[ sim -> phead ].text );
+			sim -> phead = ( sim -> phead + 1 ) % PENDING;
+			sim -> pcount --;
+		}
+
+		motion( sim, t );
+		transmit( sim, t );
+
+		//	Sleep till the next thing to do
+
+		next = t + 1.0;
+		if ( sim -> pcount && sim -> pending[ sim -> phead ].due < next ) next = sim -> pending[ sim -> phead ].due;
+		if ( sim -> running )
+		{
+			if ( sim -> nextsr < next ) next = sim -> nextsr;
+			if ( sim -> bt0 + sim -> bduration < next ) next = sim -> bt0 + sim -> bduration;
+		}
+		if ( sim -> outtail != sim -> outhead && sim -> txnext < next ) next = sim -> txnext;
+
+		next -= now();
+		if ( next < 0.0 ) next = 0.0;
+		ts.tv_sec = (time_t) next;
+		ts.tv_nsec = (long) ( ( next - ts.tv_sec ) * 1e9 );
+
+		pfd[ 0 ].fd = sim -> master;
+		pfd[ 0 ].events = POLLIN;
+		pfd[ 1 ].fd = sim -> wake[ 0 ];
+		pfd[ 1 ].events = POLLIN;
+
+		if ( ppoll( pfd, 2, &ts, NULL ) < 0 && errno != EINTR ) break;
+
+		if ( pfd[ 1 ].revents ) break;
+
+		if ( pfd[ 0 ].revents & POLLIN )
+		{
+			if ( ( n = read( sim -> master, buf, sizeof( buf ) ) ) > 0 )
+				receive( sim, buf, (int) n, now() );
+		}
+	}
+	return( NULL );
+}
+
+
+tgsim_t *tgsim_start( const tgsim_config_t *cfg, char *path, size_t pathsize )
+{
+	tgsim_t			*sim;
+	struct termios	t;
+	const char		*name;
+
+	if ( ( sim = (tgsim_t *) calloc( 1, sizeof( tgsim_t ) ) ) == NULL ) return( NULL );
+
+	sim -> cfg = *cfg;
+	sim -> capture = -1;
+	sim -> json = cfg -> json;
+	sim -> sv = 1;
+	sim -> stat = sim -> repstat = STAT_STOP;
+	sim -> bytetime = ( cfg -> baud > 0 ) ? 10.0 / cfg -> baud : 0.0;
+	for ( int i = 0; i < TGSIM_AXES; i ++ )
+	{
+		sim -> travel[ i ][ 0 ] = cfg -> travelmin[ i ];
+		sim -> travel[ i ][ 1 ] = cfg -> travelmax[ i ];
+	}
+
+	if ( ( sim -> master = posix_openpt( O_RDWR | O_NOCTTY | O_NONBLOCK ) ) < 0
+			|| grantpt( sim -> master ) || unlockpt( sim -> master ) || ( name = ptsname( sim -> master ) ) == NULL )
+	{
+		perror( "tgsim: pty" );
+		if ( sim -> master >= 0 ) close( sim -> master );
+		free( sim );
+		return( NULL );
+	}
+
+	if ( ( sim -> slave = open( name, O_RDWR | O_NOCTTY ) ) < 0 || pipe( sim -> wake ) )
+	{
+		perror( "tgsim: pty" );
+		if ( sim -> slave >= 0 ) close( sim -> slave );
+		close( sim -> master );
+		free( sim );
+		return( NULL );
+	}
+
+	if ( cfg -> capture != NULL && ( sim -> capture = open( cfg -> capture, O_WRONLY | O_CREAT | O_TRUNC, 0644 ) ) < 0 )
+		perror( cfg -> capture );
+
+	//	Raw until the DLL configures it, no echo
+
+	tcgetattr( sim -> slave, &t );
+	cfmakeraw( &t );
+	tcsetattr( sim -> slave, TCSANOW, &t );
+
+	if ( path != NULL ) snprintf( path, pathsize, "%s", name );
+
+	if ( pthread_create( &sim -> thread, NULL, simulate, sim ) )
+	{
+		if ( sim -> capture >= 0 ) close( sim -> capture );
+		close( sim -> wake[ 0 ] );
+		close( sim -> wake[ 1 ] );
+		close( sim -> slave );
+		close( sim -> master );
+		free( sim );
+		return( NULL );
+	}
+	return( sim );
+}
+
+
+void tgsim_stop( tgsim_t *sim )
+{
+	if ( sim == NULL ) return;
+
+	if ( write( sim -> wake[ 1 ], "", 1 ) != 1 ) perror( "tgsim" );
+	pthread_join( sim -> thread, NULL );
+
+	close( sim -> wake[ 0 ] );
+	close( sim -> wake[ 1 ] );
+	close( sim -> slave );
+	close( sim -> master );
+	if ( sim -> capture >= 0 ) close( sim -> capture );
+	free( sim );
+}
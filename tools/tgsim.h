@@ -0,0 +1,47 @@
+//	==========================================================================================
+//	TinyG firmware simulator.  Creates a pty and answers on it the way a TinyG V8 running
+//	text mode does for the commands the Optel TinyG DLL sends: the ? report, g0/g1 moves
+//	and g28.2 homing with their status reports, $ settings ($xtn, $xtm, $ej, ...) and the
+//	"tinyg [mm] ok>" prompt.  Output is paced at the configured baud rate and motion takes
+//	real time, so the DLL can be timed end to end without hardware.
+//
+//	POSIX only.  Point the DLL at the simulator with TINYG_PORT=<slave path>.
+// ---------------------------------------------------------------------
+// Rev    Date      By     Description
+// -----  --------  -----  ---------------------------------------------
+//		  10/16/26	DV	   capture, a copy of everything sent
+//		  10/16/26	DV	   drop, lose every nth command line
+//		  10/16/26	DV	   Six axes (xyzabc) when built with TG_AXES=6, like the DLL
+//		  10/16/26	DV	   Original
+//	==========================================================================================
+
+#pragma once
+
+#include <stddef.h>
+
+#if	defined( TG_AXES ) && TG_AXES == 6
+#define	TGSIM_AXES		6														//	x, y, z, a, b, c
+#else
+#define	TGSIM_AXES		4														//	x, y, z, a
+#endif
+
+typedef struct
+{
+	long	baud;																//	bytes are paced at 10 bits each, 0 for no pacing
+	double	velocity;															//	g0 traverse rate, mm/min
+	double	hometime;															//	seconds to home one axis
+	double	srinterval;															//	seconds between status reports while moving
+	double	latency;															//	seconds from the end of a command line to its reply
+	int		drop;																//	lose every drop'th command line, 0 for none
+	bool	json;																//	start in JSON mode ($ej=1)
+	bool	trace;																//	print the conversation on stderr
+	const char	*capture;														//	file that gets everything sent, NULL for none
+	double	travelmin[ TGSIM_AXES ];											//	$xtn.. values
+	double	travelmax[ TGSIM_AXES ];											//	$xtm.. values
+} tgsim_config_t;
+
+typedef struct tgsim tgsim_t;
+
+void tgsim_defaults( tgsim_config_t *cfg );										//	115200 baud, 6000 mm/min, 0.25s reports...
+tgsim_t *tgsim_start( const tgsim_config_t *cfg, char *path, size_t pathsize );	//	start a simulator, path gets the pty's slave name, NULL on error
+void tgsim_stop( tgsim_t *sim );												//	stop it and release the pty
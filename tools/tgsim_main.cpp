@@ -0,0 +1,105 @@
+//	==========================================================================================
+//	tgsim: run the TinyG simulator as a process.  Prints the pty to use, e.g.
+//
+//		tgsim -b 115200 -l /tmp/tinyg &
+//		TINYG_PORT=/tmp/tinyg ./my_tinyg_app
+//
+//	and runs until interrupted.
+// ---------------------------------------------------------------------
+// Rev    Date      By     Description
+// -----  --------  -----  ---------------------------------------------
+//		  10/16/26	DV	   -c, capture what's sent to a file
+//		  10/16/26	DV	   -x, lose every nth command line
+//		  10/16/26	DV	   Original
+//	==========================================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include "tgsim.h"
+
+static volatile sig_atomic_t	quit = 0;
+
+static void stop( int )
+{
+	quit = 1;
+}
+
+
+static void usage( void )
+{
+	printf( "usage: tgsim [-b baud] [-v mm/min] [-H sec/axis] [-s sr sec] [-d latency sec] [-x n] [-j] [-t] [-l link] [-c file]\n"
+			"  -b  baud rate the replies are paced at, 0 for none (115200)\n"
+			"  -v  g0 traverse rate (6000 mm/min)\n"
+			"  -H  homing time per axis (1 s)\n"
+			"  -s  status report interval while moving (0.25 s)\n"
+			"  -d  command to reply latency (0.002 s)\n"
+			"  -x  lose every nth command line (0, none)\n"
+			"  -j  start in JSON mode\n"
+			"  -t  trace the conversation on stderr\n"
+			"  -l  make link a symbolic link to the pty\n"
+			"  -c  copy everything sent to file, traffic for tgbench -c\n" );
+}
+
+
+int main( int argc, char *argv[] )
+{
+	tgsim_config_t	cfg;
+	tgsim_t			*sim;
+	const char		*link = NULL;
+	char			path[ 100 ];
+	int				c;
+
+	tgsim_defaults( &cfg );
+
+	while ( ( c = getopt( argc, argv, "b:v:H:s:d:x:jtl:c:h" ) ) != -1 )
+	{
+		switch ( c )
+		{
+		case 'b':	cfg.baud = atol( optarg );			break;
+		case 'v':	cfg.velocity = atof( optarg );		break;
+		case 'H':	cfg.hometime = atof( optarg );		break;
+		case 's':	cfg.srinterval = atof( optarg );	break;
+		case 'd':	cfg.latency = atof( optarg );		break;
+		case 'x':	cfg.drop = atoi( optarg );			break;
+		case 'j':	cfg.json = true;					break;
+		case 't':	cfg.trace = true;					break;
+		case 'l':	link = optarg;						break;
+		case 'c':	cfg.capture = optarg;				break;
+		default:
+			usage();
+			return( c != 'h' );
+		}
+	}
+
+	if ( cfg.velocity <= 0.0 || cfg.srinterval <= 0.0 )
+	{
+		usage();
+		return( 1 );
+	}
+
+	if ( ( sim = tgsim_start( &cfg, path, sizeof( path ) ) ) == NULL ) return( 1 );
+
+	if ( link != NULL )
+	{
+		unlink( link );
+		if ( symlink( path, link ) )
+		{
+			perror( link );
+			link = NULL;
+		}
+	}
+
+	printf( "%s\n", path );
+	fflush( stdout );
+
+	signal( SIGINT, stop );
+	signal( SIGTERM, stop );
+	while ( !quit ) pause();
+
+	tgsim_stop( sim );
+	if ( link != NULL ) unlink( link );
+	return( 0 );
+}